@@ -2,14 +2,10 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 //
-// Although file declares three template classes, you're only likely to use
-// PartialDS directly. It builds upon the other two classes:
-//
-// PartialDSListItem: This is a utility template class, parameterized with
-// class Item. It augments Item with next/previous pointers, effectively adding
-// double-list capability. A crucial characteristic of PartialDSItemList is that
-// an iterator in the d-list can also be used as a handle to Item. It is used
-// to build lists of vertices, edges and faces that can easily be iterated over.
+// Although file declares two template classes, you're only likely to use
+// PartialDS directly. It builds upon PartialDSTypes, and upon one of the
+// storage policies in partialdsstorage.h, which decides where the entities
+// live and what their handles are:
 //
 // PartialDSTypes: Although it is a class, it is effectively used as a wrapper
 // around all the types used in the partial-entity data structure. For instance
@@ -30,38 +26,16 @@
 #define GINSU_GEOMETRY_CGAL_EXT_PARTIALDS_H_
 
 #include <cassert>
+#include <algorithm>
+#include <vector>
 #include "CGAL/basic.h"
-#include "CGAL/In_place_list.h"
-#include "CGAL/memory.h"
 #include "geometry/cgal_ext/partialdsitems.h"
+#include "geometry/cgal_ext/partialdsproperties.h"
+#include "geometry/cgal_ext/partialdsstorage.h"
 
 namespace ginsu {
 namespace geometry {
 
-// PartialDSListItem: This template class relies on cgal's In_place_list and
-// multiple-inheritance to add d-link pointers to the Item class. As such, it
-// allows an iterator into the d-list to also act as an Item handle (i.e. a
-// pointer to Item). 
-// Template parameter:
-// - Item: The item type that needs to be inserted into a doubly-linked list,
-//   most likely a vertex, edge, face, etc.
-template <class Item>
-class PartialDSListItem : 
-    public Item,
-    public CGAL::In_place_list_base<PartialDSListItem<Item> > {
- public:
-  typedef PartialDSListItem<Item> Self;
-    
-  PartialDSListItem() {}
-  explicit PartialDSListItem(const Item& v) : Item(v) {}
-
-  // Assignment operator: copy item data without affecting the dlist pointers.
-  Self& operator=(const Self& v) {
-    *(static_cast<Item*>(this)) = ((const Item&)v);
-    return *this;
-  }
-};
-
 // PartialDSTypes encapsulates all the types used by the Partial DS. It doesn't
 // have any code or data. It is used by other template classes every time you
 // see a template named TypeRefs.
@@ -70,27 +44,32 @@ class PartialDSListItem :
 //   partial-entity DS is built upon.
 // - ItemsType: declares wrappers for all the types, vertex, edge, etc, used to
 //   construct the partial-entity DS.
-template <class TraitsType, class ItemsType>
+// - StorageType: the storage policy, see partialdsstorage.h.
+template <class TraitsType, class ItemsType,
+          class StorageType = PartialDSListStorage>
 class PartialDSTypes {
  public:
-  typedef PartialDSTypes<TraitsType, ItemsType> Self;
+  typedef PartialDSTypes<TraitsType, ItemsType,
+                         StorageType>           Self;
   typedef TraitsType                            Traits;
   typedef ItemsType                             Items;
+  typedef StorageType                           Storage;
 
   // Make the Entity class conveniently accessible.
   typedef typename Items::template
       EntityWrapper<Self>                       EntityWrapper;
   typedef typename EntityWrapper::Entity        Entity;
 
-  // We keep all vertices in a list to easily iterate over them. A vertex
-  // handle is also an iterator into that list.
+  // We keep all vertices in a container, a list by default, to easily iterate
+  // over them. A vertex handle is also an iterator into that container.
   typedef typename Items::template
       VertexWrapper<Self, Traits>               VertexWrapper;
   typedef typename VertexWrapper::Vertex        VertexBase;
-  typedef PartialDSListItem<VertexBase>         Vertex;
-  typedef CGAL_ALLOCATOR(Vertex)                VertexAllocator;
-  typedef CGAL::In_place_list<Vertex, false,
-                              VertexAllocator>  VertexList;
+  typedef typename Storage::template
+      Container<VertexBase>                     VertexContainer;
+  typedef typename VertexContainer::Value       Vertex;
+  typedef typename VertexContainer::Allocator   VertexAllocator;
+  typedef typename VertexContainer::List        VertexList;
   typedef typename VertexList::iterator         VertexIterator;
   typedef typename VertexList::const_iterator   VertexConstIterator;
   typedef VertexIterator                        VertexHandle;
@@ -100,10 +79,11 @@ class PartialDSTypes {
   typedef typename Items::template
       PVertexWrapper<Self, Traits>              PVertexWrapper;
   typedef typename PVertexWrapper::PVertex      PVertexBase;
-  typedef PartialDSListItem<PVertexBase>        PVertex;
-  typedef CGAL_ALLOCATOR(PVertex)               PVertexAllocator;
-  typedef CGAL::In_place_list<PVertex, false,
-                              PVertexAllocator> PVertexList;
+  typedef typename Storage::template
+      Container<PVertexBase>                    PVertexContainer;
+  typedef typename PVertexContainer::Value      PVertex;
+  typedef typename PVertexContainer::Allocator  PVertexAllocator;
+  typedef typename PVertexContainer::List       PVertexList;
   typedef typename PVertexList::iterator        PVertexIterator;
   typedef typename PVertexList::const_iterator  PVertexConstIterator;
   typedef PVertexIterator                       PVertexHandle;
@@ -113,10 +93,11 @@ class PartialDSTypes {
   typedef typename Items::template
       EdgeWrapper<Self, Traits>                 EdgeWrapper;
   typedef typename EdgeWrapper::Edge            EdgeBase;
-  typedef PartialDSListItem<EdgeBase>           Edge;
-  typedef CGAL_ALLOCATOR(Edge)                  EdgeAllocator;
-  typedef CGAL::In_place_list<Edge, false,
-                              EdgeAllocator>    EdgeList;
+  typedef typename Storage::template
+      Container<EdgeBase>                       EdgeContainer;
+  typedef typename EdgeContainer::Value         Edge;
+  typedef typename EdgeContainer::Allocator     EdgeAllocator;
+  typedef typename EdgeContainer::List          EdgeList;
   typedef typename EdgeList::iterator           EdgeIterator;
   typedef typename EdgeList::const_iterator     EdgeConstIterator;
   typedef EdgeIterator                          EdgeHandle;
@@ -125,10 +106,11 @@ class PartialDSTypes {
   typedef typename Items::template
       PEdgeWrapper<Self, Traits>                PEdgeWrapper;
   typedef typename PEdgeWrapper::PEdge          PEdgeBase;
-  typedef PartialDSListItem<PEdgeBase>          PEdge;
-  typedef CGAL_ALLOCATOR(PEdge)                 PEdgeAllocator;
-  typedef CGAL::In_place_list<PEdge, false,
-                              PEdgeAllocator>   PEdgeList;
+  typedef typename Storage::template
+      Container<PEdgeBase>                      PEdgeContainer;
+  typedef typename PEdgeContainer::Value        PEdge;
+  typedef typename PEdgeContainer::Allocator    PEdgeAllocator;
+  typedef typename PEdgeContainer::List         PEdgeList;
   typedef typename PEdgeList::iterator          PEdgeIterator;
   typedef typename PEdgeList::const_iterator    PEdgeConstIterator;
   typedef PEdgeIterator                         PEdgeHandle;
@@ -138,10 +120,11 @@ class PartialDSTypes {
   typedef typename Items::template
       LoopWrapper<Self, Traits>                 LoopWrapper;
   typedef typename LoopWrapper::Loop            LoopBase;
-  typedef PartialDSListItem<LoopBase>           Loop;
-  typedef CGAL_ALLOCATOR(Loop)                  LoopAllocator;
-  typedef CGAL::In_place_list<Loop, false,
-                              LoopAllocator>    LoopList;
+  typedef typename Storage::template
+      Container<LoopBase>                       LoopContainer;
+  typedef typename LoopContainer::Value         Loop;
+  typedef typename LoopContainer::Allocator     LoopAllocator;
+  typedef typename LoopContainer::List          LoopList;
   typedef typename LoopList::iterator           LoopIterator;
   typedef typename LoopList::const_iterator     LoopConstIterator;
   typedef LoopIterator                          LoopHandle;
@@ -151,10 +134,11 @@ class PartialDSTypes {
   typedef typename Items::template
       FaceWrapper<Self, Traits>                 FaceWrapper;
   typedef typename FaceWrapper::Face            FaceBase;
-  typedef PartialDSListItem<FaceBase>           Face;
-  typedef CGAL_ALLOCATOR(Face)                  FaceAllocator;
-  typedef CGAL::In_place_list<Face, false,
-                              FaceAllocator>    FaceList;
+  typedef typename Storage::template
+      Container<FaceBase>                       FaceContainer;
+  typedef typename FaceContainer::Value         Face;
+  typedef typename FaceContainer::Allocator     FaceAllocator;
+  typedef typename FaceContainer::List          FaceList;
   typedef typename FaceList::iterator           FaceIterator;
   typedef typename FaceList::const_iterator     FaceConstIterator;
   typedef FaceIterator                          FaceHandle;
@@ -163,10 +147,11 @@ class PartialDSTypes {
   typedef typename Items::template
       PFaceWrapper<Self, Traits>                PFaceWrapper;
   typedef typename PFaceWrapper::PFace          PFaceBase;
-  typedef PartialDSListItem<PFaceBase>          PFace;
-  typedef CGAL_ALLOCATOR(PFace)                 PFaceAllocator;
-  typedef CGAL::In_place_list<PFace, false,
-                              PFaceAllocator>   PFaceList;
+  typedef typename Storage::template
+      Container<PFaceBase>                      PFaceContainer;
+  typedef typename PFaceContainer::Value        PFace;
+  typedef typename PFaceContainer::Allocator    PFaceAllocator;
+  typedef typename PFaceContainer::List         PFaceList;
   typedef typename PFaceList::iterator          PFaceIterator;
   typedef typename PFaceList::const_iterator    PFaceConstIterator;
   typedef PFaceIterator                         PFaceHandle;
@@ -176,10 +161,11 @@ class PartialDSTypes {
   typedef typename Items::template
       ShellWrapper<Self, Traits>                ShellWrapper;
   typedef typename ShellWrapper::Shell          ShellBase;
-  typedef PartialDSListItem<ShellBase>          Shell;
-  typedef CGAL_ALLOCATOR(Shell)                 ShellAllocator;
-  typedef CGAL::In_place_list<Shell, false,
-                              ShellAllocator>   ShellList;
+  typedef typename Storage::template
+      Container<ShellBase>                      ShellContainer;
+  typedef typename ShellContainer::Value        Shell;
+  typedef typename ShellContainer::Allocator    ShellAllocator;
+  typedef typename ShellContainer::List         ShellList;
   typedef typename ShellList::iterator          ShellIterator;
   typedef typename ShellList::const_iterator    ShellConstIterator;
   typedef ShellIterator                         ShellHandle;
@@ -189,10 +175,11 @@ class PartialDSTypes {
   typedef typename Items::template
       RegionWrapper<Self, Traits>               RegionWrapper;
   typedef typename RegionWrapper::Region        RegionBase;
-  typedef PartialDSListItem<RegionBase>         Region;
-  typedef CGAL_ALLOCATOR(Region)                RegionAllocator;
-  typedef CGAL::In_place_list<Region, false,
-                              RegionAllocator>  RegionList;
+  typedef typename Storage::template
+      Container<RegionBase>                     RegionContainer;
+  typedef typename RegionContainer::Value       Region;
+  typedef typename RegionContainer::Allocator   RegionAllocator;
+  typedef typename RegionContainer::List        RegionList;
   typedef typename RegionList::iterator         RegionIterator;
   typedef typename RegionList::const_iterator   RegionConstIterator;
   typedef RegionIterator                        RegionHandle;
@@ -203,11 +190,14 @@ class PartialDSTypes {
 // Template parameter:
 // - TraitTypes: cgal traits, which define the math kernel and geometry upon
 //               which the DS is built.
-template <class TraitsType>
+// - StorageType: where the entities are kept, PartialDSListStorage or
+//                PartialDSCompactStorage (see partialdsstorage.h).
+template <class TraitsType, class StorageType = PartialDSListStorage>
 class PartialDS {
  public:
-  typedef PartialDS<TraitsType>                      Self;
-  typedef PartialDSTypes<TraitsType, PartialDSItems> Types;
+  typedef PartialDS<TraitsType, StorageType>         Self;
+  typedef PartialDSTypes<TraitsType, PartialDSItems,
+                         StorageType>                Types;
 
   typedef typename Types::VertexList                 VertexList;
   typedef typename Types::PVertexList                PVertexList;
@@ -236,6 +226,7 @@ class PartialDS {
   typedef typename Types::ShellHandle                ShellHandle;
   typedef typename Types::RegionHandle               RegionHandle;
   typedef typename Types::Entity                     Entity;
+  typedef typename Types::VertexBase::Point          Point;
 
   typedef typename Types::VertexBase::PVertexCirculator
                                                      PVertexOfVertexCirculator;
@@ -244,6 +235,16 @@ class PartialDS {
   typedef typename Types::LoopBase::PEdgeCirculator  PEdgeLoopCirculator;
   typedef typename Types::ShellBase::PFaceCirculator PFaceOfShellCirculator;
 
+  // With the default storage, entities are allocated in chunks of
+  // items_per_chunk entities of a kind, and the chunks are kept until
+  // destruction (see PartialDSItemPool). Use an items_per_chunk of 0 to
+  // allocate each entity on its own. PartialDSCompactStorage manages its own
+  // blocks and ignores items_per_chunk.
+  static const size_t kDefaultItemsPerChunk = 256;
+  explicit PartialDS(size_t items_per_chunk = kDefaultItemsPerChunk);
+  // Destroys all the entities and releases their storage.
+  ~PartialDS();
+
   // Euler operators come in pairs, one to create some entity or entities and
   // its counterpart to undo the creation.
 
@@ -278,6 +279,41 @@ class PartialDS {
   VertexHandle SplitEdgeCreateVertex(EdgeHandle edge);
   void DeleteVertexJoinEdge(VertexHandle vertex, EdgeHandle edge);
 
+  // Bulk construction from an indexed face set, e.g. to load a model. This
+  // builds all the entities in a few passes over the input, and validates
+  // them once at the end, in exhaustive mode, instead of chaining the Euler
+  // operators above.
+  // - points: one new vertex is made per point.
+  // - face_offsets, face_vertices: the vertices of face f, in order, are
+  //   points[face_vertices[i]] for i in [face_offsets[f], face_offsets[f + 1]).
+  //   There is one more offset than there are faces.
+  // - face_regions: the region of each face, as an index into regions, or NULL
+  //   to put all the faces into regions[0].
+  // - new_vertices: if not NULL, receives the vertex made for each point.
+  // Faces with two consecutive vertices in common share an edge, whichever
+  // way they go around it and however many they are. Faces connected through
+  // edges share a p-vertex at their common vertices, so a vertex where two
+  // cones meet gets two p-vertices. Each set of faces connected through edges
+  // within a region becomes a void shell of that region, which holds both
+  // p-faces of each face. Points that no face uses become isolated vertices
+  // of regions[0].
+  // Returns false and adds nothing if an index is out of range, a face has
+  // fewer than three vertices or a face goes from a vertex to itself.
+  bool AddIndexedFaces(const std::vector<Point>& points,
+                       const std::vector<unsigned int>& face_offsets,
+                       const std::vector<unsigned int>& face_vertices,
+                       const std::vector<unsigned int>* face_regions,
+                       const std::vector<RegionHandle>& regions,
+                       std::vector<VertexHandle>* new_vertices);
+
+  // Edge queries about a vertex, see the PartialDSUtils functions of the same
+  // name. The edges they visit are tagged with marks handed out by this model,
+  // so queries on different models may run concurrently, but queries on the
+  // same model may not, even on a const model.
+  int GetIncidentEdgeCount(VertexHandle vertex) const;
+  template <class EdgeListType>
+  void VisitVertexEdges(VertexHandle vertex, EdgeListType* edges) const;
+
   // List accessors, to iterate over these vertices, edges, etc. E.g. to display
   // the geometry.
   const VertexList& vertices() const { return vertices_; }
@@ -286,6 +322,21 @@ class PartialDS {
   const ShellList& shells() const { return shells_; }
   const RegionList& regions() const { return regions_; }
 
+  // Per-entity attributes of the vertices, edges and faces, kept in arrays
+  // indexed by entity id (see partialdsproperties.h).
+  const PartialDSProperties* vertex_properties() const {
+    return &vertex_properties_;
+  }
+  PartialDSProperties* vertex_properties() { return &vertex_properties_; }
+  const PartialDSProperties* edge_properties() const {
+    return &edge_properties_;
+  }
+  PartialDSProperties* edge_properties() { return &edge_properties_; }
+  const PartialDSProperties* face_properties() const {
+    return &face_properties_;
+  }
+  PartialDSProperties* face_properties() { return &face_properties_; }
+
   // Validation functions; no-op unless either _DEBUG or _GEOM_TESTS id defined.
   static bool ValidateVertex(VertexConstHandle v);
   static bool ValidatePVertex(PVertexConstHandle pv);
@@ -363,28 +414,93 @@ class PartialDS {
   // Destroy an edge and all its attached radial p-edges.
   void DestroyEdgeCloud(EdgeHandle e);
 
+  // Get the outer shell of region, creating it if the region has none yet.
+  ShellHandle GetOuterShell(RegionHandle region);
+
  private:
-  // Template function for allocating and freeing PartialDS items.
-  template <class ItemHandle, class ItemList>
-  ItemHandle AllocateItem (ItemList* item_list) {
-    typedef typename ItemList::pointer Pointer;
-    typedef typename ItemList::value_type Entity;
-    
-    Pointer pv = item_list->get_allocator().allocate(1);
-    new (pv) Entity();
-    item_list->push_front(*pv);
-    return item_list->begin();
+  // Storage for each kind of item.
+  typedef typename Types::VertexContainer::Pool  VertexPool;
+  typedef typename Types::PVertexContainer::Pool PVertexPool;
+  typedef typename Types::EdgeContainer::Pool    EdgePool;
+  typedef typename Types::PEdgeContainer::Pool   PEdgePool;
+  typedef typename Types::LoopContainer::Pool    LoopPool;
+  typedef typename Types::FaceContainer::Pool    FacePool;
+  typedef typename Types::PFaceContainer::Pool   PFacePool;
+  typedef typename Types::ShellContainer::Pool   ShellPool;
+  typedef typename Types::RegionContainer::Pool  RegionPool;
+
+  // Not copyable: entities link to each other by address.
+  PartialDS(const Self&);
+  void operator=(const Self&);
+
+  // Hash of the vertex indices at the ends of an edge, in either order, used
+  // by AddIndexedFaces to match the sides of the faces into edges.
+  static size_t HashEdgeEnds(unsigned int v0, unsigned int v1) {
+    if (v0 > v1) std::swap(v0, v1);
+    size_t hash = (v0 * 2654435761u) ^ (v1 * 2246822519u);
+    return hash ^ (hash >> 16);
   }
-  
-  template <class ItemHandle, class ItemList>
-  void FreeItem(ItemHandle item, ItemList* item_list) {
-    item_list->erase(item);
-    item_list->get_allocator().destroy(&*item);
+
+  // Union-find over item indices, for AddIndexedFaces. FindRoot returns the
+  // representative of item i, halving the path to it on the way, and
+  // JoinRoots merges the sets of items i and j.
+  static unsigned int FindRoot(std::vector<unsigned int>* parents,
+                               unsigned int i);
+  static void JoinRoots(std::vector<unsigned int>* parents, unsigned int i,
+                        unsigned int j);
+
+  // Return a visit mark that no edge of this model carries yet. New edges
+  // carry 0, which is never returned. The marks wrap around after 2^32
+  // traversals; an edge that was last visited exactly that many traversals
+  // ago could then be missed.
+  unsigned int NextVisitMark() const {
+    if (++last_visit_mark_ == 0) ++last_visit_mark_;
+    return last_visit_mark_;
+  }
+
+  // Template functions for allocating and freeing PartialDS items, which
+  // defer to the storage policy, and give each item an id from item_ids.
+  template <class ItemContainer>
+  typename ItemContainer::Handle AllocateItem(
+      typename ItemContainer::List* item_list,
+      typename ItemContainer::Pool* item_pool,
+      PartialDSProperties* item_ids) {
+    typename ItemContainer::Handle item =
+        ItemContainer::Allocate(item_list, item_pool);
+    item->set_id(item_ids->AllocateId());
+    return item;
+  }
+
+  template <class ItemContainer>
+  void FreeItem(typename ItemContainer::Handle item,
+                typename ItemContainer::List* item_list,
+                typename ItemContainer::Pool* item_pool,
+                PartialDSProperties* item_ids) {
+    item_ids->FreeId(item->id());
+    ItemContainer::Free(item, item_list, item_pool);
+  }
+
+  // Free all the items of a container, regardless of topology.
+  template <class ItemContainer>
+  void FreeAllItems(typename ItemContainer::List* item_list,
+                    typename ItemContainer::Pool* item_pool) {
+    ItemContainer::FreeAll(item_list, item_pool);
   }
 
   // Enable/disable exhaustive mode (see function EnableExhaustiveMode).
   static bool s_exhaustive_mode_enabled_;
 
+  // The pools come first so as to outlive the containers.
+  VertexPool vertex_pool_;
+  PVertexPool pvertex_pool_;
+  EdgePool edge_pool_;
+  PEdgePool pedge_pool_;
+  LoopPool loop_pool_;
+  FacePool face_pool_;
+  PFacePool pface_pool_;
+  ShellPool shell_pool_;
+  RegionPool region_pool_;
+
   VertexList vertices_;
   PVertexList pvertices_;
   EdgeList edges_;
@@ -394,6 +510,21 @@ class PartialDS {
   PFaceList pfaces_;
   ShellList shells_;
   RegionList regions_;
+
+  // The ids and properties of each kind of item.
+  PartialDSProperties vertex_properties_;
+  PartialDSProperties pvertex_properties_;
+  PartialDSProperties edge_properties_;
+  PartialDSProperties pedge_properties_;
+  PartialDSProperties loop_properties_;
+  PartialDSProperties face_properties_;
+  PartialDSProperties pface_properties_;
+  PartialDSProperties shell_properties_;
+  PartialDSProperties region_properties_;
+
+  // The last visit mark handed out by NextVisitMark. Queries update it on a
+  // const model, without synchronization.
+  mutable unsigned int last_visit_mark_;
   // Note: In Ginsu, a PartialDS instance represent a single non-manifold mesh.
   // We keep the list of models at a higher level, outside of the PE data
   // structure.
@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <vector>
+
 #include <CGAL/Simple_cartesian.h>
 #include <gtest/gtest.h>
 #include "geometry/cgal_ext/partialds.h"
@@ -9,6 +12,7 @@
 namespace {
 
 using ginsu::geometry::PartialDS;
+using ginsu::geometry::PartialDSCompactStorage;
 
 class PartialDSTest : public ::testing::Test {
  protected:
@@ -191,4 +195,371 @@ TEST_F(PartialDSTest, TestMakeEdgeCycle) {
   ASSERT_TRUE(r->IsEmpty());
   mesh_->DeleteEmptyRegion(r);
 }
+
+TEST_F(PartialDSTest, TestEntityStorageIsReused) {
+  PartialDSTest::PEMesh::RegionHandle r;
+  r = mesh_->CreateEmptyRegion();
+  PartialDSTest::PEMesh::VertexHandle v;
+  PartialDSTest::PEMesh::ShellHandle s;
+  mesh_->CreateIsolatedVertex(r, &v, &s);
+  const void* address = &*v;
+  mesh_->DeleteIsolatedVertex(v);
+
+  // The new vertex takes the place of the deleted one.
+  mesh_->CreateIsolatedVertex(r, &v, &s);
+  EXPECT_EQ(address, &*v);
+  ASSERT_TRUE(mesh_->ValidateVertex(v));
+  mesh_->DeleteIsolatedVertex(v);
+  mesh_->DeleteEmptyRegion(r);
+}
+
+TEST_F(PartialDSTest, TestDestroyNonEmptyMesh) {
+  // Entities still in the mesh are freed with it, whether pooled or
+  // allocated one by one.
+  const size_t kItemsPerChunk[] = {PartialDSTest::PEMesh::kDefaultItemsPerChunk,
+                                   1, 0};
+  for (int i = 0; i < 3; ++i) {
+    PartialDSTest::PEMesh* mesh = new PartialDSTest::PEMesh(kItemsPerChunk[i]);
+    PartialDSTest::PEMesh::RegionHandle r = mesh->CreateEmptyRegion();
+    PartialDSTest::PEMesh::VertexHandle v;
+    PartialDSTest::PEMesh::ShellHandle shell;
+    mesh->CreateIsolatedVertex(r, &v, &shell);
+    PartialDSTest::PEMesh::EdgeHandle e0 =
+        mesh->CreateWireEdgeAndVertex(shell, v);
+    PartialDSTest::PEMesh::EdgeHandle e1 =
+        mesh->CreateWireEdgeAndVertex(shell, e0->end_pvertex()->vertex());
+    mesh->MakeEdgeCycle(shell, v, e1->end_pvertex()->vertex());
+    ASSERT_EQ(3, mesh->vertices().size());
+    ASSERT_EQ(3, mesh->edges().size());
+    delete mesh;
+  }
+}
+
+TEST_F(PartialDSTest, TestAddIndexedFacesCube) {
+  PartialDSTest::PEMesh::RegionHandle r = mesh_->CreateEmptyRegion();
+  std::vector<PartialDSTest::PEMesh::Point> points;
+  for (int i = 0; i < 8; ++i) {
+    points.push_back(PartialDSTest::PEMesh::Point(
+        ((i + 1) / 2) % 2, (i / 2) % 2, i / 4));
+  }
+  const unsigned int kCubeFaces[6][4] = {
+    {0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4},
+    {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}
+  };
+  std::vector<unsigned int> face_offsets(1, 0);
+  std::vector<unsigned int> face_vertices;
+  for (int f = 0; f < 6; ++f) {
+    face_vertices.insert(face_vertices.end(), kCubeFaces[f], kCubeFaces[f] + 4);
+    face_offsets.push_back(face_vertices.size());
+  }
+  std::vector<PartialDSTest::PEMesh::RegionHandle> regions(1, r);
+  std::vector<PartialDSTest::PEMesh::VertexHandle> vertices;
+  ASSERT_TRUE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices, NULL,
+                                     regions, &vertices));
+
+  EXPECT_EQ(8, mesh_->vertices().size());
+  EXPECT_EQ(12, mesh_->edges().size());
+  EXPECT_EQ(6, mesh_->faces().size());
+  ASSERT_EQ(8, vertices.size());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(vertices[i]->point() == points[i]);
+    EXPECT_EQ(1, vertices[i]->GetPVertexCount());
+    EXPECT_EQ(3, mesh_->GetIncidentEdgeCount(vertices[i]));
+  }
+  for (PartialDSTest::PEMesh::EdgeList::const_iterator e =
+           mesh_->edges().begin(); e != mesh_->edges().end(); ++e) {
+    EXPECT_TRUE(mesh_->ValidateEdge(e));
+    // Each edge is shared by two faces.
+    EXPECT_TRUE(e->parent_pedge()->radial_next() != e->parent_pedge());
+    EXPECT_TRUE(e->parent_pedge()->radial_next()->radial_next() ==
+                e->parent_pedge());
+  }
+  // One void shell holds both sides of all the faces.
+  PartialDSTest::PEMesh::ShellHandle shell =
+      r->outer_shell()->next_void_shell();
+  ASSERT_TRUE(shell != NULL);
+  EXPECT_TRUE(shell->next_void_shell() == NULL);
+  int pface_count = 0;
+  PartialDSTest::PEMesh::PFaceOfShellCirculator pf = shell->pface_begin();
+  do {
+    EXPECT_TRUE(mesh_->ValidatePFace(pf));
+    ++pface_count;
+  } while (++pf != shell->pface_begin());
+  EXPECT_EQ(12, pface_count);
+}
+
+TEST_F(PartialDSTest, TestAddIndexedFacesNonManifold) {
+  std::vector<PartialDSTest::PEMesh::RegionHandle> regions;
+  regions.push_back(mesh_->CreateEmptyRegion());
+  regions.push_back(mesh_->CreateEmptyRegion());
+  std::vector<PartialDSTest::PEMesh::Point> points(8);
+  // Three triangles around edge 0-1, the middle one turned the other way,
+  // and a fourth triangle that only touches them at vertex 0. Point 7 is
+  // not used.
+  const unsigned int kFaces[4][3] = {
+    {0, 1, 2}, {1, 0, 3}, {0, 1, 4}, {0, 5, 6}
+  };
+  std::vector<unsigned int> face_offsets(1, 0);
+  std::vector<unsigned int> face_vertices;
+  for (int f = 0; f < 4; ++f) {
+    face_vertices.insert(face_vertices.end(), kFaces[f], kFaces[f] + 3);
+    face_offsets.push_back(face_vertices.size());
+  }
+  std::vector<unsigned int> face_regions(3, 0);
+  face_regions.push_back(1);
+  std::vector<PartialDSTest::PEMesh::VertexHandle> vertices;
+  ASSERT_TRUE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices,
+                                     &face_regions, regions, &vertices));
+
+  // The isolated vertex has its own degenerate edge.
+  EXPECT_EQ(8, mesh_->vertices().size());
+  EXPECT_EQ(11, mesh_->edges().size());
+  EXPECT_TRUE(vertices[7]->IsIsolated());
+  // The fin's edge has three radial p-edges.
+  std::vector<PartialDSTest::PEMesh::EdgeHandle> edges;
+  mesh_->VisitVertexEdges(vertices[1], &edges);
+  PartialDSTest::PEMesh::EdgeHandle fin_edge;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (edges[i]->start_pvertex()->vertex() == vertices[0] ||
+        edges[i]->end_pvertex()->vertex() == vertices[0]) {
+      fin_edge = edges[i];
+    }
+  }
+  ASSERT_TRUE(fin_edge != NULL);
+  int radial_count = 0;
+  PartialDSTest::PEMesh::PEdgeRadialCirculator pe = fin_edge->pedge_begin();
+  do {
+    EXPECT_TRUE(mesh_->ValidatePEdge(pe));
+    ++radial_count;
+  } while (++pe != fin_edge->pedge_begin());
+  EXPECT_EQ(3, radial_count);
+  // Vertex 0 is used by two separate fans.
+  EXPECT_EQ(2, vertices[0]->GetPVertexCount());
+  EXPECT_EQ(6, mesh_->GetIncidentEdgeCount(vertices[0]));
+  EXPECT_EQ(1, vertices[1]->GetPVertexCount());
+  EXPECT_EQ(4, mesh_->GetIncidentEdgeCount(vertices[1]));
+  // Each region got a void shell for its faces, and the first region one
+  // more for the isolated vertex.
+  int void_shell_count = 0;
+  for (PartialDSTest::PEMesh::ShellHandle shell =
+           regions[0]->outer_shell()->next_void_shell();
+       shell != NULL; shell = shell->next_void_shell()) {
+    ++void_shell_count;
+  }
+  EXPECT_EQ(2, void_shell_count);
+  ASSERT_TRUE(regions[1]->outer_shell()->next_void_shell() != NULL);
+  EXPECT_TRUE(regions[1]->outer_shell()->next_void_shell()->
+              next_void_shell() == NULL);
+}
+
+TEST_F(PartialDSTest, TestAddIndexedFacesRejectsBadInput) {
+  std::vector<PartialDSTest::PEMesh::RegionHandle> regions(
+      1, mesh_->CreateEmptyRegion());
+  std::vector<PartialDSTest::PEMesh::Point> points(4);
+  std::vector<unsigned int> face_offsets;
+  face_offsets.push_back(0);
+  face_offsets.push_back(3);
+  const unsigned int kBadFaces[3][3] = {{0, 1, 4}, {0, 1, 1}, {0, 1, 0}};
+  for (int i = 0; i < 3; ++i) {
+    std::vector<unsigned int> face_vertices(kBadFaces[i], kBadFaces[i] + 3);
+    EXPECT_FALSE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices,
+                                        NULL, regions, NULL));
+  }
+  std::vector<unsigned int> face_vertices(2, 0);
+  face_vertices[1] = 1;
+  face_offsets[1] = 2;
+  EXPECT_FALSE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices,
+                                      NULL, regions, NULL));
+  std::vector<unsigned int> face_regions(1, 1);
+  face_vertices.push_back(2);
+  face_offsets[1] = 3;
+  EXPECT_FALSE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices,
+                                      &face_regions, regions, NULL));
+  EXPECT_EQ(0, mesh_->vertices().size());
+  EXPECT_EQ(0, mesh_->faces().size());
+  EXPECT_TRUE(regions[0]->outer_shell() == NULL);
+}
+
+TEST_F(PartialDSTest, TestVisitVertexEdgesOfManyFins) {
+  // Enough triangles around edge 0-1 that the edges left to visit don't all
+  // fit in place.
+  const unsigned int kFinCount = 40;
+  std::vector<PartialDSTest::PEMesh::RegionHandle> regions(
+      1, mesh_->CreateEmptyRegion());
+  std::vector<PartialDSTest::PEMesh::Point> points(2 + kFinCount);
+  std::vector<unsigned int> face_offsets(1, 0);
+  std::vector<unsigned int> face_vertices;
+  for (unsigned int f = 0; f < kFinCount; ++f) {
+    face_vertices.push_back(0);
+    face_vertices.push_back(1);
+    face_vertices.push_back(2 + f);
+    face_offsets.push_back(face_vertices.size());
+  }
+  std::vector<PartialDSTest::PEMesh::VertexHandle> vertices;
+  ASSERT_TRUE(mesh_->AddIndexedFaces(points, face_offsets, face_vertices,
+                                     NULL, regions, &vertices));
+
+  // Repeated queries see every edge exactly once.
+  for (int i = 0; i < 2; ++i) {
+    std::vector<PartialDSTest::PEMesh::EdgeHandle> edges;
+    mesh_->VisitVertexEdges(vertices[0], &edges);
+    EXPECT_EQ(kFinCount + 1, edges.size());
+    for (size_t j = 1; j < edges.size(); ++j)
+      EXPECT_TRUE(std::find(edges.begin(), edges.begin() + j, edges[j]) ==
+                  edges.begin() + j);
+    EXPECT_EQ(static_cast<int>(kFinCount + 1),
+              mesh_->GetIncidentEdgeCount(vertices[1]));
+    EXPECT_EQ(2, mesh_->GetIncidentEdgeCount(vertices[2]));
+  }
+}
+
+// Freed entity ids are handed out again before new ones.
+TEST_F(PartialDSTest, TestEntityIdsAreDense) {
+  PartialDSTest::PEMesh::RegionHandle r = mesh_->CreateEmptyRegion();
+  PartialDSTest::PEMesh::VertexHandle v0, v1, v2;
+  PartialDSTest::PEMesh::ShellHandle s0, s1, s2;
+  mesh_->CreateIsolatedVertex(r, &v0, &s0);
+  mesh_->CreateIsolatedVertex(r, &v1, &s1);
+  EXPECT_EQ(0, v0->id());
+  EXPECT_EQ(1, v1->id());
+  EXPECT_EQ(2, mesh_->vertex_properties()->id_count());
+
+  // The id of a deleted vertex goes to the next one.
+  mesh_->DeleteIsolatedVertex(v0);
+  EXPECT_FALSE(mesh_->vertex_properties()->IsIdUsed(0));
+  EXPECT_TRUE(mesh_->vertex_properties()->IsIdUsed(1));
+  mesh_->CreateIsolatedVertex(r, &v2, &s2);
+  EXPECT_EQ(0, v2->id());
+  EXPECT_EQ(2, mesh_->vertex_properties()->id_count());
+  EXPECT_TRUE(mesh_->vertex_properties()->IsIdUsed(0));
+
+  mesh_->DeleteIsolatedVertex(v1);
+  mesh_->DeleteIsolatedVertex(v2);
+  mesh_->DeleteEmptyRegion(r);
+}
+
+TEST_F(PartialDSTest, TestPropertyMaps) {
+  typedef ginsu::geometry::PartialDSPropertyMap<int> MaterialMap;
+  typedef ginsu::geometry::PartialDSPropertyMap<bool> SelectionMap;
+  PartialDSTest::PEMesh::RegionHandle r = mesh_->CreateEmptyRegion();
+  PartialDSTest::PEMesh::VertexHandle v0, v1;
+  PartialDSTest::PEMesh::ShellHandle s0, s1;
+  mesh_->CreateIsolatedVertex(r, &v0, &s0);
+
+  // Existing and new vertices start with the default values.
+  MaterialMap materials = mesh_->vertex_properties()->AddProperty(7);
+  SelectionMap selected = mesh_->vertex_properties()->AddProperty(false);
+  EXPECT_EQ(2, mesh_->vertex_properties()->property_count());
+  EXPECT_EQ(0, mesh_->edge_properties()->property_count());
+  EXPECT_EQ(7, materials[v0]);
+  materials[v0] = 3;
+  selected[v0] = true;
+  mesh_->CreateIsolatedVertex(r, &v1, &s1);
+  EXPECT_EQ(3, materials[v0]);
+  EXPECT_EQ(7, materials[v1]);
+  EXPECT_TRUE(selected[v0]);
+  EXPECT_FALSE(selected[v1]);
+
+  // Values are stored by id, and can be walked in bulk.
+  ASSERT_EQ(2, materials.size());
+  EXPECT_EQ(3, materials.begin()[v0->id()]);
+  int selected_count = 0;
+  for (SelectionMap::Iterator i = selected.begin(); i != selected.end(); ++i) {
+    if (*i) ++selected_count;
+  }
+  EXPECT_EQ(1, selected_count);
+
+  // A vertex that takes a freed id gets the default values again.
+  mesh_->DeleteIsolatedVertex(v0);
+  mesh_->CreateIsolatedVertex(r, &v0, &s0);
+  EXPECT_EQ(7, materials[v0]);
+  EXPECT_FALSE(selected[v0]);
+
+  mesh_->vertex_properties()->RemoveProperty(&materials);
+  EXPECT_TRUE(materials.IsNull());
+  EXPECT_EQ(1, mesh_->vertex_properties()->property_count());
+  EXPECT_FALSE(selected[v1]);
+
+  mesh_->DeleteIsolatedVertex(v0);
+  mesh_->DeleteIsolatedVertex(v1);
+  mesh_->DeleteEmptyRegion(r);
+}
+
+// The same Euler operators, with the entities kept in compact containers.
+class PartialDSCompactTest : public ::testing::Test {
+ protected:
+  typedef CGAL::Simple_cartesian<double> Kernel;
+  typedef PartialDS<Kernel, PartialDSCompactStorage> PEMesh;
+  typedef PartialDS<Kernel> ListPEMesh;
+
+  PartialDSCompactTest() : mesh_(NULL) {}
+
+  virtual void SetUp() {
+    mesh_ = new PEMesh();
+    PEMesh::EnableExhaustiveMode(true);
+  }
+
+  virtual void TearDown() {
+    delete mesh_;
+    mesh_ = NULL;
+  }
+
+ protected:
+  PEMesh* mesh_;
+};
+
+TEST_F(PartialDSCompactTest, TestEntitiesAreSmaller) {
+  EXPECT_LT(sizeof(PEMesh::Types::Vertex), sizeof(ListPEMesh::Types::Vertex));
+  EXPECT_LT(sizeof(PEMesh::Types::PEdge), sizeof(ListPEMesh::Types::PEdge));
+  EXPECT_LT(sizeof(PEMesh::Types::Face), sizeof(ListPEMesh::Types::Face));
+}
+
+TEST_F(PartialDSCompactTest, TestMakeEdgeCycle) {
+  PEMesh::RegionHandle r = mesh_->CreateEmptyRegion();
+  ASSERT_TRUE(r != NULL);
+
+  PEMesh::VertexHandle v[3];
+  PEMesh::EdgeHandle e[3];
+  PEMesh::ShellHandle shell;
+  mesh_->CreateIsolatedVertex(r, &v[0], &shell);
+  e[0] = mesh_->CreateWireEdgeAndVertex(shell, v[0]);
+  v[1] = e[0]->end_pvertex()->vertex();
+  e[1] = mesh_->CreateWireEdgeAndVertex(shell, v[1]);
+  v[2] = e[1]->end_pvertex()->vertex();
+  e[2] = mesh_->MakeEdgeCycle(shell, v[0], v[2]);
+
+  std::vector<PEMesh::EdgeHandle> cycle(e, e + 3);
+  ASSERT_TRUE(PEMesh::ValidateEdgeCycle(cycle));
+  int vertex_count = 0;
+  for (PEMesh::VertexList::const_iterator it = mesh_->vertices().begin();
+       it != mesh_->vertices().end(); ++it) {
+    ASSERT_TRUE(mesh_->ValidateVertex(it));
+    ++vertex_count;
+  }
+  EXPECT_EQ(3, vertex_count);
+
+  mesh_->DeleteEdgeCycle(e[2]);
+  mesh_->DeleteWireEdgeAndVertex(e[1], v[2]);
+  mesh_->DeleteWireEdgeAndVertex(e[0], v[1]);
+  ASSERT_TRUE(mesh_->ValidateVertex(v[0]));
+  mesh_->DeleteIsolatedVertex(v[0]);
+  ASSERT_TRUE(r->IsEmpty());
+  mesh_->DeleteEmptyRegion(r);
+  EXPECT_EQ(0, mesh_->vertices().size());
+  EXPECT_EQ(0, mesh_->edges().size());
+}
+
+TEST_F(PartialDSCompactTest, TestDestroyNonEmptyMesh) {
+  PEMesh::RegionHandle r = mesh_->CreateEmptyRegion();
+  PEMesh::VertexHandle v;
+  PEMesh::ShellHandle shell;
+  mesh_->CreateIsolatedVertex(r, &v, &shell);
+  PEMesh::EdgeHandle e0 = mesh_->CreateWireEdgeAndVertex(shell, v);
+  PEMesh::EdgeHandle e1 =
+      mesh_->CreateWireEdgeAndVertex(shell, e0->end_pvertex()->vertex());
+  mesh_->MakeEdgeCycle(shell, v, e1->end_pvertex()->vertex());
+  ASSERT_EQ(3, mesh_->vertices().size());
+  ASSERT_EQ(3, mesh_->faces().size());
+  // TearDown deletes the mesh with all its entities.
+}
 }  // namespace
@@ -0,0 +1,217 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Times building and tearing down partial-entity models of about 100k faces,
+// with the entities pooled per model, with one allocation per entity, and in
+// compact containers; loading a 1M-face model in bulk; and querying the edges
+// around vertices of valence 3 to 1000.
+
+#include <math.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include <CGAL/Simple_cartesian.h>
+#include <gtest/gtest.h>
+#include "geometry/cgal_ext/partialds.h"
+
+namespace {
+
+typedef CGAL::Simple_cartesian<double> Kernel;
+typedef ginsu::geometry::PartialDS<Kernel> PEMesh;
+typedef ginsu::geometry::PartialDS<
+    Kernel, ginsu::geometry::PartialDSCompactStorage> CompactPEMesh;
+
+double Now() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+// Each wire edge comes with its own face, so this makes 3 * kTriangleCount
+// faces.
+const int kTriangleCount = 33334;
+
+// A triangle of wire edges: e0 from v0 to v1, e1 from v1 to v2 and e2 from
+// v0 to v2.
+template <class Mesh>
+struct Triangle {
+  typename Mesh::VertexHandle v0, v1, v2;
+  typename Mesh::EdgeHandle e0, e1, e2;
+};
+
+template <class Mesh>
+void BuildTriangles(Mesh* mesh, typename Mesh::RegionHandle region,
+                    std::vector<Triangle<Mesh> >* triangles) {
+  triangles->resize(kTriangleCount);
+  for (int i = 0; i < kTriangleCount; ++i) {
+    Triangle<Mesh>& t = (*triangles)[i];
+    typename Mesh::ShellHandle shell;
+    mesh->CreateIsolatedVertex(region, &t.v0, &shell);
+    t.e0 = mesh->CreateWireEdgeAndVertex(shell, t.v0);
+    t.v1 = t.e0->end_pvertex()->vertex();
+    t.e1 = mesh->CreateWireEdgeAndVertex(shell, t.v1);
+    t.v2 = t.e1->end_pvertex()->vertex();
+    t.e2 = mesh->MakeEdgeCycle(shell, t.v0, t.v2);
+  }
+}
+
+// Take the triangles apart with the Euler operators.
+template <class Mesh>
+void DeleteTriangles(Mesh* mesh,
+                     const std::vector<Triangle<Mesh> >& triangles) {
+  for (size_t i = 0; i < triangles.size(); ++i) {
+    const Triangle<Mesh>& t = triangles[i];
+    mesh->DeleteEdgeCycle(t.e2);
+    mesh->DeleteWireEdgeAndVertex(t.e1, t.v2);
+    mesh->DeleteWireEdgeAndVertex(t.e0, t.v1);
+    mesh->DeleteIsolatedVertex(t.v0);
+  }
+}
+
+template <class Mesh>
+void TimeModel(const char* name, size_t items_per_chunk) {
+  Mesh::EnableExhaustiveMode(false);
+  double start = Now();
+  Mesh* mesh = new Mesh(items_per_chunk);
+  typename Mesh::RegionHandle region = mesh->CreateEmptyRegion();
+  std::vector<Triangle<Mesh> > triangles;
+  BuildTriangles(mesh, region, &triangles);
+  double built = Now();
+  DeleteTriangles(mesh, triangles);
+  double deleted = Now();
+  BuildTriangles(mesh, region, &triangles);
+  double rebuilt = Now();
+  size_t face_count = mesh->faces().size();
+  delete mesh;
+  double destroyed = Now();
+  printf("%s, %d faces: build %.3fs, delete %.3fs, rebuild %.3fs, "
+         "destroy %.3fs\n", name, static_cast<int>(face_count),
+         built - start, deleted - built, rebuilt - deleted,
+         destroyed - rebuilt);
+  EXPECT_EQ(static_cast<size_t>(3 * kTriangleCount), face_count);
+  Mesh::EnableExhaustiveMode(true);
+}
+
+TEST(PartialDSBenchmark, ItemPools) {
+  TimeModel<PEMesh>("Pooled", PEMesh::kDefaultItemsPerChunk);
+}
+
+TEST(PartialDSBenchmark, ItemAllocator) {
+  TimeModel<PEMesh>("CGAL_ALLOCATOR", 0);
+}
+
+TEST(PartialDSBenchmark, CompactContainers) {
+  TimeModel<CompactPEMesh>("Compact_container",
+                           CompactPEMesh::kDefaultItemsPerChunk);
+}
+
+// A grid of kGridSize x kGridSize quads.
+const unsigned int kGridSize = 1000;
+
+template <class Mesh>
+void TimeIndexedFaces(const char* name) {
+  std::vector<typename Mesh::Point> points;
+  for (unsigned int y = 0; y <= kGridSize; ++y) {
+    for (unsigned int x = 0; x <= kGridSize; ++x)
+      points.push_back(typename Mesh::Point(x, y, 0));
+  }
+  std::vector<unsigned int> face_offsets(1, 0);
+  std::vector<unsigned int> face_vertices;
+  for (unsigned int y = 0; y < kGridSize; ++y) {
+    for (unsigned int x = 0; x < kGridSize; ++x) {
+      unsigned int corner = y * (kGridSize + 1) + x;
+      face_vertices.push_back(corner);
+      face_vertices.push_back(corner + 1);
+      face_vertices.push_back(corner + kGridSize + 2);
+      face_vertices.push_back(corner + kGridSize + 1);
+      face_offsets.push_back(face_vertices.size());
+    }
+  }
+
+  Mesh::EnableExhaustiveMode(false);
+  double start = Now();
+  Mesh* mesh = new Mesh();
+  std::vector<typename Mesh::RegionHandle> regions(1,
+                                                   mesh->CreateEmptyRegion());
+  EXPECT_TRUE(mesh->AddIndexedFaces(points, face_offsets, face_vertices, NULL,
+                                    regions, NULL));
+  double built = Now();
+  size_t face_count = mesh->faces().size();
+  size_t edge_count = mesh->edges().size();
+  delete mesh;
+  double destroyed = Now();
+  printf("%s, %d faces from an indexed face set: build %.3fs, "
+         "destroy %.3fs\n", name, static_cast<int>(face_count),
+         built - start, destroyed - built);
+  EXPECT_EQ(kGridSize * kGridSize, face_count);
+  EXPECT_EQ(2 * kGridSize * (kGridSize + 1), edge_count);
+  Mesh::EnableExhaustiveMode(true);
+}
+
+TEST(PartialDSBenchmark, IndexedFaces) {
+  TimeIndexedFaces<PEMesh>("Pooled");
+}
+
+TEST(PartialDSBenchmark, CompactIndexedFaces) {
+  TimeIndexedFaces<CompactPEMesh>("Compact_container");
+}
+
+// The number of edge queries timed per vertex valence.
+const int kQueryCount = 1000000;
+
+// Build a disk of valence triangles around a center vertex, then time how long
+// it takes to count and to list the edges incident upon the center.
+void TimeVertexEdges(unsigned int valence) {
+  std::vector<PEMesh::Point> points(1, PEMesh::Point(0, 0, 0));
+  std::vector<unsigned int> face_offsets(1, 0);
+  std::vector<unsigned int> face_vertices;
+  for (unsigned int i = 0; i < valence; ++i) {
+    double angle = 2 * CGAL_PI * i / valence;
+    points.push_back(PEMesh::Point(cos(angle), sin(angle), 0));
+    face_vertices.push_back(0);
+    face_vertices.push_back(1 + i);
+    face_vertices.push_back(1 + (i + 1) % valence);
+    face_offsets.push_back(face_vertices.size());
+  }
+  PEMesh mesh;
+  std::vector<PEMesh::RegionHandle> regions(1, mesh.CreateEmptyRegion());
+  std::vector<PEMesh::VertexHandle> vertices;
+  ASSERT_TRUE(mesh.AddIndexedFaces(points, face_offsets, face_vertices, NULL,
+                                   regions, &vertices));
+  PEMesh::VertexHandle center = vertices[0];
+
+  // Scale the number of queries down so that each valence visits about the
+  // same number of edges.
+  int query_count = kQueryCount * 3 / valence;
+  double start = Now();
+  int total = 0;
+  for (int i = 0; i < query_count; ++i)
+    total += mesh.GetIncidentEdgeCount(center);
+  double counted = Now();
+  std::vector<PEMesh::EdgeHandle> edges;
+  edges.reserve(valence);
+  for (int i = 0; i < query_count; ++i) {
+    edges.clear();
+    mesh.VisitVertexEdges(center, &edges);
+  }
+  double visited = Now();
+  printf("Valence %d: count %.1fns, visit %.1fns per query\n",
+         static_cast<int>(valence),
+         (counted - start) * 1e9 / query_count,
+         (visited - counted) * 1e9 / query_count);
+  EXPECT_EQ(static_cast<int>(valence) * query_count, total);
+  EXPECT_EQ(valence, edges.size());
+}
+
+TEST(PartialDSBenchmark, VertexEdges) {
+  PEMesh::EnableExhaustiveMode(false);
+  const unsigned int kValences[] = { 3, 6, 10, 30, 100, 300, 1000 };
+  for (size_t i = 0; i < sizeof(kValences) / sizeof(kValences[0]); ++i)
+    TimeVertexEdges(kValences[i]);
+  PEMesh::EnableExhaustiveMode(true);
+}
+
+}  // namespace
@@ -12,17 +12,62 @@
 namespace ginsu {
 namespace geometry {
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::s_exhaustive_mode_enabled_ = true;
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::s_exhaustive_mode_enabled_ = true;
+
+template <class TraitsType, class StorageType>
+PartialDS<TraitsType, StorageType>::PartialDS(size_t items_per_chunk)
+    : vertex_pool_(items_per_chunk),
+      pvertex_pool_(items_per_chunk),
+      edge_pool_(items_per_chunk),
+      pedge_pool_(items_per_chunk),
+      loop_pool_(items_per_chunk),
+      face_pool_(items_per_chunk),
+      pface_pool_(items_per_chunk),
+      shell_pool_(items_per_chunk),
+      region_pool_(items_per_chunk),
+      last_visit_mark_(0) {
+}
+
+template <class TraitsType, class StorageType>
+PartialDS<TraitsType, StorageType>::~PartialDS() {
+  // The entities link to each other, but none owns another, so they can go
+  // in any order.
+  FreeAllItems<typename Types::VertexContainer>(&vertices_, &vertex_pool_);
+  FreeAllItems<typename Types::PVertexContainer>(&pvertices_, &pvertex_pool_);
+  FreeAllItems<typename Types::EdgeContainer>(&edges_, &edge_pool_);
+  FreeAllItems<typename Types::PEdgeContainer>(&pedges_, &pedge_pool_);
+  FreeAllItems<typename Types::LoopContainer>(&loops_, &loop_pool_);
+  FreeAllItems<typename Types::FaceContainer>(&faces_, &face_pool_);
+  FreeAllItems<typename Types::PFaceContainer>(&pfaces_, &pface_pool_);
+  FreeAllItems<typename Types::ShellContainer>(&shells_, &shell_pool_);
+  FreeAllItems<typename Types::RegionContainer>(&regions_, &region_pool_);
+}
+
+// Edge queries about a vertex
+template <class TraitsType, class StorageType>
+int PartialDS<TraitsType, StorageType>::GetIncidentEdgeCount(
+    VertexHandle vertex) const {
+  return PartialDSUtils<Types>::GetIncidentEdgeCount(vertex, NextVisitMark());
+}
+
+template <class TraitsType, class StorageType>
+template <class EdgeListType>
+void PartialDS<TraitsType, StorageType>::VisitVertexEdges(
+    VertexHandle vertex, EdgeListType* edges) const {
+  PartialDSUtils<Types>::VisitVertexEdges(vertex, NextVisitMark(), edges);
+}
 
 // Euler operators
-template <class TraitsType> typename PartialDS<TraitsType>::RegionHandle
-    PartialDS<TraitsType>::CreateEmptyRegion() {
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::RegionHandle
+    PartialDS<TraitsType, StorageType>::CreateEmptyRegion() {
   return AllocateRegion();
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteEmptyRegion(RegionHandle region) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteEmptyRegion(
+    RegionHandle region) {
   if (region == NULL) return;
 
   assert(region->IsEmpty() && "Must empty the region first.");
@@ -35,21 +80,15 @@ void PartialDS<TraitsType>::DeleteEmptyRegion(RegionHandle region) {
   }
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::CreateIsolatedVertex(
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::CreateIsolatedVertex(
     RegionHandle region, VertexHandle* new_v, ShellHandle* new_s) {
   // Must have a region.
   assert(region != NULL);
   if (region == NULL) return;
 
-  // We need an outer shell to host the vertex' void shell. If the region
-  // doesn't have one, create it.
-  ShellHandle outer_shell = region->outer_shell();
-  if (outer_shell == NULL) {
-    outer_shell = AllocateShell();
-    region->set_outer_shell(outer_shell);
-    outer_shell->set_parent_region(region);
-  }
+  // We need an outer shell to host the vertex' void shell.
+  ShellHandle outer_shell = GetOuterShell(region);
 
   // Create the vertex entity hierarchy.
   VertexHandle vertex = AllocateVertex();
@@ -64,8 +103,9 @@ void PartialDS<TraitsType>::CreateIsolatedVertex(
   *new_s = void_shell;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteIsolatedVertex(VertexHandle vertex) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteIsolatedVertex(
+    VertexHandle vertex) {
   typedef PartialDSUtils<Types> Utils;
 
   assert(vertex->IsIsolated());
@@ -83,10 +123,10 @@ void PartialDS<TraitsType>::DeleteIsolatedVertex(VertexHandle vertex) {
   }
 }
 
-template <class TraitsType> 
-    typename PartialDS<TraitsType>::EdgeHandle
-        PartialDS<TraitsType>::CreateWireEdgeAndVertex(ShellHandle shell,
-                                                       VertexHandle v1) {
+template <class TraitsType, class StorageType> 
+    typename PartialDS<TraitsType, StorageType>::EdgeHandle
+        PartialDS<TraitsType, StorageType>::CreateWireEdgeAndVertex(
+            ShellHandle shell, VertexHandle v1) {
   typedef PartialDSUtils<Types> Utils;
 
   if (v1->IsIsolated()) {
@@ -110,17 +150,17 @@ template <class TraitsType>
   return edge;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteWireEdgeAndVertex(EdgeHandle edge,
-                                                    VertexHandle vertex) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteWireEdgeAndVertex(
+    EdgeHandle edge, VertexHandle vertex) {
   typedef PartialDSUtils<Types> Utils;
 
   // We can only delete wire edges.
   assert(edge->IsWireEdge());
   if (!edge->IsWireEdge()) return;
   // The vertex better be singular.
-  assert(Utils::GetIncidentEdgeCount(vertex) == 1);
-  if (Utils::GetIncidentEdgeCount(vertex) != 1) return;
+  assert(GetIncidentEdgeCount(vertex) == 1);
+  if (GetIncidentEdgeCount(vertex) != 1) return;
   // And the edge and vertex better be connected.
   assert(edge->start_pvertex()->vertex() == vertex ||
          edge->end_pvertex()->vertex() == vertex);
@@ -146,10 +186,10 @@ void PartialDS<TraitsType>::DeleteWireEdgeAndVertex(EdgeHandle edge,
   }
 }
 
-template <class TraitsType>
-    typename PartialDS<TraitsType>::EdgeHandle
-        PartialDS<TraitsType>::CreateEdgeInLoop(LoopHandle loop,
-                                                VertexHandle vertex) {
+template <class TraitsType, class StorageType>
+    typename PartialDS<TraitsType, StorageType>::EdgeHandle
+        PartialDS<TraitsType, StorageType>::CreateEdgeInLoop(
+            LoopHandle loop, VertexHandle vertex) {
   // Before anything else, let's make sure that the loop is not associated with
   // a wire edge or isolated vertex. We can do that by checking if the face
   // is degenerate.
@@ -202,10 +242,8 @@ template <class TraitsType>
   return new_edge;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteEdgeFromLoop(EdgeHandle edge) {
-  typedef PartialDSUtils<Types> Utils;
-
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteEdgeFromLoop(EdgeHandle edge) {
   // Not suitable for wire edges.
   assert(!edge->IsWireEdge());
   if (edge->IsWireEdge()) return;
@@ -216,11 +254,11 @@ void PartialDS<TraitsType>::DeleteEdgeFromLoop(EdgeHandle edge) {
   assert(keep_v != del_v);
   if (keep_v == del_v) return;
   // We must delete the singular vertex and keep the other.
-  if (Utils::GetIncidentEdgeCount(keep_v) != 1) {
+  if (GetIncidentEdgeCount(keep_v) != 1) {
     std::swap(del_v, keep_v);
   }
-  assert(Utils::GetIncidentEdgeCount(del_v) = 1);
-  if (Utils::GetIncidentEdgeCount(del_v) != 1) return;
+  assert(GetIncidentEdgeCount(del_v) == 1);
+  if (GetIncidentEdgeCount(del_v) != 1) return;
   // Gather the connecting p-edges and p-vertex. Ensure pe1 is the p-edge
   // leading into vertex del_v.
   PVertexHandle del_pv = del_v->parent_pvertex();
@@ -251,9 +289,9 @@ void PartialDS<TraitsType>::DeleteEdgeFromLoop(EdgeHandle edge) {
   DestroyVertexCloud(del_v);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::EdgeHandle
-    PartialDS<TraitsType>::MakeEdgeCycle(
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::EdgeHandle
+    PartialDS<TraitsType, StorageType>::MakeEdgeCycle(
         ShellHandle shell, VertexHandle from_vertex, VertexHandle to_vertex) {
   // Make sure we do not create a degenerate cycle.
   assert(from_vertex != to_vertex);
@@ -266,8 +304,8 @@ typename PartialDS<TraitsType>::EdgeHandle
   return edge;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteEdgeCycle(EdgeHandle edge) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteEdgeCycle(EdgeHandle edge) {
   typedef PartialDSUtils<Types> Utils;
 
   // Can only delete a wire edge.
@@ -276,9 +314,9 @@ void PartialDS<TraitsType>::DeleteEdgeCycle(EdgeHandle edge) {
   DestroyWireEdge(edge);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::VertexHandle
-    PartialDS<TraitsType>::SplitEdgeCreateVertex(EdgeHandle edge) {
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::VertexHandle
+    PartialDS<TraitsType, StorageType>::SplitEdgeCreateVertex(EdgeHandle edge) {
   typedef PartialDSUtils<Types> Utils;
 
   // TODO(gwink): Maybe I should allow splitting wire edges. It's not stricktly
@@ -345,14 +383,12 @@ typename PartialDS<TraitsType>::VertexHandle
   return new_v;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DeleteVertexJoinEdge(VertexHandle vertex,
-                                                 EdgeHandle edge) {
-  typedef PartialDSUtils<Types> Utils;
-
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DeleteVertexJoinEdge(
+    VertexHandle vertex, EdgeHandle edge) {
   // Verify that vertex has exactly two incident edges and a single p-vertex.
   if (s_exhaustive_mode_enabled_) {
-    int incident_edge_count = Utils::GetIncidentEdgeCount(vertex);
+    int incident_edge_count = GetIncidentEdgeCount(vertex);
     assert(incident_edge_count == 2);
     if (incident_edge_count != 2) return;
   }
@@ -403,105 +439,367 @@ void PartialDS<TraitsType>::DeleteVertexJoinEdge(VertexHandle vertex,
   DestroyEdgeCloud(del_e);
 }
 
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::AddIndexedFaces(
+    const std::vector<Point>& points,
+    const std::vector<unsigned int>& face_offsets,
+    const std::vector<unsigned int>& face_vertices,
+    const std::vector<unsigned int>* face_regions,
+    const std::vector<RegionHandle>& regions,
+    std::vector<VertexHandle>* new_vertices) {
+  typedef PartialDSUtils<Types> Utils;
+  const unsigned int kNoEdge = static_cast<unsigned int>(-1);
+
+  // Check the whole input before adding anything.
+  if (face_offsets.empty() || face_offsets.front() != 0 ||
+      face_offsets.back() != face_vertices.size() || regions.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < regions.size(); ++i) {
+    if (regions[i] == NULL) return false;
+  }
+  const unsigned int face_count = face_offsets.size() - 1;
+  if (face_regions != NULL && face_regions->size() != face_count) {
+    return false;
+  }
+  std::vector<bool> used_points(points.size(), false);
+  for (unsigned int f = 0; f < face_count; ++f) {
+    unsigned int begin = face_offsets[f];
+    unsigned int end = face_offsets[f + 1];
+    if (end < begin || end - begin < 3 || end > face_vertices.size()) {
+      return false;
+    }
+    if (face_regions != NULL && (*face_regions)[f] >= regions.size()) {
+      return false;
+    }
+    for (unsigned int c = begin; c < end; ++c) {
+      unsigned int next_c = (c + 1 < end) ? c + 1 : begin;
+      if (face_vertices[c] >= points.size() ||
+          face_vertices[c] == face_vertices[next_c]) {
+        return false;
+      }
+      used_points[face_vertices[c]] = true;
+    }
+  }
+
+  // Match the sides of the faces into edges. Side c goes from corner c to the
+  // next corner of its face. The first side matched to an edge gives the edge
+  // its direction; the corners at either end of the other sides are joined
+  // with the corners at the same vertex of that first side, and their faces
+  // with its face if they are in the same region. The sets of corners are the
+  // p-vertices, and the sets of faces the shells.
+  const unsigned int corner_count = face_vertices.size();
+  std::vector<unsigned int> corner_roots(corner_count);
+  for (unsigned int c = 0; c < corner_count; ++c) corner_roots[c] = c;
+  std::vector<unsigned int> face_roots(face_count);
+  for (unsigned int f = 0; f < face_count; ++f) face_roots[f] = f;
+  // The edge of each side, and the start corner, end corner and face of the
+  // first side of each edge.
+  std::vector<unsigned int> corner_edges(corner_count);
+  std::vector<unsigned int> edge_corners;
+  std::vector<unsigned int> edge_faces;
+  edge_corners.reserve(corner_count);
+  edge_faces.reserve(corner_count / 2);
+  {
+    // An open-addressing hash table of the edges, with at least two slots
+    // per edge.
+    size_t table_size = 1;
+    while (table_size < 2 * static_cast<size_t>(corner_count)) table_size *= 2;
+    std::vector<unsigned int> edge_table(table_size, kNoEdge);
+    for (unsigned int f = 0; f < face_count; ++f) {
+      unsigned int begin = face_offsets[f];
+      unsigned int end = face_offsets[f + 1];
+      unsigned int region = (face_regions != NULL) ? (*face_regions)[f] : 0;
+      for (unsigned int c = begin; c < end; ++c) {
+        unsigned int next_c = (c + 1 < end) ? c + 1 : begin;
+        unsigned int v0 = face_vertices[c];
+        unsigned int v1 = face_vertices[next_c];
+        size_t slot = HashEdgeEnds(v0, v1) & (table_size - 1);
+        unsigned int e;
+        while ((e = edge_table[slot]) != kNoEdge) {
+          unsigned int w0 = face_vertices[edge_corners[2 * e]];
+          unsigned int w1 = face_vertices[edge_corners[2 * e + 1]];
+          if ((w0 == v0 && w1 == v1) || (w0 == v1 && w1 == v0)) break;
+          slot = (slot + 1) & (table_size - 1);
+        }
+        if (e == kNoEdge) {
+          corner_edges[c] = edge_table[slot] = edge_faces.size();
+          edge_corners.push_back(c);
+          edge_corners.push_back(next_c);
+          edge_faces.push_back(f);
+          continue;
+        }
+        corner_edges[c] = e;
+        unsigned int start_c = edge_corners[2 * e];
+        unsigned int end_c = edge_corners[2 * e + 1];
+        if (face_vertices[start_c] == v0) {
+          JoinRoots(&corner_roots, c, start_c);
+          JoinRoots(&corner_roots, next_c, end_c);
+        } else {
+          JoinRoots(&corner_roots, c, end_c);
+          JoinRoots(&corner_roots, next_c, start_c);
+        }
+        unsigned int first_f = edge_faces[e];
+        if (face_regions == NULL || (*face_regions)[first_f] == region) {
+          JoinRoots(&face_roots, f, first_f);
+        }
+      }
+    }
+  }
+  const unsigned int edge_count = edge_faces.size();
+
+  // Make the vertices, and a p-vertex per set of corners.
+  std::vector<VertexHandle> vertices(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (used_points[i]) {
+      vertices[i] = AllocateVertex();
+    } else {
+      ShellHandle shell;
+      CreateIsolatedVertex(regions[0], &vertices[i], &shell);
+    }
+    vertices[i]->set_point(points[i]);
+  }
+  std::vector<PVertexHandle> corner_pvertices(corner_count);
+  for (unsigned int c = 0; c < corner_count; ++c) {
+    unsigned int root = FindRoot(&corner_roots, c);
+    if (corner_pvertices[root] == NULL) {
+      corner_pvertices[root] = AllocatePVertex();
+      AddPVertexToVertex(corner_pvertices[root],
+                         vertices[face_vertices[c]]);
+    }
+    corner_pvertices[c] = corner_pvertices[root];
+  }
+
+  // Make the edges. A p-vertex's parent edge is the first one that uses it.
+  std::vector<EdgeHandle> edges(edge_count);
+  for (unsigned int e = 0; e < edge_count; ++e) {
+    EdgeHandle edge = AllocateEdge();
+    PVertexHandle start_pv = corner_pvertices[edge_corners[2 * e]];
+    PVertexHandle end_pv = corner_pvertices[edge_corners[2 * e + 1]];
+    edge->set_start_pvertex(start_pv);
+    edge->set_end_pvertex(end_pv);
+    if (start_pv->parent_edge() == NULL) start_pv->set_parent_edge(edge);
+    if (end_pv->parent_edge() == NULL) end_pv->set_parent_edge(edge);
+    edges[e] = edge;
+  }
+
+  // Make the faces, each with its loop of p-edges and two mate p-faces, and a
+  // void shell per set of faces.
+  std::vector<PEdgeHandle> corner_pedges(corner_count);
+  std::vector<ShellHandle> face_shells(face_count);
+  for (unsigned int f = 0; f < face_count; ++f) {
+    unsigned int begin = face_offsets[f];
+    unsigned int end = face_offsets[f + 1];
+    FaceHandle face = AllocateFace();
+    LoopHandle loop = AllocateLoop();
+    PFaceHandle pface = AllocatePFace();
+    PFaceHandle mate_pface = AllocatePFace();
+    for (unsigned int c = begin; c < end; ++c) {
+      PEdgeHandle pe = AllocatePEdge();
+      unsigned int e = corner_edges[c];
+      bool forward = face_vertices[c] == face_vertices[edge_corners[2 * e]];
+      pe->set_orientation(forward ? Entity::kPEdgeForward :
+                                    Entity::kPEdgeReversed);
+      pe->set_parent_loop(loop);
+      pe->set_start_pvertex(corner_pvertices[c]);
+      corner_pedges[c] = pe;
+    }
+    for (unsigned int c = begin; c < end; ++c) {
+      PEdgeHandle next_pe = corner_pedges[(c + 1 < end) ? c + 1 : begin];
+      corner_pedges[c]->set_loop_next(next_pe);
+      next_pe->set_loop_previous(corner_pedges[c]);
+    }
+    loop->set_parent_face(face);
+    loop->set_boundary_pedge(corner_pedges[begin]);
+    face->set_parent_pface(pface);
+    face->set_outer_loop(loop);
+    pface->set_orientation(Entity::kPFaceForward);
+    pface->set_child_face(face);
+    pface->set_mate_pface(mate_pface);
+    mate_pface->set_orientation(Entity::kPFaceReversed);
+    mate_pface->set_child_face(face);
+    mate_pface->set_mate_pface(pface);
+
+    unsigned int root = FindRoot(&face_roots, f);
+    if (face_shells[root] == NULL) {
+      RegionHandle region = regions[(face_regions != NULL) ?
+                                    (*face_regions)[f] : 0];
+      face_shells[root] = AllocateShell();
+      AddVoidShellToOuterShell(face_shells[root], GetOuterShell(region));
+    }
+    AddPFaceToShell(pface, face_shells[root]);
+    AddPFaceToShell(mate_pface, face_shells[root]);
+  }
+
+  // Link the p-edges of each edge radially, in the order of their faces.
+  std::vector<unsigned int> edge_offsets(edge_count + 1, 0);
+  for (unsigned int c = 0; c < corner_count; ++c) {
+    ++edge_offsets[corner_edges[c] + 1];
+  }
+  for (unsigned int e = 0; e < edge_count; ++e) {
+    edge_offsets[e + 1] += edge_offsets[e];
+  }
+  std::vector<PEdgeHandle> edge_pedges(corner_count);
+  {
+    std::vector<unsigned int> next_pedge(edge_offsets.begin(),
+                                         edge_offsets.end() - 1);
+    for (unsigned int c = 0; c < corner_count; ++c) {
+      edge_pedges[next_pedge[corner_edges[c]]++] = corner_pedges[c];
+    }
+  }
+  std::vector<PEdgeHandle> radial_pedges;
+  for (unsigned int e = 0; e < edge_count; ++e) {
+    radial_pedges.assign(edge_pedges.begin() + edge_offsets[e],
+                         edge_pedges.begin() + edge_offsets[e + 1]);
+    Utils::LinkRadialPEdges(edges[e], radial_pedges);
+  }
+
+  // Validate everything once, now that it's all linked.
+  if (s_exhaustive_mode_enabled_) {
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      ValidateVertex(vertices[i]);
+    }
+    for (unsigned int e = 0; e < edge_count; ++e) {
+      ValidateEdge(edges[e]);
+    }
+    for (unsigned int c = 0; c < corner_count; ++c) {
+      ValidatePVertex(corner_pvertices[c]);
+      ValidatePEdge(corner_pedges[c]);
+    }
+    for (unsigned int f = 0; f < face_count; ++f) {
+      LoopHandle loop = corner_pedges[face_offsets[f]]->parent_loop();
+      FaceHandle face = loop->parent_face();
+      ValidateLoop(loop);
+      ValidateFace(face);
+      ValidatePFace(face->parent_pface());
+      ValidatePFace(face->parent_pface()->mate_pface());
+    }
+  }
+
+  if (new_vertices != NULL) new_vertices->swap(vertices);
+  return true;
+}
+
 // Basic (non-topological) make<Item> and Destroy<Item> functions.
-template <class TraitsType> typename PartialDS<TraitsType>::VertexHandle
-    PartialDS<TraitsType>::AllocateVertex() {
-  return AllocateItem<VertexHandle, VertexList>(&vertices_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::VertexHandle
+    PartialDS<TraitsType, StorageType>::AllocateVertex() {
+  return AllocateItem<typename Types::VertexContainer>(
+      &vertices_, &vertex_pool_, &vertex_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeVertex(VertexHandle v) {
-  FreeItem<VertexHandle, VertexList>(v, &vertices_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeVertex(VertexHandle v) {
+  FreeItem<typename Types::VertexContainer>(v, &vertices_, &vertex_pool_,
+                                            &vertex_properties_);
 }
 
-template <class TraitsType> typename PartialDS<TraitsType>::PVertexHandle
-    PartialDS<TraitsType>::AllocatePVertex() {
-  return AllocateItem<PVertexHandle, PVertexList>(&pvertices_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::PVertexHandle
+    PartialDS<TraitsType, StorageType>::AllocatePVertex() {
+  return AllocateItem<typename Types::PVertexContainer>(
+      &pvertices_, &pvertex_pool_, &pvertex_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreePVertex(PVertexHandle v) {
-  FreeItem<PVertexHandle, PVertexList>(v, &pvertices_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreePVertex(PVertexHandle v) {
+  FreeItem<typename Types::PVertexContainer>(v, &pvertices_, &pvertex_pool_,
+                                             &pvertex_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::EdgeHandle
-    PartialDS<TraitsType>::AllocateEdge() {
-  return AllocateItem<EdgeHandle, EdgeList>(&edges_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::EdgeHandle
+    PartialDS<TraitsType, StorageType>::AllocateEdge() {
+  return AllocateItem<typename Types::EdgeContainer>(
+      &edges_, &edge_pool_, &edge_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeEdge(EdgeHandle e) {
-  FreeItem<EdgeHandle, EdgeList>(e, &edges_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeEdge(EdgeHandle e) {
+  FreeItem<typename Types::EdgeContainer>(e, &edges_, &edge_pool_,
+                                          &edge_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::PEdgeHandle
-    PartialDS<TraitsType>::AllocatePEdge() {
-  return AllocateItem<PEdgeHandle, PEdgeList>(&pedges_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::PEdgeHandle
+    PartialDS<TraitsType, StorageType>::AllocatePEdge() {
+  return AllocateItem<typename Types::PEdgeContainer>(
+      &pedges_, &pedge_pool_, &pedge_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreePEdge(PEdgeHandle e) {
-  FreeItem<PEdgeHandle, PEdgeList>(e, &pedges_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreePEdge(PEdgeHandle e) {
+  FreeItem<typename Types::PEdgeContainer>(e, &pedges_, &pedge_pool_,
+                                           &pedge_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::FaceHandle
-    PartialDS<TraitsType>::AllocateFace() {
-  return AllocateItem<FaceHandle, FaceList>(&faces_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::FaceHandle
+    PartialDS<TraitsType, StorageType>::AllocateFace() {
+  return AllocateItem<typename Types::FaceContainer>(
+      &faces_, &face_pool_, &face_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeFace(FaceHandle f) {
-  FreeItem<FaceHandle, FaceList>(f, &faces_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeFace(FaceHandle f) {
+  FreeItem<typename Types::FaceContainer>(f, &faces_, &face_pool_,
+                                          &face_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::PFaceHandle
-    PartialDS<TraitsType>::AllocatePFace() {
-  return AllocateItem<PFaceHandle, PFaceList>(&pfaces_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::PFaceHandle
+    PartialDS<TraitsType, StorageType>::AllocatePFace() {
+  return AllocateItem<typename Types::PFaceContainer>(
+      &pfaces_, &pface_pool_, &pface_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreePFace(PFaceHandle f) {
-  FreeItem<PFaceHandle, PFaceList>(f, &pfaces_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreePFace(PFaceHandle f) {
+  FreeItem<typename Types::PFaceContainer>(f, &pfaces_, &pface_pool_,
+                                           &pface_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::LoopHandle
-    PartialDS<TraitsType>::AllocateLoop() {
-  return AllocateItem<LoopHandle, LoopList>(&loops_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::LoopHandle
+    PartialDS<TraitsType, StorageType>::AllocateLoop() {
+  return AllocateItem<typename Types::LoopContainer>(
+      &loops_, &loop_pool_, &loop_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeLoop(LoopHandle l) {
-  FreeItem<LoopHandle, LoopList>(l, &loops_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeLoop(LoopHandle l) {
+  FreeItem<typename Types::LoopContainer>(l, &loops_, &loop_pool_,
+                                          &loop_properties_);
 }
 
-template <class TraitsType>
-typename PartialDS<TraitsType>::ShellHandle
-    PartialDS<TraitsType>::AllocateShell() {
-  return AllocateItem<ShellHandle, ShellList>(&shells_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::ShellHandle
+    PartialDS<TraitsType, StorageType>::AllocateShell() {
+  return AllocateItem<typename Types::ShellContainer>(
+      &shells_, &shell_pool_, &shell_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeShell(ShellHandle s) {
-  FreeItem<ShellHandle, ShellList>(s, &shells_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeShell(ShellHandle s) {
+  FreeItem<typename Types::ShellContainer>(s, &shells_, &shell_pool_,
+                                           &shell_properties_);
 }
 
-template <class TraitsType> typename PartialDS<TraitsType>::RegionHandle
-    PartialDS<TraitsType>::AllocateRegion() {
-  return AllocateItem<RegionHandle, RegionList>(&regions_);
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::RegionHandle
+    PartialDS<TraitsType, StorageType>::AllocateRegion() {
+  return AllocateItem<typename Types::RegionContainer>(
+      &regions_, &region_pool_, &region_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::FreeRegion(RegionHandle r) {
-  FreeItem<RegionHandle, RegionList>(r, &regions_);
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::FreeRegion(RegionHandle r) {
+  FreeItem<typename Types::RegionContainer>(r, &regions_, &region_pool_,
+                                            &region_properties_);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::MakeWireEdge(
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::MakeWireEdge(
     VertexHandle start_v, VertexHandle end_v,
     EdgeHandle* new_edge, PFaceHandle* new_pface) {
 
@@ -546,8 +844,8 @@ void PartialDS<TraitsType>::MakeWireEdge(
   *new_pface = pface;
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DestroyWireEdge(EdgeHandle e) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DestroyWireEdge(EdgeHandle e) {
   // It must be either a 'real' wire edge or an edge associated with an
   // isolated vertex.
   assert(e->IsWireEdge() || e->start_pvertex()->vertex()->IsIsolated());
@@ -574,9 +872,9 @@ void PartialDS<TraitsType>::DestroyWireEdge(EdgeHandle e) {
   FreeEdge(e);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::AddPVertexToVertex(PVertexHandle pv,
-                                               VertexHandle v) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::AddPVertexToVertex(PVertexHandle pv,
+                                                            VertexHandle v) {
   PVertexHandle pv_list_head = v->parent_pvertex();
   pv->set_vertex(v);
   if (pv_list_head == NULL) {
@@ -590,8 +888,9 @@ void PartialDS<TraitsType>::AddPVertexToVertex(PVertexHandle pv,
   }
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::RemovePVertexFromVertex(PVertexHandle pv) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::RemovePVertexFromVertex(
+    PVertexHandle pv) {
   VertexHandle v = pv->vertex();
   if (v != NULL) {
     if (pv->next_pvertex() == pv) {
@@ -622,8 +921,9 @@ void PartialDS<TraitsType>::RemovePVertexFromVertex(PVertexHandle pv) {
   }
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::AddPFaceToShell(PFaceHandle pf, ShellHandle shell) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::AddPFaceToShell(
+    PFaceHandle pf, ShellHandle shell) {
   // Add pf to shell's circular list of p-faces.
   if (shell->pface() == NULL) {
     shell->set_pface(pf);
@@ -635,8 +935,8 @@ void PartialDS<TraitsType>::AddPFaceToShell(PFaceHandle pf, ShellHandle shell) {
   pf->set_parent_shell(shell);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::RemovePFaceFromShell(PFaceHandle pf) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::RemovePFaceFromShell(PFaceHandle pf) {
   // Get the parent shell from the pface.
   ShellHandle shell = pf->parent_shell();
   assert(shell != NULL);
@@ -666,17 +966,17 @@ void PartialDS<TraitsType>::RemovePFaceFromShell(PFaceHandle pf) {
   pf->set_parent_shell(NULL);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::AddVoidShellToOuterShell(ShellHandle void_shell,
-                                                     ShellHandle shell) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::AddVoidShellToOuterShell(
+    ShellHandle void_shell, ShellHandle shell) {
   assert(!shell->IsVoidShell());
   void_shell->set_parent_region(shell->parent_region());
   void_shell->set_next_void_shell(shell->next_void_shell());
   shell->set_next_void_shell(void_shell);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::RemoveVoidShellFromOuterShell(
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::RemoveVoidShellFromOuterShell(
     ShellHandle void_shell) {
   assert(void_shell->IsVoidShell());
   if (!void_shell->IsVoidShell()) return;
@@ -694,8 +994,8 @@ void PartialDS<TraitsType>::RemoveVoidShellFromOuterShell(
   }
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::AddPEdgeToEdge(
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::AddPEdgeToEdge(
     PEdgeHandle pe, EdgeHandle edge, PEdgeHandle after_pe) {
   // If an after_pe p-edge is given, let's make sure it's valid. If none
   // is given, we'll use the edge's parent p-edge.
@@ -721,8 +1021,8 @@ void PartialDS<TraitsType>::AddPEdgeToEdge(
   }
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::RemovePEdgeFromEdge(PEdgeHandle pe) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::RemovePEdgeFromEdge(PEdgeHandle pe) {
   EdgeHandle edge = pe->child_edge();
   assert(edge != NULL);
   if (pe->radial_next() == pe) {
@@ -742,8 +1042,8 @@ void PartialDS<TraitsType>::RemovePEdgeFromEdge(PEdgeHandle pe) {
   pe->set_radial_previous(NULL);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DestroyVertexCloud(VertexHandle v) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DestroyVertexCloud(VertexHandle v) {
   PVertexOfVertexCirculator start_pv = v->pvertex_begin();
   PVertexOfVertexCirculator del_pv = start_pv;
   // Skip start_pv for now; it's our end-of-loop marker.
@@ -757,8 +1057,8 @@ void PartialDS<TraitsType>::DestroyVertexCloud(VertexHandle v) {
   FreeVertex(v);
 }
 
-template <class TraitsType>
-void PartialDS<TraitsType>::DestroyEdgeCloud(EdgeHandle e) {
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::DestroyEdgeCloud(EdgeHandle e) {
   PEdgeRadialCirculator start_pe = e->pedge_begin();
   PEdgeRadialCirculator del_pe = start_pe;
   // Skip start_pe for now; it's our end-of-loop marker.
@@ -772,9 +1072,45 @@ void PartialDS<TraitsType>::DestroyEdgeCloud(EdgeHandle e) {
   FreeEdge(e);
 }
 
+template <class TraitsType, class StorageType>
+typename PartialDS<TraitsType, StorageType>::ShellHandle
+    PartialDS<TraitsType, StorageType>::GetOuterShell(RegionHandle region) {
+  ShellHandle outer_shell = region->outer_shell();
+  if (outer_shell == NULL) {
+    outer_shell = AllocateShell();
+    region->set_outer_shell(outer_shell);
+    outer_shell->set_parent_region(region);
+  }
+  return outer_shell;
+}
+
+template <class TraitsType, class StorageType>
+unsigned int PartialDS<TraitsType, StorageType>::FindRoot(
+    std::vector<unsigned int>* parents, unsigned int i) {
+  while ((*parents)[i] != i) {
+    (*parents)[i] = (*parents)[(*parents)[i]];
+    i = (*parents)[i];
+  }
+  return i;
+}
+
+template <class TraitsType, class StorageType>
+void PartialDS<TraitsType, StorageType>::JoinRoots(
+    std::vector<unsigned int>* parents, unsigned int i, unsigned int j) {
+  i = FindRoot(parents, i);
+  j = FindRoot(parents, j);
+  // Keep the lower index as the root, so that the first corner or face of a
+  // set represents it.
+  if (i < j) {
+    (*parents)[j] = i;
+  } else {
+    (*parents)[i] = j;
+  }
+}
+
 // Validation functions.
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidateVertex(VertexConstHandle v) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidateVertex(VertexConstHandle v) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check that there is a parent pvertex.
   if (v->parent_pvertex() == NULL) {
@@ -801,8 +1137,9 @@ bool PartialDS<TraitsType>::ValidateVertex(VertexConstHandle v) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidatePVertex(PVertexConstHandle pv) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidatePVertex(
+    PVertexConstHandle pv) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check that parent edge links down to this pvertex.
   EdgeConstHandle parent_edge = pv->parent_edge();
@@ -824,8 +1161,8 @@ bool PartialDS<TraitsType>::ValidatePVertex(PVertexConstHandle pv) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidateEdge(EdgeConstHandle e) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidateEdge(EdgeConstHandle e) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check that parent pedge points down to this edge.
   PEdgeConstHandle parent_pedge = e->parent_pedge();
@@ -837,9 +1174,13 @@ bool PartialDS<TraitsType>::ValidateEdge(EdgeConstHandle e) {
     assert(!"*** ValidateEdge: parent pedge does not point to edge. ***");
     return false;
   }
-  // Check that start and end pvertex point to this edge.
+  // Check that start and end pvertex exist, and that the start pvertex of a
+  // wire edge or isolated vertex points to this edge. The edges of real faces
+  // share their p-vertices with the other edges around the vertex, and a
+  // p-vertex only points to one of these edges.
   PVertexConstHandle v = e->start_pvertex();
-  if (v == NULL || v->parent_edge() != e) {
+  bool degenerate = parent_pedge->parent_loop()->parent_face()->IsDegenerate();
+  if (v == NULL || (degenerate && v->parent_edge() != e)) {
     assert(!"*** ValidateEdge: start vertex is null or points"
             " to wrong edge. ***");
     return false;
@@ -853,8 +1194,8 @@ bool PartialDS<TraitsType>::ValidateEdge(EdgeConstHandle e) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidatePEdge(PEdgeConstHandle pe) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidatePEdge(PEdgeConstHandle pe) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check that child edge links to this edge.
   LoopConstHandle loop = pe->parent_loop();
@@ -905,8 +1246,8 @@ bool PartialDS<TraitsType>::ValidatePEdge(PEdgeConstHandle pe) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidateLoop(LoopConstHandle loop) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidateLoop(LoopConstHandle loop) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Ensure the loop points to a valid p-edge.
   PEdgeConstHandle scan_pedge = loop->boundary_pedge();
@@ -941,8 +1282,8 @@ bool PartialDS<TraitsType>::ValidateLoop(LoopConstHandle loop) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidateFace(FaceConstHandle f) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidateFace(FaceConstHandle f) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check the outer loop.
   if (f->outer_loop() == NULL) {
@@ -966,8 +1307,8 @@ bool PartialDS<TraitsType>::ValidateFace(FaceConstHandle f) {
   return true;
 }
 
-template <class TraitsType>
-bool PartialDS<TraitsType>::ValidatePFace(PFaceConstHandle pf) {
+template <class TraitsType, class StorageType>
+bool PartialDS<TraitsType, StorageType>::ValidatePFace(PFaceConstHandle pf) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Check the parent shell.
   if (pf->parent_shell() == NULL) {
@@ -1016,9 +1357,10 @@ bool PartialDS<TraitsType>::ValidatePFace(PFaceConstHandle pf) {
   return true;
 }
 
-template <class TraitsType>
+template <class TraitsType, class StorageType>
 template <class EdgeListType>
-bool PartialDS<TraitsType>::ValidateEdgeCycle(const EdgeListType& cycle) {
+bool PartialDS<TraitsType, StorageType>::ValidateEdgeCycle(
+    const EdgeListType& cycle) {
 #if defined(_DEBUG) || defined(_GEOM_TESTS)
   // Verify that all the edges in cycle form a complete loop. v0 is the first
   // vertex along the cycle, vi is the 'exploring' vertex as we move along
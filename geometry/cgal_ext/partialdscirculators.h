@@ -37,11 +37,13 @@ class PEdgeLoopCirculator : public It {
 
   bool operator==(CGAL::Nullptr_t p) const {
     assert(p == NULL);
-    return It::operator==(It());
+    return static_cast<const It&>(*this) == It();
   }
   bool operator!=(CGAL::Nullptr_t p) const { return !(*this == p); }
-  bool operator==(const Self& i)    const { return  It::operator==(i); }
-  bool operator!=(const Self& i)    const { return !(*this == i); }
+  bool operator==(const Self& i) const {
+    return static_cast<const It&>(*this) == static_cast<const It&>(i);
+  }
+  bool operator!=(const Self& i) const { return !(*this == i); }
 
   Self& operator++() {
     *(static_cast<Iterator*>(this)) = (*this)->loop_next();
@@ -89,11 +91,13 @@ class PEdgeRadialCirculator : public It {
 
   bool operator==(CGAL::Nullptr_t p) const {
     assert(p == NULL);
-    return It::operator==(It());
+    return static_cast<const It&>(*this) == It();
   }
   bool operator!=(CGAL::Nullptr_t p) const { return !(*this == p); }
-  bool operator==(const Self& i)    const { return  It::operator==(i); }
-  bool operator!=(const Self& i)    const { return !(*this == i); }
+  bool operator==(const Self& i) const {
+    return static_cast<const It&>(*this) == static_cast<const It&>(i);
+  }
+  bool operator!=(const Self& i) const { return !(*this == i); }
 
   Self& operator++() {
     *(static_cast<Iterator*>(this)) = (*this)->radial_next();
@@ -140,11 +144,13 @@ class PVertexOfVertexCirculator : public It {
 
   bool operator==(CGAL::Nullptr_t p) const {
     assert(p == NULL);
-    return It::operator==(It());
+    return static_cast<const It&>(*this) == It();
   }
   bool operator!=(CGAL::Nullptr_t p) const { return !(*this == p); }
-  bool operator==(const Self& i)    const { return  It::operator==(i); }
-  bool operator!=(const Self& i)    const { return !(*this == i); }
+  bool operator==(const Self& i) const {
+    return static_cast<const It&>(*this) == static_cast<const It&>(i);
+  }
+  bool operator!=(const Self& i) const { return !(*this == i); }
 
   Self& operator++() {
     *(static_cast<Iterator*>(this)) = (*this)->next_pvertex();
@@ -181,11 +187,13 @@ class PFaceOfShellCirculator : public It {
 
   bool operator==(CGAL::Nullptr_t p) const {
     assert(p == NULL);
-    return It::operator==(It());
+    return static_cast<const It&>(*this) == It();
   }
   bool operator!=(CGAL::Nullptr_t p) const { return !(*this == p); }
-  bool operator==(const Self& i)    const { return  It::operator==(i); }
-  bool operator!=(const Self& i)    const { return !(*this == i); }
+  bool operator==(const Self& i) const {
+    return static_cast<const It&>(*this) == static_cast<const It&>(i);
+  }
+  bool operator!=(const Self& i) const { return !(*this == i); }
 
   Self& operator++() {
     *(static_cast<Iterator*>(this)) = (*this)->next_pface();
@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 template <class T> class PartialDSUtils;
 
 // PartialDSEdge: template class for edge entity in the partial-entity
@@ -42,7 +42,8 @@ class PartialDSEdge : public PartialDSEntity<TypeRefs> {
                                                   PEdgeRadialCirculator;
 
   PartialDSEdge()
-    : parent_pedge_(NULL), start_pvertex_(NULL), end_pvertex_(NULL) { }
+    : parent_pedge_(NULL), start_pvertex_(NULL), end_pvertex_(NULL),
+      visit_mark_(0) { }
 
   // Accessors
   PEdgeConstHandle parent_pedge() const { return parent_pedge_; }
@@ -103,7 +104,8 @@ class PartialDSEdge : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
   friend class PartialDSUtils<PartialDSTypes>;
 
   // Mutators
@@ -111,10 +113,16 @@ class PartialDSEdge : public PartialDSEntity<TypeRefs> {
   void set_start_pvertex(PVertexHandle pv) { start_pvertex_ = pv; }
   void set_end_pvertex(PVertexHandle pv) { end_pvertex_ = pv; }
 
+  // Traversal mark, see PartialDS::NextVisitMark. It is not part of the
+  // topology, so it can be updated on const edges.
+  unsigned int visit_mark() const { return visit_mark_; }
+  void set_visit_mark(unsigned int mark) const { visit_mark_ = mark; }
+
  private:
   PEdgeHandle parent_pedge_;
   PVertexHandle start_pvertex_;
   PVertexHandle end_pvertex_;
+  mutable unsigned int visit_mark_;
 };
 
 }  // namespace geometry
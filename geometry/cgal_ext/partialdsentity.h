@@ -10,6 +10,8 @@
 namespace ginsu {
 namespace geometry {
 
+template <class T, class S> class PartialDS;
+
 // PartialDSEntity: template class for an entity in the partial-entity data
 // structure. It serves as a base class for all the entities, vertex, edges,
 // etc. in the data structure. The template paramater is:
@@ -39,9 +41,21 @@ class PartialDSEntity {
   typedef TypeRefs                  PartialDS;
   typedef PartialDSEntity<TypeRefs> Base;
 
+  PartialDSEntity() : id_(0) { }
+
+  // The id of the entity, dense among the entities of its kind. Attributes
+  // are kept in arrays indexed by id (see partialdsproperties.h).
+  unsigned int id() const { return id_; }
+
+ protected:
+  friend class ginsu::geometry::PartialDS<typename TypeRefs::Traits,
+                                          typename TypeRefs::Storage>;
+
+  // Mutators
+  void set_id(unsigned int id) { id_ = id; }
+
  private:
-  // TODO(gwink): We may need to store an ID and attributes for each entity.
-  // If not, get rid of this private section.
+  unsigned int id_;
 };
 
 }  // namespace geometry
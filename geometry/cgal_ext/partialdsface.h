@@ -10,7 +10,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 
 // PartialDSFace: template class for face entity in the partial-entity
 // data structure. The template parameters are:
@@ -44,7 +44,8 @@ class PartialDSFace : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
 
   // Mutators
   void set_parent_pface(PFaceHandle pface) { parent_pface_ = pface; }
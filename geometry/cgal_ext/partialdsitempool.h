@@ -0,0 +1,98 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GINSU_GEOMETRY_CGAL_EXT_PARTIALDSITEMPOOL_H_
+#define GINSU_GEOMETRY_CGAL_EXT_PARTIALDSITEMPOOL_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace ginsu {
+namespace geometry {
+
+// PartialDSItemPool: storage for the items of one type, vertices, edges, etc.,
+// of a single PartialDS. Items are carved out of chunks of chunk_size items,
+// freed items are kept on a free list for reuse, and the chunks are only
+// released, all at once, when the pool is destroyed. This replaces a heap
+// allocation per item with a pointer bump or a free-list pop, and keeps the
+// items of a model close together in memory.
+// A chunk_size of 0 turns pooling off: each item then gets its own
+// allocation, which is freed with the item. This is slower, but lets memory
+// checkers see each item.
+// The pool only deals with storage: items must be constructed after Allocate
+// and destroyed before Free, and all must be destroyed before the pool is.
+// Template parameters:
+// - Item: the item type, e.g. PartialDSTypes::Vertex. Items must be at least
+//   as large as a pointer, which is used to link free items.
+// - Allocator: where the chunks come from, e.g. PartialDSTypes::
+//   VertexAllocator.
+template <class Item, class Allocator>
+class PartialDSItemPool {
+ public:
+  explicit PartialDSItemPool(size_t chunk_size)
+      : chunk_size_(chunk_size),
+        next_(NULL),
+        end_(NULL),
+        free_list_(NULL) {}
+
+  ~PartialDSItemPool() {
+    for (size_t i = 0; i < chunks_.size(); ++i)
+      allocator_.deallocate(chunks_[i], chunk_size_);
+  }
+
+  // Return storage for one item.
+  Item* Allocate() {
+    if (chunk_size_ == 0)
+      return allocator_.allocate(1);
+    if (free_list_ != NULL) {
+      Item* item = reinterpret_cast<Item*>(free_list_);
+      free_list_ = free_list_->next;
+      return item;
+    }
+    if (next_ == end_) {
+      next_ = allocator_.allocate(chunk_size_);
+      end_ = next_ + chunk_size_;
+      chunks_.push_back(next_);
+    }
+    return next_++;
+  }
+
+  // Give back the storage of a destroyed item.
+  void Free(Item* item) {
+    if (chunk_size_ == 0) {
+      allocator_.deallocate(item, 1);
+      return;
+    }
+    FreeLink* link = reinterpret_cast<FreeLink*>(item);
+    link->next = free_list_;
+    free_list_ = link;
+  }
+
+  size_t chunk_size() const { return chunk_size_; }
+  size_t chunk_count() const { return chunks_.size(); }
+
+ private:
+  // A free item, linked to the next one.
+  struct FreeLink {
+    FreeLink* next;
+  };
+
+  // Not copyable: the items belong to this pool.
+  PartialDSItemPool(const PartialDSItemPool&);
+  void operator=(const PartialDSItemPool&);
+
+  Allocator allocator_;
+  const size_t chunk_size_;
+  // Unused items at the end of the last chunk.
+  Item* next_;
+  Item* end_;
+  FreeLink* free_list_;
+  std::vector<Item*> chunks_;
+};
+
+}  // namespace geometry
+}  // namespace ginsu
+
+#endif  // GINSU_GEOMETRY_CGAL_EXT_PARTIALDSITEMPOOL_H_
@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 
 // PartialDSLoop: template class for loop entity in the partial-entity
 // data structure. The template parameter is:
@@ -75,7 +75,8 @@ class PartialDSLoop : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
 
   // Mutators
   void set_parent_face(FaceHandle face) { parent_face_ = face; }
@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 template <class T> class PartialDSUtils;
 
 // PartialDSEdge: template class for edge entity in the partial-entity
@@ -67,7 +67,8 @@ class PartialDSPEdge : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
   friend class PartialDSUtils<PartialDSTypes>;
 
   // Mutators
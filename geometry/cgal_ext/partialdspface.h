@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 
 // PartialDSFace: template class for face entity in the partial-entity
 // data structure. The template parameters are:
@@ -48,7 +48,8 @@ class PartialDSPFace : public PartialDSEntity<TypeRefs> {
   PFaceConstHandle mate_pface() const { return mate_pface_; }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
 
   // Mutators
   void set_orientation(PFaceOrientation orientation) {
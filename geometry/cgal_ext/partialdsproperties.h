@@ -0,0 +1,196 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Per-entity attributes for a PartialDS, such as colors, material ids,
+// selection bits or cached normals. Rather than widening the entities, each
+// attribute is kept in its own contiguous array, indexed by entity id.
+//
+// Every entity gets an id when it is allocated, which is unique among the
+// live entities of its kind. Freed ids are handed out again first, so the ids
+// stay dense: they are all below the largest number of entities of that kind
+// the model ever held at once.
+//
+// A PartialDSProperties holds the ids of one kind of entity and the property
+// arrays attached to it. Properties are added and removed at any time:
+//
+//   PartialDSPropertyMap<Color> colors =
+//       mesh.face_properties()->AddProperty(Color(0, 0, 0));
+//   colors[face] = Color(1, 0, 0);
+//   ...
+//   mesh.face_properties()->RemoveProperty(&colors);
+//
+// A property map can also be walked in bulk, by id, skipping the ids that no
+// entity holds:
+//
+//   for (size_t id = 0; id < colors.size(); ++id) {
+//     if (mesh.face_properties()->IsIdUsed(id)) Blend(colors.begin()[id]);
+//   }
+
+#ifndef GINSU_GEOMETRY_CGAL_EXT_PARTIALDSPROPERTIES_H_
+#define GINSU_GEOMETRY_CGAL_EXT_PARTIALDSPROPERTIES_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace ginsu {
+namespace geometry {
+
+template <class T, class S> class PartialDS;
+class PartialDSProperties;
+
+// PartialDSPropertyArrayBase: the part of a property array that doesn't
+// depend on the value type, so that PartialDSProperties can keep arrays of
+// different types together.
+class PartialDSPropertyArrayBase {
+ public:
+  virtual ~PartialDSPropertyArrayBase() {}
+
+  // Grow the array to size values, all new ones being the default value.
+  virtual void Resize(size_t size) = 0;
+  // Set the value of id back to the default value.
+  virtual void Reset(size_t id) = 0;
+};
+
+// PartialDSPropertyArray: the values of one property, indexed by id.
+template <class T>
+class PartialDSPropertyArray : public PartialDSPropertyArrayBase {
+ public:
+  PartialDSPropertyArray(const T& default_value, size_t size)
+      : default_value_(default_value), values_(size, default_value) {}
+
+  virtual void Resize(size_t size) { values_.resize(size, default_value_); }
+  virtual void Reset(size_t id) { values_[id] = default_value_; }
+
+  std::vector<T>* values() { return &values_; }
+
+ private:
+  const T default_value_;
+  std::vector<T> values_;
+};
+
+// PartialDSPropertyMap: a typed handle to a property array, returned by
+// PartialDSProperties::AddProperty. It is cheap to copy, and becomes invalid
+// when the property is removed or the model destroyed.
+// Template parameter:
+// - T: the value type. As with std::vector, bool values are packed, and
+//   accessed through proxy references.
+template <class T>
+class PartialDSPropertyMap {
+ public:
+  typedef typename std::vector<T>::reference      Reference;
+  typedef typename std::vector<T>::const_reference ConstReference;
+  typedef typename std::vector<T>::iterator       Iterator;
+  typedef typename std::vector<T>::const_iterator ConstIterator;
+
+  PartialDSPropertyMap() : array_(NULL) {}
+
+  bool IsNull() const { return array_ == NULL; }
+
+  // The value of an entity, given its handle.
+  template <class Handle>
+  Reference operator[](Handle entity) const {
+    return (*array_->values())[entity->id()];
+  }
+
+  // Bulk access: the values of all ids, including those that no entity
+  // currently holds.
+  size_t size() const { return array_->values()->size(); }
+  Iterator begin() const { return array_->values()->begin(); }
+  Iterator end() const { return array_->values()->end(); }
+
+ private:
+  friend class PartialDSProperties;
+
+  explicit PartialDSPropertyMap(PartialDSPropertyArray<T>* array)
+      : array_(array) {}
+
+  PartialDSPropertyArray<T>* array_;
+};
+
+// PartialDSProperties: the ids of one kind of entity, and the property arrays
+// indexed by them. Each PartialDS has one per kind of entity.
+class PartialDSProperties {
+ public:
+  PartialDSProperties() {}
+
+  ~PartialDSProperties() {
+    for (size_t i = 0; i < arrays_.size(); ++i)
+      delete arrays_[i];
+  }
+
+  // The number of ids handed out so far, live or not, which is also the size
+  // of each property array.
+  size_t id_count() const { return used_ids_.size(); }
+  // Return true if id is held by a live entity.
+  bool IsIdUsed(size_t id) const {
+    return id < used_ids_.size() && used_ids_[id];
+  }
+
+  size_t property_count() const { return arrays_.size(); }
+
+  // Add a property. Every entity, existing or future, starts with
+  // default_value.
+  template <class T>
+  PartialDSPropertyMap<T> AddProperty(const T& default_value) {
+    PartialDSPropertyArray<T>* array =
+        new PartialDSPropertyArray<T>(default_value, id_count());
+    arrays_.push_back(array);
+    return PartialDSPropertyMap<T>(array);
+  }
+
+  // Remove a property, releasing its values, and set *property to NULL.
+  template <class T>
+  void RemoveProperty(PartialDSPropertyMap<T>* property) {
+    std::vector<PartialDSPropertyArrayBase*>::iterator i =
+        std::find(arrays_.begin(), arrays_.end(), property->array_);
+    assert(i != arrays_.end() && "Not a property of this kind of entity.");
+    if (i == arrays_.end()) return;
+    delete *i;
+    arrays_.erase(i);
+    property->array_ = NULL;
+  }
+
+ private:
+  template <class T, class S> friend class PartialDS;
+
+  // Not copyable: the property maps point into this.
+  PartialDSProperties(const PartialDSProperties&);
+  void operator=(const PartialDSProperties&);
+
+  // Return an id for a new entity, whose properties all have their default
+  // values.
+  unsigned int AllocateId() {
+    if (free_ids_.empty()) {
+      unsigned int id = used_ids_.size();
+      used_ids_.push_back(true);
+      for (size_t i = 0; i < arrays_.size(); ++i)
+        arrays_[i]->Resize(used_ids_.size());
+      return id;
+    }
+    unsigned int id = free_ids_.back();
+    free_ids_.pop_back();
+    used_ids_[id] = true;
+    for (size_t i = 0; i < arrays_.size(); ++i)
+      arrays_[i]->Reset(id);
+    return id;
+  }
+
+  // Give back the id of a freed entity.
+  void FreeId(unsigned int id) {
+    assert(IsIdUsed(id));
+    used_ids_[id] = false;
+    free_ids_.push_back(id);
+  }
+
+  std::vector<bool> used_ids_;
+  std::vector<unsigned int> free_ids_;
+  std::vector<PartialDSPropertyArrayBase*> arrays_;
+};
+
+}  // namespace geometry
+}  // namespace ginsu
+
+#endif  // GINSU_GEOMETRY_CGAL_EXT_PARTIALDSPROPERTIES_H_
@@ -10,7 +10,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 template <class T> class PartialDSUtils;
 
 // PartialDSPVertex: template class for p-vertex entity in the partial-entity
@@ -44,7 +44,8 @@ class PartialDSPVertex : public PartialDSEntity<TypeRefs> {
   PVertexHandle next_pvertex() { return next_pvertex_; }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
   friend class PartialDSUtils<PartialDSTypes>;
 
   // Mutators
@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 
 // PartialDSRegion: template class for region entity in the partial-entity
 // data structure. The template parameters are:
@@ -61,7 +61,8 @@ class PartialDSRegion : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
 
   // Mutators
   void set_flavor(RegionFlavor flavor) { flavor_ = flavor; }
@@ -10,7 +10,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 template <class T> class PartialDSRegion;
 
 // PartialDSShell: template class for shell entity in the partial-entity
@@ -71,7 +71,8 @@ class PartialDSShell : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
 
   // Mutators
   void set_next_void_shell(ShellHandle shell) { next_void_shell_ = shell; }
@@ -0,0 +1,157 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Storage policies for the entities of a PartialDS. A policy decides which
+// container each kind of entity lives in, and therefore what the handles
+// are. Two policies are provided:
+//
+// PartialDSListStorage: the default. Each entity is kept in a doubly-linked
+// cgal In_place_list, and carved out of a per-model PartialDSItemPool.
+//
+// PartialDSCompactStorage: each entity is kept in a cgal Compact_container,
+// which stores the entities in contiguous blocks and reuses freed slots. An
+// entity then only carries one extra pointer instead of two, and iterating
+// over the entities of a model walks memory in order.
+//
+// Either way, handles are iterators into the container: they can be compared
+// to NULL and dereferenced without going through the model, which is what
+// the entities and the Euler operators rely on.
+//
+// A policy has a single member template, Container<Item>, with:
+// - Value: the type actually stored, i.e. Item plus container bookkeeping;
+// - Allocator: the allocator for Value;
+// - List: the container type, exposing begin(), end(), size() and iterator;
+// - Pool: whatever extra storage the policy needs per entity kind, which is
+//   constructed from the PartialDS items_per_chunk;
+// - Allocate, Free and FreeAll: static functions to create an entity, destroy
+//   one, and destroy all of them.
+
+#ifndef GINSU_GEOMETRY_CGAL_EXT_PARTIALDSSTORAGE_H_
+#define GINSU_GEOMETRY_CGAL_EXT_PARTIALDSSTORAGE_H_
+
+#include <cstddef>
+#include "CGAL/basic.h"
+#include "CGAL/Compact_container.h"
+#include "CGAL/In_place_list.h"
+#include "CGAL/memory.h"
+#include "geometry/cgal_ext/partialdsitempool.h"
+
+namespace ginsu {
+namespace geometry {
+
+// PartialDSListItem: This template class relies on cgal's In_place_list and
+// multiple-inheritance to add d-link pointers to the Item class. As such, it
+// allows an iterator into the d-list to also act as an Item handle (i.e. a
+// pointer to Item).
+// Template parameter:
+// - Item: The item type that needs to be inserted into a doubly-linked list,
+//   most likely a vertex, edge, face, etc.
+template <class Item>
+class PartialDSListItem :
+    public Item,
+    public CGAL::In_place_list_base<PartialDSListItem<Item> > {
+ public:
+  typedef PartialDSListItem<Item> Self;
+
+  PartialDSListItem() {}
+  explicit PartialDSListItem(const Item& v) : Item(v) {}
+
+  // Assignment operator: copy item data without affecting the dlist pointers.
+  Self& operator=(const Self& v) {
+    *(static_cast<Item*>(this)) = ((const Item&)v);
+    return *this;
+  }
+};
+
+// PartialDSCompactItem: Same as PartialDSListItem for cgal's
+// Compact_container, which needs a single pointer per item. The container
+// uses it to mark free slots and block boundaries.
+template <class Item>
+class PartialDSCompactItem :
+    public Item,
+    public CGAL::Compact_container_base {
+ public:
+  typedef PartialDSCompactItem<Item> Self;
+
+  PartialDSCompactItem() {}
+  explicit PartialDSCompactItem(const Item& v) : Item(v) {}
+
+  // Assignment operator: copy item data without affecting the container
+  // pointer.
+  Self& operator=(const Self& v) {
+    *(static_cast<Item*>(this)) = ((const Item&)v);
+    return *this;
+  }
+};
+
+// PartialDSListStorage: entities in In_place_lists, with storage from a
+// PartialDSItemPool.
+class PartialDSListStorage {
+ public:
+  template <class Item>
+  class Container {
+   public:
+    typedef PartialDSListItem<Item>                     Value;
+    typedef CGAL_ALLOCATOR(Value)                       Allocator;
+    typedef CGAL::In_place_list<Value, false, Allocator> List;
+    typedef typename List::iterator                     Handle;
+    typedef PartialDSItemPool<Value, Allocator>         Pool;
+
+    static Handle Allocate(List* list, Pool* pool) {
+      Value* item = pool->Allocate();
+      new (item) Value();
+      list->push_front(*item);
+      return list->begin();
+    }
+
+    static void Free(Handle item, List* list, Pool* pool) {
+      Value* pointer = &*item;
+      list->erase(item);
+      pointer->~Value();
+      pool->Free(pointer);
+    }
+
+    static void FreeAll(List* list, Pool* pool) {
+      while (!list->empty())
+        Free(list->begin(), list, pool);
+    }
+  };
+};
+
+// PartialDSCompactStorage: entities in Compact_containers. The container
+// allocates its own blocks, growing them as it fills up, so there is no pool
+// and items_per_chunk is ignored.
+class PartialDSCompactStorage {
+ public:
+  template <class Item>
+  class Container {
+   public:
+    typedef PartialDSCompactItem<Item>                  Value;
+    typedef CGAL_ALLOCATOR(Value)                       Allocator;
+    typedef CGAL::Compact_container<Value, Allocator>   List;
+    typedef typename List::iterator                     Handle;
+
+    class Pool {
+     public:
+      explicit Pool(size_t /* items_per_chunk */) {}
+    };
+
+    static Handle Allocate(List* list, Pool* /* pool */) {
+      return list->emplace();
+    }
+
+    static void Free(Handle item, List* list, Pool* /* pool */) {
+      list->erase(item);
+    }
+
+    static void FreeAll(List* list, Pool* /* pool */) {
+      list->clear();
+    }
+  };
+};
+
+}  // namespace geometry
+}  // namespace ginsu
+
+#endif  // GINSU_GEOMETRY_CGAL_EXT_PARTIALDSSTORAGE_H_
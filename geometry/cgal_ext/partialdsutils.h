@@ -5,7 +5,7 @@
 #ifndef GINSU_GEOMETRY_CGAL_EXT_PARTIALDS_UTILS_INL_H_
 #define GINSU_GEOMETRY_CGAL_EXT_PARTIALDS_UTILS_INL_H_
 
-#include <boost/tr1/unordered_set.hpp>
+#include <vector>
 
 namespace ginsu {
 namespace geometry {
@@ -32,14 +32,6 @@ class PartialDSUtils {
   typedef typename Types::VertexBase::PVertexCirculator
                                            PVertexOfVertexCirculator;
 
-  // A hash-set for EdgeHandle; used for traversals.
-  struct HashEdgeHandle {
-      size_t operator()(EdgeConstHandle e) const {
-          return reinterpret_cast<size_t>(&(*e));
-      }
-  };
-  typedef std::tr1::unordered_set<EdgeHandle, HashEdgeHandle> EdgeHandleSet;
-
   // LinkPVertices:
   // Link vertex to one of the p-vertices and all p-vertices together into
   // a cloud around vertex.
@@ -68,12 +60,12 @@ class PartialDSUtils {
   // Link all p-edges together as a doubly-link list about edge, each p-edge
   // to edge as a child, and edge to one of the p-edges as parent.
   template <class PEdgeList>
-  static void LinkRadialPEdges(EdgeHandle edge, PEdgeList pedges) {
+  static void LinkRadialPEdges(EdgeHandle edge, const PEdgeList& pedges) {
     if (pedges.empty()) return;
 
     edge->set_parent_pedge(pedges.front());
-    typename PEdgeList::iterator current = pedges.begin();
-    typename PEdgeList::iterator next = current + 1;
+    typename PEdgeList::const_iterator current = pedges.begin();
+    typename PEdgeList::const_iterator next = current + 1;
     while (current != pedges.end()) {
       if (next != pedges.end()) {
         (*current)->set_radial_next(*next);
@@ -124,77 +116,115 @@ class PartialDSUtils {
   }
 
   // GetIncidentEdgeCount:
-  // Get the number of edges incident upon a vertex.
-  static int GetIncidentEdgeCount(VertexHandle vertex) {
+  // Get the number of edges incident upon a vertex. See VisitVertexEdges for
+  // visit_mark.
+  static int GetIncidentEdgeCount(VertexHandle vertex,
+                                  unsigned int visit_mark) {
     if (vertex->IsIsolated()) {
       return 0;
     } else {
-      std::vector<EdgeHandle> incident_edges;
-      VisitVertexEdges(vertex, &incident_edges);
-      return static_cast<int>(incident_edges.size());
+      EdgeCounter counter;
+      VisitVertexEdges(vertex, visit_mark, &counter);
+      return counter.count;
     }
   }
 
   // VisitVertexEdges:
   // Visit all edges incident upon vertex, accumulating them into list |edges|.
   // Template class EdgeList is a container that supports push_back, such as
-  // list or vector. To count incident edges, it could also be a custom class
-  // that increment a counter each time push_back is called.
+  // list or vector. Each edge is listed once, in no particular order.
+  // Visited edges are tagged with visit_mark, which no edge of the model may
+  // carry yet (see PartialDS::NextVisitMark), and the edges that are left to
+  // follow are kept on an EdgeStack, so this doesn't allocate unless the
+  // vertex has many non-manifold edges.
   template <class EdgeList>
-  static void VisitVertexEdges(VertexHandle vertex, EdgeList* edges) {
-    // We keep track of visited edges in a set rather than tagging them.
-    EdgeHandleSet visited_edges;
+  static void VisitVertexEdges(VertexHandle vertex, unsigned int visit_mark,
+                               EdgeList* edges) {
+    const unsigned int mark = visit_mark;
+    EdgeStack pending;
     // Visit all p-vertices of vertex. For each such p-vertex, visit the
     // incident edges.
     PVertexOfVertexCirculator start_pv = vertex->pvertex_begin();
     PVertexOfVertexCirculator current_pv = start_pv;
     do {
-      VisitVertexEdgesHelper(current_pv, current_pv->parent_edge(),
-                             &visited_edges);
+      PVertexHandle pvertex = current_pv;
+      EdgeHandle edge = pvertex->parent_edge();
+      if (edge->visit_mark() != mark) {
+        edge->set_visit_mark(mark);
+        edges->push_back(edge);
+      }
+      pending.Push(edge);
+      while (!pending.empty()) {
+        edge = pending.Pop();
+        if (edge->IsWireEdge()) continue;
+        // Visit each of the p-edges about edge.
+        PEdgeRadialCirculator start_pe = edge->pedge_begin();
+        PEdgeRadialCirculator current_pe = start_pe;
+        do {
+          // Follow the loop of edges forward or backward to next_e, the next
+          // edge incident upon the same p-vertex as edge.
+          EdgeHandle next_e;
+          if (current_pe->start_pvertex() == pvertex) {
+            next_e = current_pe->loop_previous()->child_edge();
+          } else {
+            assert(current_pe->end_pvertex() == pvertex);
+            next_e = current_pe->loop_next()->child_edge();
+          }
+          if (next_e->visit_mark() != mark) {
+            next_e->set_visit_mark(mark);
+            edges->push_back(next_e);
+            pending.Push(next_e);
+          }
+          ++current_pe;
+        } while(current_pe != start_pe);
+      }
       ++current_pv;
     } while(current_pv != start_pv);
-
-    // Copy all the visited edges to the edge list.
-    typename EdgeHandleSet::iterator i;
-    for (i = visited_edges.begin(); i != visited_edges.end(); ++i) {
-      edges->push_back(*i);
-    }
   }
 
  protected:
-  // Helper for VisitVertexEdges.
-  template <class EdgeHandleSet>
-  static void VisitVertexEdgesHelper(PVertexHandle pvertex,
-                                     EdgeHandle edge,
-                                     EdgeHandleSet* visited_edges) {
-    // Add edge to the set of visited edges.
-    visited_edges->insert(edge);
-    
-    if (!edge->IsWireEdge()) {
-      // Visit each of the p-edges about edge.
-      PEdgeRadialCirculator start_pe = edge->pedge_begin();
-      PEdgeRadialCirculator current_pe = start_pe;
-      do {
-        // Follow the loop of edges forward or backward to next_e, the next edge
-        // incident upon the same p-vertex as edge.
-        EdgeHandle next_e;
-        if (current_pe->start_pvertex() == pvertex) {
-          next_e = current_pe->loop_previous()->child_edge();
-        } else {
-          assert(current_pe->end_pvertex() == pvertex);
-          next_e = current_pe->loop_next()->child_edge();
-        }
-        // If next_e has not already been visited, recursively visit it next.
-        if (visited_edges->find(next_e) == visited_edges->end()) {
-          VisitVertexEdgesHelper(pvertex, next_e, visited_edges);
-        }
-
-        ++current_pe;
-      } while(current_pe != start_pe);
+  // An EdgeList that only counts the edges pushed into it.
+  struct EdgeCounter {
+    EdgeCounter() : count(0) {}
+    void push_back(EdgeHandle /* edge */) { ++count; }
+    int count;
+  };
+
+  // A stack of edges, which keeps its first kInlineSize edges in place and
+  // only allocates beyond that. Around a manifold vertex, VisitVertexEdges
+  // never has more than two edges pending.
+  class EdgeStack {
+   public:
+    EdgeStack() : size_(0) {}
+
+    bool empty() const { return size_ == 0; }
+
+    void Push(EdgeHandle edge) {
+      if (size_ < kInlineSize) {
+        inline_edges_[size_] = edge;
+      } else {
+        overflow_edges_.push_back(edge);
+      }
+      ++size_;
     }
-  }
 
+    EdgeHandle Pop() {
+      assert(size_ > 0);
+      --size_;
+      if (size_ < kInlineSize) return inline_edges_[size_];
+      EdgeHandle edge = overflow_edges_.back();
+      overflow_edges_.pop_back();
+      return edge;
+    }
+
+   private:
+    static const size_t kInlineSize = 16;
+    EdgeHandle inline_edges_[kInlineSize];
+    size_t size_;
+    std::vector<EdgeHandle> overflow_edges_;
+  };
 };
+
 }  // namespace geometry
 }  // namespace ginsu
 
@@ -11,7 +11,7 @@
 namespace ginsu {
 namespace geometry {
 
-template <class T> class PartialDS;
+template <class T, class S> class PartialDS;
 template <class T> class PartialDSUtils;
 
 // PartialDSVertex: template class for vertex entity in the partial-entity
@@ -78,7 +78,8 @@ class PartialDSVertex : public PartialDSEntity<TypeRefs> {
   }
 
  protected:
-  friend class PartialDS<typename PartialDSTypes::Traits>;
+  friend class PartialDS<typename PartialDSTypes::Traits,
+                        typename PartialDSTypes::Storage>;
   friend class PartialDSUtils<PartialDSTypes>;
 
   // Mutators
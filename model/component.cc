@@ -4,12 +4,61 @@
 
 #include "model/component.h"
 
+#include <math.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "model/mesh.h"
+#include "model/subdivision.h"
 #include <CGAL/IO/Polyhedron_iostream.h>
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/Polyhedron_incremental_builder_3.h>
 #include <CGAL/Subdivision_method_3.h>
 
+namespace {
+// Last geometry revision handed out to a component. Revisions are global so
+// that they are never reused, even by a component allocated at the address of
+// a deleted one.
+unsigned int last_geometry_revision = 0;
+
+// Memory that the subdivision levels cached by a component may use. Each
+// Catmull-Clark step roughly quadruples the size of a mesh, so this is
+// typically reached after a handful of levels.
+const size_t kSubdivisionCacheBytes = 32 * 1024 * 1024;
+
+// Apply the affine transform given by the 3x4 row-major matrix m to count
+// points, stored as three consecutive coordinates each.
+void TransformPoints(const double m[12], double* points, size_t count) {
+#if defined(__SSE2__)
+  // Compute x and y together; each column of the upper two rows is held in
+  // a register.
+  const __m128d col0 = _mm_set_pd(m[4], m[0]);
+  const __m128d col1 = _mm_set_pd(m[5], m[1]);
+  const __m128d col2 = _mm_set_pd(m[6], m[2]);
+  const __m128d col3 = _mm_set_pd(m[7], m[3]);
+  for (size_t i = 0; i < count; ++i, points += 3) {
+    double x = points[0], y = points[1], z = points[2];
+    __m128d xy = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(col0, _mm_set1_pd(x)),
+                   _mm_mul_pd(col1, _mm_set1_pd(y))),
+        _mm_add_pd(_mm_mul_pd(col2, _mm_set1_pd(z)), col3));
+    _mm_storeu_pd(points, xy);
+    points[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+  }
+#else
+  for (size_t i = 0; i < count; ++i, points += 3) {
+    double x = points[0], y = points[1], z = points[2];
+    points[0] = m[0] * x + m[1] * y + m[2] * z + m[3];
+    points[1] = m[4] * x + m[5] * y + m[6] * z + m[7];
+    points[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+  }
+#endif
+}
+}  // namespace
+
 namespace ginsu {
 namespace model {
 
@@ -203,8 +252,11 @@ Component* Component::MakeTruncatedCone(float top_radius,
 }
 
 Component* Component::MakeCopy(const Component& component) {
-  Component* copy = MakeEmpty();
-  copy->Init(new Mesh(*(component.mesh())));
+  Component* copy = new Component();
+  copy->transform_.reset(new AffineTransform3D(*(component.transform_)));
+  copy->original_mesh_ = component.original_mesh_;
+  copy->max_display_subdivision_ = component.max_display_subdivision_;
+  copy->BumpGeometryRevision();
   return copy;
 }
 
@@ -212,7 +264,11 @@ void Component::ReadOffStream(std::istream& input_stream) {
   //CGAL::Polyhedron_3<Kernel> polyhedron;
   //input_stream >> polyhedron;
   //Init(new Mesh(polyhedron));
-  input_stream >> *original_mesh_;
+  // The stream replaces the geometry, so there is no need to copy it first.
+  Mesh* mesh = new Mesh();
+  input_stream >> *mesh;
+  original_mesh_.reset(mesh);
+  BumpGeometryRevision();
 }
 
 //void Component::Intersect(const Component* component1,
@@ -224,10 +280,29 @@ void Component::ReadOffStream(std::istream& input_stream) {
 //  Init(result);
 //}
 
-void Component::Subdivide(int num_steps) {
-  CGAL::Subdivision_method_3::CatmullClark_subdivision(
-      *(original_mesh_.get()), num_steps);
+// A cached subdivision level. mesh is built from indexed_mesh on demand.
+struct Component::SubdivisionLevel {
+  IndexedMesh indexed_mesh;
+  boost::shared_ptr<Mesh> mesh;
+
+  size_t bytes() const {
+    return indexed_mesh.bytes() + (mesh != NULL ? mesh->bytes() : 0);
+  }
+};
 
+void Component::Subdivide(int num_steps) {
+  if (num_steps <= 0)
+    return;
+  boost::shared_ptr<Mesh> subdivided = GetSubdivisionLevel(num_steps);
+  // The cached levels above num_steps are still good for the new geometry.
+  std::vector<boost::shared_ptr<SubdivisionLevel> > levels;
+  if (subdivision_levels_.size() > static_cast<size_t>(num_steps)) {
+    levels.assign(subdivision_levels_.begin() + num_steps,
+                  subdivision_levels_.end());
+  }
+  original_mesh_ = subdivided;
+  BumpGeometryRevision();
+  subdivision_levels_.swap(levels);
 }
 
 void Component::GetTransformMatrix44(float transform[16]) const {
@@ -236,7 +311,7 @@ void Component::GetTransformMatrix44(float transform[16]) const {
     for (int j = 0; j < 4; ++j) {
       // Transpose the matrix to get the row-major format.
       transform[index++] =
-          static_cast<float>(CGAL::to_double(transform_->m(i, j)));
+          static_cast<float>(CGAL::to_double(transform_->m(j, i)));
     }
   }
 }
@@ -246,29 +321,192 @@ void Component::SetTransform(const float transform[16]) {
     transform[0], transform[4], transform[8], transform[12],
     transform[1], transform[5], transform[9], transform[13],
     transform[2], transform[6], transform[10], transform[14]);
-  mesh_.reset(NULL);
+  InvalidateWorldGeometry();
 }
 
 bool Component::IsEmpty() const {
   return original_mesh_->empty();
 }
 
-Component::Component() {
+Component::Component()
+    : world_points_valid_(false),
+      subdivision_error_(-1.0),
+      bounding_box_valid_(false),
+      max_display_subdivision_(0),
+      geometry_revision_(0) {
 }
 
 void Component::Init(Mesh* mesh) {
   transform_.reset(new AffineTransform3D(CGAL::Identity_transformation()));
-  original_mesh_.reset (new Mesh(*mesh));
+  original_mesh_.reset(mesh);
+  BumpGeometryRevision();
+}
+
+void Component::BumpGeometryRevision() {
+  geometry_revision_ = ++last_geometry_revision;
+  subdivision_levels_.clear();
+  subdivision_error_ = -1.0;
+  bounding_box_valid_ = false;
+  InvalidateWorldGeometry();
+}
+
+double Component::EstimateSubdivisionError(int level) const {
+  if (subdivision_error_ < 0.0) {
+    // The first vertices of level 1 are the moved vertices of the mesh, in
+    // the same order.
+    ComputeSubdivisionLevels(1);
+    const std::vector<double>& moved =
+        subdivision_levels_[0]->indexed_mesh.points;
+    double max_squared_distance = 0.0;
+    size_t index = 0;
+    Mesh::Vertex_const_iterator vertex;
+    for (vertex = original_mesh_->vertices_begin();
+         vertex != original_mesh_->vertices_end();
+         ++vertex, index += 3) {
+      const Point_3& point = vertex->point();
+      double dx = moved[index] - CGAL::to_double(point.x());
+      double dy = moved[index + 1] - CGAL::to_double(point.y());
+      double dz = moved[index + 2] - CGAL::to_double(point.z());
+      max_squared_distance =
+          std::max(max_squared_distance, dx * dx + dy * dy + dz * dz);
+    }
+    subdivision_error_ = ::sqrt(max_squared_distance);
+    TrimSubdivisionCache();
+  }
+  return ::ldexp(subdivision_error_, -2 * std::max(level, 0));
+}
+
+void Component::GetBoundingBox(double min[3], double max[3]) const {
+  if (!bounding_box_valid_) {
+    std::fill(bounding_box_, bounding_box_ + 6, 0.0);
+    Mesh::Vertex_const_iterator vertex;
+    for (vertex = original_mesh_->vertices_begin();
+         vertex != original_mesh_->vertices_end();
+         ++vertex) {
+      const Point_3& point = vertex->point();
+      double coordinates[3] = { CGAL::to_double(point.x()),
+                                CGAL::to_double(point.y()),
+                                CGAL::to_double(point.z()) };
+      for (int i = 0; i < 3; ++i) {
+        if (vertex == original_mesh_->vertices_begin() ||
+            coordinates[i] < bounding_box_[i])
+          bounding_box_[i] = coordinates[i];
+        if (vertex == original_mesh_->vertices_begin() ||
+            coordinates[i] > bounding_box_[i + 3])
+          bounding_box_[i + 3] = coordinates[i];
+      }
+    }
+    bounding_box_valid_ = true;
+  }
+  std::copy(bounding_box_, bounding_box_ + 3, min);
+  std::copy(bounding_box_ + 3, bounding_box_ + 6, max);
+}
+
+boost::shared_ptr<Mesh> Component::GetSubdivisionLevel(int level) const {
+  if (level <= 0)
+    return original_mesh_;
+
+  ComputeSubdivisionLevels(level);
+  SubdivisionLevel& result = *subdivision_levels_[level - 1];
+  if (result.mesh == NULL) {
+    result.mesh.reset(new Mesh());
+    if (!IndexedMeshToMesh(result.indexed_mesh, result.mesh.get())) {
+      // Shouldn't happen, since the original mesh is a valid surface; fall
+      // back to CGAL's subdivision.
+      result.mesh.reset(new Mesh(*original_mesh_));
+      CGAL::Subdivision_method_3::CatmullClark_subdivision(*result.mesh,
+                                                           level);
+    }
+  }
+  boost::shared_ptr<Mesh> mesh = result.mesh;
+  TrimSubdivisionCache();
+  return mesh;
+}
+
+void Component::ComputeSubdivisionLevels(int level) const {
+  // Derive the missing levels from the highest one in the cache.
+  while (subdivision_levels_.size() < static_cast<size_t>(level)) {
+    boost::shared_ptr<SubdivisionLevel> next(new SubdivisionLevel);
+    if (subdivision_levels_.empty()) {
+      IndexedMesh base;
+      MeshToIndexedMesh(*original_mesh_, &base);
+      CatmullClarkStep(base, &next->indexed_mesh);
+    } else {
+      CatmullClarkStep(subdivision_levels_.back()->indexed_mesh,
+                       &next->indexed_mesh);
+    }
+    subdivision_levels_.push_back(next);
+  }
+}
+
+void Component::TrimSubdivisionCache() const {
+  // The lower levels are the cheapest to keep and are needed to derive the
+  // higher ones.
+  size_t bytes = 0;
+  size_t retained = 0;
+  while (retained < subdivision_levels_.size()) {
+    bytes += subdivision_levels_[retained]->bytes();
+    if (bytes > kSubdivisionCacheBytes)
+      break;
+    ++retained;
+  }
+  subdivision_levels_.resize(retained);
+}
+
+void Component::InvalidateWorldGeometry() {
   mesh_.reset(NULL);
+  world_points_valid_ = false;
 }
 
 const Mesh* Component::mesh() const {
-  //if (mesh_ == NULL) {
-  //  mesh_.reset(new Mesh(*original_mesh_));
-    //mesh_->transform(*transform_);
-  //}
   return original_mesh_.get();
 }
 
+const std::vector<double>& Component::GetWorldPoints() const {
+  if (!world_points_valid_) {
+    world_points_.clear();
+    world_points_.reserve(3 * original_mesh_->size_of_vertices());
+    Mesh::Vertex_const_iterator vertex;
+    for (vertex = original_mesh_->vertices_begin();
+         vertex != original_mesh_->vertices_end();
+         ++vertex) {
+      const Point_3& point = vertex->point();
+      world_points_.push_back(CGAL::to_double(point.x()));
+      world_points_.push_back(CGAL::to_double(point.y()));
+      world_points_.push_back(CGAL::to_double(point.z()));
+    }
+    // Transform all the points in one pass rather than going through
+    // Aff_transformation_3 for each Point_3.
+    double matrix[12];
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        matrix[4 * i + j] = CGAL::to_double(transform_->m(i, j));
+      }
+    }
+    if (!world_points_.empty()) {
+      TransformPoints(matrix, &world_points_[0], world_points_.size() / 3);
+    }
+    world_points_valid_ = true;
+  }
+  return world_points_;
+}
+
+const Mesh* Component::GetWorldMesh() const {
+  if (mesh_ == NULL) {
+    const std::vector<double>& points = GetWorldPoints();
+    mesh_.reset(new Mesh(*original_mesh_));
+    // The copy lists its vertices in the same order as the original.
+    size_t index = 0;
+    Mesh::Vertex_iterator vertex;
+    for (vertex = mesh_->vertices_begin();
+         vertex != mesh_->vertices_end();
+         ++vertex, index += 3) {
+      vertex->point() = Point_3(points[index], points[index + 1],
+                                points[index + 2]);
+    }
+  }
+  return mesh_.get();
+}
+
 }  // namespace model
 }  // namespace ginsu
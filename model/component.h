@@ -6,8 +6,10 @@
 #define GINSU_MODEL_COMPONENT_H_
 
 #include <istream>
+#include <vector>
 
 #include "boost/scoped_ptr.hpp"
+#include "boost/shared_ptr.hpp"
 
 namespace ginsu {
 namespace model {
@@ -24,13 +26,16 @@ class Component {
   // Make a truncated cone centered on the y-axis, between Z = 0 and Z =1 and
   // of given radii. At least one radius must be non-zero.
   static Component* MakeTruncatedCone(float top_radius, float bottom_radius);
-  // Make a copy.
+  // Make a copy, including the transform and display settings. The copy
+  // shares the geometry of component until either of them modifies it, so
+  // this takes constant time and memory.
   static Component* MakeCopy(const Component& component);
 
   // Store the intersection of c1 * c2 into this.
   //void Intersect(const Component* component1, const Component* component2);
 
-  // Subdivide the mesh using num_steps steps of Catmull-Clark.
+  // Subdivide the mesh using num_steps steps of Catmull-Clark. Levels
+  // computed earlier and still in the subdivision cache are reused.
   void Subdivide(int num_steps);
   
   void ReadOffStream(std::istream& input_stream);
@@ -46,23 +51,96 @@ class Component {
   // Is it an empty set?
   bool IsEmpty() const;
 
+  // Number of Catmull-Clark steps that views may apply to the component for
+  // display, as the level of detail requires. The default of 0 displays the
+  // mesh as is.
+  int max_display_subdivision() const { return max_display_subdivision_; }
+  void set_max_display_subdivision(int levels) {
+    max_display_subdivision_ = levels;
+  }
+
+  // Estimate of the distance, in object space, between the mesh after level
+  // steps of Catmull-Clark subdivision and the limit surface. This is based on
+  // how far the first step moves the mesh vertices, and on each step
+  // dividing the distance by about 4.
+  double EstimateSubdivisionError(int level) const;
+
+  // Axis-aligned bounding box of the mesh, in object space, e.g. to estimate
+  // the size of the component on screen before tessellating it. Computed on
+  // demand and cached until the geometry changes. Both corners are 0 if the
+  // mesh is empty.
+  void GetBoundingBox(double min[3], double max[3]) const;
+
+  // World-space geometry, i.e. the mesh transformed by the component
+  // transform, for CPU-side consumers such as booleans, picking and export.
+  // Both are computed on demand and cached until the transform or the
+  // geometry changes. GetWorldPoints returns three coordinates per vertex, in
+  // the order of the mesh vertices.
+  const std::vector<double>& GetWorldPoints() const;
+  const Mesh* GetWorldMesh() const;
+
+  // Revision number of the geometry. It changes each time the mesh is
+  // modified, and is never reused by another component; so a component
+  // pointer and its geometry revision identify a mesh for caching purposes.
+  // Transform changes do not affect the geometry revision.
+  unsigned int geometry_revision() const { return geometry_revision_; }
+
  protected:
   // Can't instantiate directly. Use the Make*** functions above.
   Component();
+  // Take ownership of mesh as the component geometry, and reset the transform
+  // to identity.
   void Init(Mesh* mesh);
 
   // Get embedded Mesh instance.
   const Mesh* mesh() const;
 
+  // Assign a new geometry revision; call after each change to the mesh.
+  void BumpGeometryRevision();
+  // Drop the cached world-space geometry.
+  void InvalidateWorldGeometry();
+  // Get the geometry after level steps of Catmull-Clark subdivision. Each
+  // level is computed from the level below, in the flat form of
+  // subdivision.h, and cached until the geometry changes. Levels are only
+  // converted to Mesh when asked for. The returned mesh is shared with the
+  // cache and must not be modified.
+  boost::shared_ptr<Mesh> GetSubdivisionLevel(int level) const;
+  // Fill the subdivision cache up to the given level.
+  void ComputeSubdivisionLevels(int level) const;
+  // Drop the highest cached subdivision levels as needed to stay under the
+  // cache memory limit.
+  void TrimSubdivisionCache() const;
+
  private:
-  // Tessellator requires access to mesh().
+  // Tessellators require access to mesh() and GetSubdivisionLevel().
+  friend class ParallelTessellator;
   friend class Tessellator;
   // Component transform; defaults to identity.
   boost::scoped_ptr<AffineTransform3D> transform_;
-  // The geometry.
-  boost::scoped_ptr<Mesh> original_mesh_;
-  // A copy of the geometry transform with transform_.
+  // The geometry; possibly shared with copies of this component and with
+  // their subdivision caches, so it is never modified in place. Operations
+  // that change the geometry replace it instead.
+  boost::shared_ptr<Mesh> original_mesh_;
+  // A copy of the geometry transformed by transform_, built on demand.
   mutable boost::scoped_ptr<Mesh> mesh_;
+  // The vertices of mesh_; valid if world_points_valid_ is true.
+  mutable std::vector<double> world_points_;
+  mutable bool world_points_valid_;
+  // Subdivision cache: element i holds the geometry after i + 1 steps of
+  // Catmull-Clark. Higher levels are dropped to keep the total memory under
+  // a fixed limit.
+  struct SubdivisionLevel;
+  mutable std::vector<boost::shared_ptr<SubdivisionLevel> >
+      subdivision_levels_;
+  // How far the first subdivision step moves the mesh vertices, or -1 if
+  // not known yet.
+  mutable double subdivision_error_;
+  // The bounding box, as min x, y, z then max x, y, z; valid if
+  // bounding_box_valid_ is true.
+  mutable double bounding_box_[6];
+  mutable bool bounding_box_valid_;
+  int max_display_subdivision_;
+  unsigned int geometry_revision_;
 };
 
 }  // namespace model
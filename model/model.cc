@@ -62,8 +62,9 @@ namespace ginsu {
 namespace model {
 
 Model::Model()
-: subdiv_steps_(2),
-  steps_increment_(1) {
+: subdiv_steps_(4),
+  steps_increment_(1),
+  demo_source_revision_(0) {
 }
 
 Model::~Model() {
@@ -102,13 +103,23 @@ void Model::UpdateDemo(double time_laps) {
     rotate.makeRotate(rotation, axis);
     components_[0]->SetTransform(rotate.ptr());
 
-    // Make a copy of component 0 and subdivide it.
-    if (components_.size() < 2) {
-      AddComponent(Component::MakeCopy(*(components_[0].get())));
+    // Make a copy of component 0, to be displayed subdivided as finely as its
+    // size on screen calls for, up to subdiv_steps_ levels. The copy only
+    // needs to be redone when the geometry of component 0 changes;
+    // otherwise, just make it follow the rotation.
+    unsigned int revision = components_[0]->geometry_revision();
+    if (components_.size() < 2 || revision != demo_source_revision_) {
+      Component* copy = Component::MakeCopy(*(components_[0].get()));
+      copy->set_max_display_subdivision(subdiv_steps_);
+      if (components_.size() < 2) {
+        AddComponent(copy);
+      } else {
+        components_[1].reset(copy);
+      }
+      demo_source_revision_ = revision;
     } else {
-      components_[1].reset(Component::MakeCopy(*(components_[0].get())));
+      components_[1]->SetTransform(rotate.ptr());
     }
-    components_[1]->Subdivide(subdiv_steps_);
   }
 }
 
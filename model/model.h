@@ -44,6 +44,8 @@ class Model {
   // Subdivision demo.
   int subdiv_steps_;
   int steps_increment_;
+  // Geometry revision of component 0 when component 1 was copied from it.
+  unsigned int demo_source_revision_;
 };
 
 }  // namespace model
@@ -0,0 +1,186 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "model/parallel_for.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace {
+// Upper bound on the number of threads, whatever the processor count.
+const int kMaxThreadCount = 16;
+
+// 0 until the default has been computed. Guarded by thread_count_mutex.
+int thread_count = 0;
+pthread_mutex_t thread_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int GetProcessorCount() {
+#if defined(_SC_NPROCESSORS_ONLN)
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count > 0)
+    return static_cast<int>(count);
+#endif
+  return 1;
+}
+
+// A range of items.
+struct Range {
+  size_t begin;
+  size_t end;
+};
+
+// A call to ParallelFor in progress. Its ranges are handed out in order to
+// the calling thread and to the pool workers. Guarded by the pool mutex.
+struct Job {
+  ginsu::model::RangeTask* task;
+  std::vector<Range> ranges;
+  // The first range not handed out yet.
+  size_t next_range;
+  // The number of ranges not done yet.
+  size_t pending_ranges;
+};
+
+// Worker threads shared by all the calls to ParallelFor. Threads are started
+// as calls need them, up to kMaxThreadCount - 1, and then wait for more work
+// until the process exits. Calls may overlap, or nest within a RangeTask:
+// the calling thread works on its own job until all its ranges are handed
+// out, and then only waits for ranges that are already running.
+class WorkerPool {
+ public:
+  static WorkerPool* Get() {
+    pthread_once(&once_, &Create);
+    return instance_;
+  }
+
+  // Run all the ranges of job, on the calling thread and on up to
+  // worker_count workers.
+  void Run(Job* job, size_t worker_count) {
+    pthread_mutex_lock(&mutex_);
+    while (started_worker_count_ < worker_count) {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, &WorkerMain, this) != 0)
+        break;  // The ranges will be done by the threads we have.
+      pthread_detach(thread);
+      ++started_worker_count_;
+    }
+    jobs_.push_back(job);
+    pthread_cond_broadcast(&work_available_);
+    while (job->next_range < job->ranges.size()) {
+      RunNextRange(job);
+    }
+    while (job->pending_ranges > 0)
+      pthread_cond_wait(&ranges_done_, &mutex_);
+    pthread_mutex_unlock(&mutex_);
+  }
+
+ private:
+  WorkerPool() : started_worker_count_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&work_available_, NULL);
+    pthread_cond_init(&ranges_done_, NULL);
+  }
+
+  static void Create() {
+    instance_ = new WorkerPool;
+  }
+
+  static void* WorkerMain(void* arg) {
+    WorkerPool* pool = static_cast<WorkerPool*>(arg);
+    pthread_mutex_lock(&pool->mutex_);
+    for (;;) {
+      while (pool->jobs_.empty())
+        pthread_cond_wait(&pool->work_available_, &pool->mutex_);
+      pool->RunNextRange(pool->jobs_.front());
+    }
+    return NULL;
+  }
+
+  // Hand out the next range of job and run it. Called with mutex_ held,
+  // which is released while the range runs.
+  void RunNextRange(Job* job) {
+    const Range& range = job->ranges[job->next_range++];
+    if (job->next_range == job->ranges.size())
+      jobs_.erase(std::find(jobs_.begin(), jobs_.end(), job));
+    pthread_mutex_unlock(&mutex_);
+    job->task->Run(range.begin, range.end);
+    pthread_mutex_lock(&mutex_);
+    if (--job->pending_ranges == 0)
+      pthread_cond_broadcast(&ranges_done_);
+  }
+
+  static pthread_once_t once_;
+  static WorkerPool* instance_;
+
+  pthread_mutex_t mutex_;
+  // Signaled when a job is queued.
+  pthread_cond_t work_available_;
+  // Signaled when the last range of a job is done.
+  pthread_cond_t ranges_done_;
+  // Jobs that still have ranges to hand out, oldest first.
+  std::deque<Job*> jobs_;
+  size_t started_worker_count_;
+};
+
+pthread_once_t WorkerPool::once_ = PTHREAD_ONCE_INIT;
+WorkerPool* WorkerPool::instance_ = NULL;
+}  // namespace
+
+namespace ginsu {
+namespace model {
+
+void ParallelFor(size_t count, size_t min_range_size, RangeTask* task) {
+  if (count == 0)
+    return;
+  if (min_range_size == 0)
+    min_range_size = 1;
+  size_t range_count = static_cast<size_t>(GetParallelThreadCount());
+  if (range_count > count / min_range_size)
+    range_count = count / min_range_size;
+  if (range_count <= 1) {
+    task->Run(0, count);
+    return;
+  }
+
+  // Split the items evenly; the first count % range_count ranges get one
+  // more item than the others.
+  Job job;
+  job.task = task;
+  job.ranges.resize(range_count);
+  job.next_range = 0;
+  job.pending_ranges = range_count;
+  size_t begin = 0;
+  for (size_t i = 0; i < range_count; ++i) {
+    size_t size = count / range_count + (i < count % range_count ? 1 : 0);
+    job.ranges[i].begin = begin;
+    job.ranges[i].end = begin + size;
+    begin += size;
+  }
+  WorkerPool::Get()->Run(&job, range_count - 1);
+}
+
+int GetParallelThreadCount() {
+  pthread_mutex_lock(&thread_count_mutex);
+  if (thread_count == 0)
+    thread_count = std::min(GetProcessorCount(), kMaxThreadCount);
+  int count = thread_count;
+  pthread_mutex_unlock(&thread_count_mutex);
+  return count;
+}
+
+void SetParallelThreadCount(int count) {
+  if (count < 1)
+    count = 1;
+  if (count > kMaxThreadCount)
+    count = kMaxThreadCount;
+  pthread_mutex_lock(&thread_count_mutex);
+  thread_count = count;
+  pthread_mutex_unlock(&thread_count_mutex);
+}
+
+}  // namespace model
+}  // namespace ginsu
@@ -0,0 +1,39 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GINSU_MODEL_PARALLEL_FOR_H_
+#define GINSU_MODEL_PARALLEL_FOR_H_
+
+#include <stddef.h>
+
+namespace ginsu {
+namespace model {
+
+// Work that can be split into independent ranges of items.
+class RangeTask {
+ public:
+  virtual ~RangeTask() {}
+  // Process the items in [begin, end). Called concurrently for disjoint
+  // ranges.
+  virtual void Run(size_t begin, size_t end) = 0;
+};
+
+// Run task over the items in [0, count), split into contiguous ranges of at
+// least min_range_size items that run on separate threads. The calling thread
+// works on the ranges too; the other threads come from a pool that is started
+// on first use and kept for later calls, which may overlap or nest. Returns
+// once all ranges are done.
+// The split only depends on count, min_range_size and the thread count, so a
+// task that writes the output of each item to a fixed place gives the same
+// result however the threads are scheduled.
+void ParallelFor(size_t count, size_t min_range_size, RangeTask* task);
+
+// Maximum number of threads used by ParallelFor, calling thread included.
+// Defaults to the number of processors. Safe to call from any thread.
+int GetParallelThreadCount();
+void SetParallelThreadCount(int thread_count);
+
+}  // namespace model
+}  // namespace ginsu
+#endif  // GINSU_MODEL_PARALLEL_FOR_H_
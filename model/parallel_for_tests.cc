@@ -0,0 +1,194 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "model/parallel_for.h"
+
+namespace {
+
+using ginsu::model::ParallelFor;
+using ginsu::model::RangeTask;
+
+// The thread count of all the tests (see ParallelForTest).
+const int kThreadCount = 4;
+// How long a range waits for the other ranges of its call to start.
+const int kWaitSeconds = 10;
+
+// Threads are numbered in the order they first run a range, so that a new
+// thread gets a new number even if it reuses the pthread_t of one that
+// exited. thread_numbers_seen is guarded by thread_number_mutex.
+pthread_once_t thread_number_once = PTHREAD_ONCE_INIT;
+pthread_key_t thread_number_key;
+pthread_mutex_t thread_number_mutex = PTHREAD_MUTEX_INITIALIZER;
+int thread_numbers_seen = 0;
+
+void CreateThreadNumberKey() {
+  pthread_key_create(&thread_number_key, NULL);
+}
+
+int GetThreadNumber() {
+  pthread_once(&thread_number_once, &CreateThreadNumberKey);
+  intptr_t number =
+      reinterpret_cast<intptr_t>(pthread_getspecific(thread_number_key));
+  if (number == 0) {
+    pthread_mutex_lock(&thread_number_mutex);
+    number = ++thread_numbers_seen;
+    pthread_mutex_unlock(&thread_number_mutex);
+    pthread_setspecific(thread_number_key, reinterpret_cast<void*>(number));
+  }
+  return static_cast<int>(number);
+}
+
+int GetThreadNumbersSeen() {
+  pthread_mutex_lock(&thread_number_mutex);
+  int count = thread_numbers_seen;
+  pthread_mutex_unlock(&thread_number_mutex);
+  return count;
+}
+
+// Measures how many of its ranges run at once. Each range waits until
+// range_count ranges have started, so that they all run at once when there
+// are enough threads, or until kWaitSeconds have passed.
+class ConcurrencyTask : public RangeTask {
+ public:
+  explicit ConcurrencyTask(int range_count)
+      : range_count_(range_count),
+        started_count_(0),
+        running_count_(0),
+        peak_running_count_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&started_, NULL);
+  }
+
+  virtual ~ConcurrencyTask() {
+    pthread_cond_destroy(&started_);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  virtual void Run(size_t begin, size_t end) {
+    int running_count = __sync_add_and_fetch(&running_count_, 1);
+    // Raise the peak to running_count, unless another range raised it more.
+    int peak = 0;
+    while (peak < running_count) {
+      int old_peak = __sync_val_compare_and_swap(&peak_running_count_, peak,
+                                                 running_count);
+      if (old_peak == peak)
+        break;
+      peak = old_peak;
+    }
+    GetThreadNumber();
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + kWaitSeconds;
+    deadline.tv_nsec = now.tv_usec * 1000;
+    pthread_mutex_lock(&mutex_);
+    if (++started_count_ == range_count_)
+      pthread_cond_broadcast(&started_);
+    while (started_count_ < range_count_ &&
+           pthread_cond_timedwait(&started_, &mutex_, &deadline) == 0) {
+    }
+    pthread_mutex_unlock(&mutex_);
+    __sync_sub_and_fetch(&running_count_, 1);
+  }
+
+  // The largest number of ranges that ran at once.
+  int peak_running_count() const { return peak_running_count_; }
+
+ private:
+  const int range_count_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t started_;
+  int started_count_;  // Guarded by mutex_.
+  int running_count_;
+  int peak_running_count_;
+};
+
+// Runs a ParallelFor over inner_count items from within each of its items,
+// and counts the inner items each of them saw run.
+class NestedTask : public RangeTask {
+ public:
+  NestedTask(size_t count, size_t inner_count)
+      : inner_count_(inner_count), counts_(count, 0) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (inner_count_ == 0) {
+        counts_[i] = 1;
+        continue;
+      }
+      NestedTask inner(inner_count_, 0);
+      ParallelFor(inner_count_, 1, &inner);
+      for (size_t j = 0; j < inner.counts().size(); ++j)
+        counts_[i] += inner.counts()[j];
+    }
+  }
+
+  const std::vector<size_t>& counts() const { return counts_; }
+
+ private:
+  size_t inner_count_;
+  std::vector<size_t> counts_;
+};
+
+// The pool keeps every worker it ever started, so all the tests run with at
+// most kThreadCount threads: then no call in this program can find more than
+// kThreadCount - 1 workers, whatever the test order.
+class ParallelForTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    thread_count_ = ginsu::model::GetParallelThreadCount();
+    ginsu::model::SetParallelThreadCount(kThreadCount);
+  }
+  virtual void TearDown() {
+    ginsu::model::SetParallelThreadCount(thread_count_);
+  }
+
+  int thread_count_;
+};
+
+TEST_F(ParallelForTest, ThreadCountLimitsConcurrency) {
+  for (int i = 0; i < 10; ++i) {
+    ConcurrencyTask task(kThreadCount);
+    ParallelFor(64, 1, &task);
+    EXPECT_EQ(kThreadCount, task.peak_running_count());
+  }
+
+  // Lowering the thread count leaves the extra workers idle.
+  ginsu::model::SetParallelThreadCount(2);
+  for (int i = 0; i < 10; ++i) {
+    ConcurrencyTask task(2);
+    ParallelFor(64, 1, &task);
+    EXPECT_EQ(2, task.peak_running_count());
+  }
+}
+
+TEST_F(ParallelForTest, ReusesThreads) {
+  // The first call needs kThreadCount threads at once; later calls find them
+  // in the pool rather than starting new ones.
+  ConcurrencyTask first_task(kThreadCount);
+  ParallelFor(64, 1, &first_task);
+  ASSERT_EQ(kThreadCount, first_task.peak_running_count());
+  int thread_numbers_seen = GetThreadNumbersSeen();
+  for (int i = 0; i < 50; ++i) {
+    ConcurrencyTask task(kThreadCount);
+    ParallelFor(64, 1, &task);
+  }
+  EXPECT_EQ(thread_numbers_seen, GetThreadNumbersSeen());
+}
+
+TEST_F(ParallelForTest, NestedCalls) {
+  NestedTask task(16, 100);
+  ParallelFor(16, 1, &task);
+  for (size_t i = 0; i < task.counts().size(); ++i)
+    EXPECT_EQ(100u, task.counts()[i]);
+}
+
+}  // namespace
@@ -0,0 +1,133 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "model/parallel_tessellator.h"
+
+#include <algorithm>
+
+#include "model/component.h"
+#include "model/mesh.h"
+#include "model/parallel_for.h"
+
+namespace {
+using ginsu::model::Tessellator;
+
+// Components are split into ranges of this many facets. Ranges are the unit
+// of work handed to the threads, so they shouldn't be too large either.
+const size_t kFacetsPerRange = 2048;
+
+// Append the content of source to target, shifting the indices of source
+// past the vertices already in target.
+void AppendTriangleBuffer(const Tessellator::TriangleBuffer& source,
+                          Tessellator::TriangleBuffer* target) {
+  unsigned int base_index = static_cast<unsigned int>(target->vertex_count());
+  target->positions.insert(target->positions.end(),
+                           source.positions.begin(), source.positions.end());
+  target->normals.insert(target->normals.end(),
+                         source.normals.begin(), source.normals.end());
+  target->triangle_indices.reserve(target->triangle_indices.size() +
+                                   source.triangle_indices.size());
+  for (size_t i = 0; i < source.triangle_indices.size(); ++i)
+    target->triangle_indices.push_back(base_index + source.triangle_indices[i]);
+  target->edge_indices.reserve(target->edge_indices.size() +
+                               source.edge_indices.size());
+  for (size_t i = 0; i < source.edge_indices.size(); ++i)
+    target->edge_indices.push_back(base_index + source.edge_indices[i]);
+}
+}  // namespace
+
+namespace ginsu {
+namespace model {
+
+struct ParallelTessellator::Range {
+  size_t job;
+  size_t facet_begin;
+  size_t facet_end;
+  Tessellator::TriangleBuffer output;
+};
+
+// The tessellator of a thread. Collects the tessellation of each range into
+// the range's output.
+class ParallelTessellator::RangeTessellator : public Tessellator {
+ public:
+  RangeTessellator() : output_(NULL) {
+    EnableBatchedOutput(0);
+    EnableSharedVertices();
+  }
+
+  void TessellateRange(const Mesh& mesh, Range* range) {
+    output_ = &range->output;
+    TessellateFacets(mesh, range->facet_begin, range->facet_end);
+    output_ = NULL;
+  }
+
+ protected:
+  virtual void AddTriangleBuffer(const TriangleBuffer& buffer) {
+    AppendTriangleBuffer(buffer, output_);
+  }
+
+ private:
+  TriangleBuffer* output_;
+};
+
+class ParallelTessellator::TessellateTask : public RangeTask {
+ public:
+  TessellateTask(const std::vector<Job>& jobs, std::vector<Range>* ranges)
+      : jobs_(jobs), ranges_(*ranges) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    // One tessellator, hence one glu tessellator, per thread. Consecutive
+    // ranges of the same component are contiguous, so the tessellator walks
+    // each mesh's facet list only once.
+    RangeTessellator tessellator;
+    for (size_t i = begin; i < end; ++i)
+      tessellator.TessellateRange(*jobs_[ranges_[i].job].mesh, &ranges_[i]);
+  }
+
+ private:
+  const std::vector<Job>& jobs_;
+  std::vector<Range>& ranges_;
+};
+
+ParallelTessellator::ParallelTessellator() {
+}
+
+ParallelTessellator::~ParallelTessellator() {
+}
+
+void ParallelTessellator::AddComponent(const Component& component,
+                                       int subdivision_level) {
+  jobs_.push_back(Job());
+  jobs_.back().mesh = component.GetSubdivisionLevel(subdivision_level);
+}
+
+void ParallelTessellator::Run() {
+  // The split into ranges only depends on the meshes.
+  std::vector<Range> ranges;
+  for (size_t i = 0; i < jobs_.size(); ++i) {
+    jobs_[i].result.Clear();
+    size_t facet_count = jobs_[i].mesh->size_of_facets();
+    for (size_t begin = 0; begin < facet_count; begin += kFacetsPerRange) {
+      ranges.push_back(Range());
+      ranges.back().job = i;
+      ranges.back().facet_begin = begin;
+      ranges.back().facet_end = std::min(begin + kFacetsPerRange, facet_count);
+    }
+  }
+
+  TessellateTask task(jobs_, &ranges);
+  ParallelFor(ranges.size(), 1, &task);
+
+  // Concatenate the ranges of each component, in order. Vertices aren't
+  // shared across ranges, but each edge is still listed once.
+  for (size_t i = 0; i < ranges.size(); ++i)
+    AppendTriangleBuffer(ranges[i].output, &jobs_[ranges[i].job].result);
+}
+
+void ParallelTessellator::Clear() {
+  jobs_.clear();
+}
+
+}  // namespace model
+}  // namespace ginsu
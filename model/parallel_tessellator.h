@@ -0,0 +1,71 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GINSU_MODEL_PARALLEL_TESSELLATOR_H_
+#define GINSU_MODEL_PARALLEL_TESSELLATOR_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+#include "model/tessellator.h"
+
+namespace ginsu {
+namespace model {
+
+class Component;
+class Mesh;
+
+// Tessellates a set of components at once, spreading the work over the
+// threads of ParallelFor. Large components are split into ranges of facets,
+// so that a single component also benefits. Each thread has its own
+// Tessellator, hence its own glu tessellator and buffers, and the output of
+// each range goes to a fixed place, to be concatenated in order once all the
+// ranges are done. The result doesn't depend on the number of threads.
+// Usage:
+//   ParallelTessellator tessellator;
+//   tessellator.AddComponent(component, subdivision_level);
+//   ...
+//   tessellator.Run();
+//   ... tessellator.result(i) ...
+class ParallelTessellator {
+ public:
+  ParallelTessellator();
+  ~ParallelTessellator();
+
+  // Queue the component for tessellation after subdivision_level steps of
+  // Catmull-Clark subdivision. The geometry is looked up right away, on the
+  // calling thread; the component may change once this returns.
+  void AddComponent(const Component& component, int subdivision_level);
+
+  // Tessellate the queued components. Result i is then the tessellation of
+  // the i-th queued component, as a single buffer in which vertices are
+  // shared between facets (see Tessellator::EnableSharedVertices).
+  void Run();
+
+  size_t component_count() const { return jobs_.size(); }
+  const Tessellator::TriangleBuffer& result(size_t i) const {
+    return jobs_[i].result;
+  }
+
+  // Forget all the components and results.
+  void Clear();
+
+ private:
+  class RangeTessellator;
+  class TessellateTask;
+  // A range of facets of a queued component, tessellated in one go.
+  struct Range;
+
+  // A queued component.
+  struct Job {
+    boost::shared_ptr<Mesh> mesh;
+    Tessellator::TriangleBuffer result;
+  };
+  std::vector<Job> jobs_;
+};
+
+}  // namespace model
+}  // namespace ginsu
+#endif  // GINSU_MODEL_PARALLEL_TESSELLATOR_H_
@@ -0,0 +1,496 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "model/subdivision.h"
+
+#include <algorithm>
+
+#include "boost/tr1/unordered_map.hpp"
+#include "model/mesh.h"
+#include "model/parallel_for.h"
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+
+namespace {
+using ginsu::model::IndexedMesh;
+
+// Items below this count are not worth a thread of their own.
+const size_t kMinRangeSize = 2048;
+
+struct Edge {
+  unsigned int vertices[2];
+  // Faces on either side of the edge; faces[1] is -1 for a border edge.
+  int faces[2];
+};
+
+// Adjacency information needed by the subdivision rules. Corners are
+// identified by their index in IndexedMesh::face_vertices.
+struct Topology {
+  // Face of each corner.
+  std::vector<unsigned int> corner_faces;
+  // Edge from each corner to the next corner of its face.
+  std::vector<unsigned int> corner_edges;
+  std::vector<Edge> edges;
+  // The edges incident on vertex v are vertex_edges[i] for i in
+  // [vertex_edge_offsets[v], vertex_edge_offsets[v + 1]).
+  std::vector<unsigned int> vertex_edge_offsets;
+  std::vector<unsigned int> vertex_edges;
+  // Likewise for the corners at each vertex.
+  std::vector<unsigned int> vertex_corner_offsets;
+  std::vector<unsigned int> vertex_corners;
+};
+
+unsigned int NextCorner(const IndexedMesh& mesh, const Topology& topology,
+                        unsigned int corner) {
+  unsigned int face = topology.corner_faces[corner];
+  return (corner + 1 == mesh.face_offsets[face + 1]) ?
+      mesh.face_offsets[face] : corner + 1;
+}
+
+unsigned int PreviousCorner(const IndexedMesh& mesh, const Topology& topology,
+                            unsigned int corner) {
+  unsigned int face = topology.corner_faces[corner];
+  return (corner == mesh.face_offsets[face]) ?
+      mesh.face_offsets[face + 1] - 1 : corner - 1;
+}
+
+// Turn counts into offsets: offsets[i] becomes the sum of the counts before
+// i. offsets must have one more element than there are counts.
+void AccumulateOffsets(std::vector<unsigned int>* offsets) {
+  unsigned int sum = 0;
+  for (size_t i = 0; i < offsets->size(); ++i) {
+    unsigned int count = (*offsets)[i];
+    (*offsets)[i] = sum;
+    sum += count;
+  }
+}
+
+// Orders the corners of a bucket by the vertex at the other end of their
+// edge.
+class CompareOtherEnd {
+ public:
+  CompareOtherEnd(const IndexedMesh& mesh, const Topology& topology)
+      : mesh_(mesh), topology_(topology) {}
+  unsigned int OtherEnd(unsigned int corner) const {
+    unsigned int a = mesh_.face_vertices[corner];
+    unsigned int b = mesh_.face_vertices[NextCorner(mesh_, topology_, corner)];
+    return std::max(a, b);
+  }
+  bool operator()(unsigned int corner1, unsigned int corner2) const {
+    unsigned int end1 = OtherEnd(corner1);
+    unsigned int end2 = OtherEnd(corner2);
+    return (end1 != end2) ? (end1 < end2) : (corner1 < corner2);
+  }
+
+ private:
+  const IndexedMesh& mesh_;
+  const Topology& topology_;
+};
+
+void BuildTopology(const IndexedMesh& mesh, Topology* topology) {
+  size_t vertex_count = mesh.vertex_count();
+  size_t face_count = mesh.face_count();
+  size_t corner_count = mesh.face_vertices.size();
+
+  topology->corner_faces.resize(corner_count);
+  for (size_t f = 0; f < face_count; ++f) {
+    for (unsigned int c = mesh.face_offsets[f]; c < mesh.face_offsets[f + 1];
+         ++c) {
+      topology->corner_faces[c] = static_cast<unsigned int>(f);
+    }
+  }
+
+  // Find the edges: bucket the corners by the lower-numbered vertex of their
+  // edge, then match the corners in each bucket that share the other vertex.
+  std::vector<unsigned int> bucket_offsets(vertex_count + 1, 0);
+  for (unsigned int c = 0; c < corner_count; ++c) {
+    unsigned int a = mesh.face_vertices[c];
+    unsigned int b = mesh.face_vertices[NextCorner(mesh, *topology, c)];
+    ++bucket_offsets[std::min(a, b)];
+  }
+  AccumulateOffsets(&bucket_offsets);
+  std::vector<unsigned int> buckets(corner_count);
+  {
+    std::vector<unsigned int> fill(bucket_offsets.begin(),
+                                   bucket_offsets.end() - 1);
+    for (unsigned int c = 0; c < corner_count; ++c) {
+      unsigned int a = mesh.face_vertices[c];
+      unsigned int b = mesh.face_vertices[NextCorner(mesh, *topology, c)];
+      buckets[fill[std::min(a, b)]++] = c;
+    }
+  }
+
+  CompareOtherEnd compare(mesh, *topology);
+  topology->corner_edges.resize(corner_count);
+  topology->edges.clear();
+  topology->edges.reserve(corner_count / 2 + 1);
+  for (size_t v = 0; v < vertex_count; ++v) {
+    std::vector<unsigned int>::iterator begin =
+        buckets.begin() + bucket_offsets[v];
+    std::vector<unsigned int>::iterator end =
+        buckets.begin() + bucket_offsets[v + 1];
+    std::sort(begin, end, compare);
+    while (begin != end) {
+      unsigned int corner = *begin;
+      Edge edge;
+      edge.vertices[0] = mesh.face_vertices[corner];
+      edge.vertices[1] =
+          mesh.face_vertices[NextCorner(mesh, *topology, corner)];
+      edge.faces[0] = static_cast<int>(topology->corner_faces[corner]);
+      edge.faces[1] = -1;
+      unsigned int edge_index =
+          static_cast<unsigned int>(topology->edges.size());
+      topology->corner_edges[corner] = edge_index;
+      ++begin;
+      // A surface has at most two faces on an edge; any more would make a
+      // new border edge.
+      if (begin != end &&
+          compare.OtherEnd(*begin) == compare.OtherEnd(corner)) {
+        edge.faces[1] = static_cast<int>(topology->corner_faces[*begin]);
+        topology->corner_edges[*begin] = edge_index;
+        ++begin;
+      }
+      topology->edges.push_back(edge);
+    }
+  }
+
+  // Incidence lists of the vertices.
+  topology->vertex_edge_offsets.assign(vertex_count + 1, 0);
+  for (size_t e = 0; e < topology->edges.size(); ++e) {
+    ++topology->vertex_edge_offsets[topology->edges[e].vertices[0]];
+    ++topology->vertex_edge_offsets[topology->edges[e].vertices[1]];
+  }
+  AccumulateOffsets(&topology->vertex_edge_offsets);
+  topology->vertex_edges.resize(2 * topology->edges.size());
+  {
+    std::vector<unsigned int> fill(topology->vertex_edge_offsets.begin(),
+                                   topology->vertex_edge_offsets.end() - 1);
+    for (unsigned int e = 0; e < topology->edges.size(); ++e) {
+      topology->vertex_edges[fill[topology->edges[e].vertices[0]]++] = e;
+      topology->vertex_edges[fill[topology->edges[e].vertices[1]]++] = e;
+    }
+  }
+
+  topology->vertex_corner_offsets.assign(vertex_count + 1, 0);
+  for (size_t c = 0; c < corner_count; ++c) {
+    ++topology->vertex_corner_offsets[mesh.face_vertices[c]];
+  }
+  AccumulateOffsets(&topology->vertex_corner_offsets);
+  topology->vertex_corners.resize(corner_count);
+  {
+    std::vector<unsigned int> fill(topology->vertex_corner_offsets.begin(),
+                                   topology->vertex_corner_offsets.end() - 1);
+    for (unsigned int c = 0; c < corner_count; ++c) {
+      topology->vertex_corners[fill[mesh.face_vertices[c]]++] = c;
+    }
+  }
+}
+
+// The subdivision rules, one task per kind of new point. New points go to
+// their final place in the subdivided mesh: moved vertex v at index v, edge
+// point e at vertex_count + e and face point f at vertex_count + edge_count
+// + f.
+class SubdivisionTask : public ginsu::model::RangeTask {
+ public:
+  SubdivisionTask(const IndexedMesh& mesh, const Topology& topology,
+                  IndexedMesh* subdivided)
+      : mesh_(mesh),
+        topology_(topology),
+        subdivided_(subdivided),
+        edge_base_(mesh.vertex_count()),
+        face_base_(mesh.vertex_count() + topology.edges.size()) {}
+
+ protected:
+  const double* OldPoint(size_t vertex) const {
+    return &mesh_.points[3 * vertex];
+  }
+  const double* FacePoint(size_t face) const {
+    return &subdivided_->points[3 * (face_base_ + face)];
+  }
+  double* NewPoint(size_t index) { return &subdivided_->points[3 * index]; }
+
+  const IndexedMesh& mesh_;
+  const Topology& topology_;
+  IndexedMesh* subdivided_;
+  const size_t edge_base_;
+  const size_t face_base_;
+};
+
+// Face point: the centroid of the face.
+class FacePointTask : public SubdivisionTask {
+ public:
+  FacePointTask(const IndexedMesh& mesh, const Topology& topology,
+                IndexedMesh* subdivided)
+      : SubdivisionTask(mesh, topology, subdivided) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      double sum[3] = { 0.0, 0.0, 0.0 };
+      unsigned int first = mesh_.face_offsets[f];
+      unsigned int last = mesh_.face_offsets[f + 1];
+      for (unsigned int c = first; c < last; ++c) {
+        const double* point = OldPoint(mesh_.face_vertices[c]);
+        sum[0] += point[0];
+        sum[1] += point[1];
+        sum[2] += point[2];
+      }
+      double* face_point = NewPoint(face_base_ + f);
+      double count = static_cast<double>(last - first);
+      face_point[0] = sum[0] / count;
+      face_point[1] = sum[1] / count;
+      face_point[2] = sum[2] / count;
+    }
+  }
+};
+
+// Edge point: average of the end points and adjacent face points; the
+// midpoint on the border.
+class EdgePointTask : public SubdivisionTask {
+ public:
+  EdgePointTask(const IndexedMesh& mesh, const Topology& topology,
+                IndexedMesh* subdivided)
+      : SubdivisionTask(mesh, topology, subdivided) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    for (size_t e = begin; e < end; ++e) {
+      const Edge& edge = topology_.edges[e];
+      const double* p1 = OldPoint(edge.vertices[0]);
+      const double* p2 = OldPoint(edge.vertices[1]);
+      double* edge_point = NewPoint(edge_base_ + e);
+      if (edge.faces[1] < 0) {
+        for (int i = 0; i < 3; ++i)
+          edge_point[i] = (p1[i] + p2[i]) / 2;
+      } else {
+        const double* f1 = FacePoint(edge.faces[0]);
+        const double* f2 = FacePoint(edge.faces[1]);
+        for (int i = 0; i < 3; ++i)
+          edge_point[i] = (p1[i] + p2[i] + f1[i] + f2[i]) / 4;
+      }
+    }
+  }
+};
+
+// Vertex point: (Q + 2R + (n - 3)S) / n, where S is the vertex, Q the
+// average of the adjacent face points and R the average of the incident edge
+// midpoints. Border vertices use (P + 6S + N) / 8, where P and N are their
+// neighbors along the border.
+class VertexPointTask : public SubdivisionTask {
+ public:
+  VertexPointTask(const IndexedMesh& mesh, const Topology& topology,
+                  IndexedMesh* subdivided)
+      : SubdivisionTask(mesh, topology, subdivided) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      const double* s = OldPoint(v);
+      double* vertex_point = NewPoint(v);
+      unsigned int first_edge = topology_.vertex_edge_offsets[v];
+      unsigned int last_edge = topology_.vertex_edge_offsets[v + 1];
+      if (first_edge == last_edge) {
+        // Isolated vertex.
+        for (int i = 0; i < 3; ++i)
+          vertex_point[i] = s[i];
+        continue;
+      }
+
+      double r[3] = { 0.0, 0.0, 0.0 };
+      const double* border_neighbors[2];
+      int border_count = 0;
+      for (unsigned int i = first_edge; i < last_edge; ++i) {
+        const Edge& edge = topology_.edges[topology_.vertex_edges[i]];
+        unsigned int other = (edge.vertices[0] == v) ?
+            edge.vertices[1] : edge.vertices[0];
+        const double* p = OldPoint(other);
+        for (int j = 0; j < 3; ++j)
+          r[j] += (s[j] + p[j]) / 2;
+        if (edge.faces[1] < 0) {
+          if (border_count < 2)
+            border_neighbors[border_count] = p;
+          ++border_count;
+        }
+      }
+
+      if (border_count == 2) {
+        const double* p = border_neighbors[0];
+        const double* n = border_neighbors[1];
+        for (int i = 0; i < 3; ++i)
+          vertex_point[i] = (p[i] + 6 * s[i] + n[i]) / 8;
+      } else if (border_count > 0) {
+        // A vertex where the border pinches; leave it alone.
+        for (int i = 0; i < 3; ++i)
+          vertex_point[i] = s[i];
+      } else {
+        double q[3] = { 0.0, 0.0, 0.0 };
+        unsigned int first_corner = topology_.vertex_corner_offsets[v];
+        unsigned int last_corner = topology_.vertex_corner_offsets[v + 1];
+        for (unsigned int i = first_corner; i < last_corner; ++i) {
+          const double* f =
+              FacePoint(topology_.corner_faces[topology_.vertex_corners[i]]);
+          for (int j = 0; j < 3; ++j)
+            q[j] += f[j];
+        }
+        double n = static_cast<double>(last_edge - first_edge);
+        double face_count = static_cast<double>(last_corner - first_corner);
+        for (int i = 0; i < 3; ++i) {
+          vertex_point[i] =
+              (q[i] / face_count + 2 * r[i] / n + (n - 3) * s[i]) / n;
+        }
+      }
+    }
+  }
+};
+
+// One quad per corner: the corner vertex, the point of the edge leaving it,
+// the face point and the point of the edge arriving at it.
+class QuadTask : public SubdivisionTask {
+ public:
+  QuadTask(const IndexedMesh& mesh, const Topology& topology,
+           IndexedMesh* subdivided)
+      : SubdivisionTask(mesh, topology, subdivided) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      unsigned int corner = static_cast<unsigned int>(c);
+      unsigned int* quad = &subdivided_->face_vertices[4 * c];
+      quad[0] = mesh_.face_vertices[c];
+      quad[1] = static_cast<unsigned int>(
+          edge_base_ + topology_.corner_edges[c]);
+      quad[2] = static_cast<unsigned int>(
+          face_base_ + topology_.corner_faces[c]);
+      quad[3] = static_cast<unsigned int>(edge_base_ + topology_.corner_edges[
+          PreviousCorner(mesh_, topology_, corner)]);
+      subdivided_->face_offsets[c + 1] = static_cast<unsigned int>(4 * c + 4);
+    }
+  }
+};
+
+// Builds a Mesh from an IndexedMesh.
+class IndexedMeshBuilder
+    : public CGAL::Modifier_base<ginsu::model::Mesh::HalfedgeDS> {
+ public:
+  explicit IndexedMeshBuilder(const IndexedMesh& mesh)
+      : mesh_(mesh), error_(false) {}
+
+  bool error() const { return error_; }
+
+  void operator()(ginsu::model::Mesh::HalfedgeDS& half_edge_ds) {
+    CGAL::Polyhedron_incremental_builder_3<ginsu::model::Mesh::HalfedgeDS>
+        builder(half_edge_ds);
+    builder.begin_surface(mesh_.vertex_count(), mesh_.face_count(),
+                          2 * mesh_.face_vertices.size());
+    for (size_t v = 0; v < mesh_.vertex_count(); ++v) {
+      const double* point = &mesh_.points[3 * v];
+      builder.add_vertex(ginsu::model::Point_3(point[0], point[1], point[2]));
+    }
+    for (size_t f = 0; f < mesh_.face_count(); ++f) {
+      std::vector<unsigned int>::const_iterator begin =
+          mesh_.face_vertices.begin() + mesh_.face_offsets[f];
+      std::vector<unsigned int>::const_iterator end =
+          mesh_.face_vertices.begin() + mesh_.face_offsets[f + 1];
+      // The builder asserts on faces that it can't add; check first.
+      bool valid = true;
+      for (std::vector<unsigned int>::const_iterator i = begin; i != end;
+           ++i) {
+        valid = valid && (*i < mesh_.vertex_count());
+      }
+      if (!valid || !builder.test_facet(begin, end)) {
+        builder.rollback();
+        error_ = true;
+        return;
+      }
+      builder.add_facet(begin, end);
+    }
+    builder.end_surface();
+    error_ = builder.error();
+    if (error_)
+      builder.rollback();
+  }
+
+ private:
+  const IndexedMesh& mesh_;
+  bool error_;
+};
+}  // namespace
+
+namespace ginsu {
+namespace model {
+
+size_t IndexedMesh::bytes() const {
+  return points.capacity() * sizeof(points[0]) +
+         face_offsets.capacity() * sizeof(face_offsets[0]) +
+         face_vertices.capacity() * sizeof(face_vertices[0]);
+}
+
+void IndexedMesh::Clear() {
+  points.clear();
+  face_offsets.clear();
+  face_vertices.clear();
+}
+
+void MeshToIndexedMesh(const Mesh& mesh, IndexedMesh* indexed_mesh) {
+  indexed_mesh->Clear();
+  indexed_mesh->points.reserve(3 * mesh.size_of_vertices());
+  typedef std::tr1::unordered_map<const void*, unsigned int> VertexIndexMap;
+  VertexIndexMap vertex_indices;
+  unsigned int index = 0;
+  Mesh::Vertex_const_iterator vertex;
+  for (vertex = mesh.vertices_begin(); vertex != mesh.vertices_end();
+       ++vertex, ++index) {
+    const Point_3& point = vertex->point();
+    indexed_mesh->points.push_back(CGAL::to_double(point.x()));
+    indexed_mesh->points.push_back(CGAL::to_double(point.y()));
+    indexed_mesh->points.push_back(CGAL::to_double(point.z()));
+    vertex_indices[&*vertex] = index;
+  }
+
+  indexed_mesh->face_offsets.reserve(mesh.size_of_facets() + 1);
+  indexed_mesh->face_vertices.reserve(mesh.size_of_halfedges() / 2);
+  indexed_mesh->face_offsets.push_back(0);
+  Mesh::Facet_const_iterator facet;
+  for (facet = mesh.facets_begin(); facet != mesh.facets_end(); ++facet) {
+    Mesh::Halfedge_around_facet_const_circulator edge = facet->facet_begin();
+    do {
+      indexed_mesh->face_vertices.push_back(
+          vertex_indices[&*edge->vertex()]);
+    } while (++edge != facet->facet_begin());
+    indexed_mesh->face_offsets.push_back(
+        static_cast<unsigned int>(indexed_mesh->face_vertices.size()));
+  }
+}
+
+bool IndexedMeshToMesh(const IndexedMesh& indexed_mesh, Mesh* mesh) {
+  mesh->clear();
+  IndexedMeshBuilder builder(indexed_mesh);
+  mesh->delegate(builder);
+  if (builder.error()) {
+    mesh->clear();
+    return false;
+  }
+  return true;
+}
+
+void CatmullClarkStep(const IndexedMesh& mesh, IndexedMesh* subdivided) {
+  Topology topology;
+  BuildTopology(mesh, &topology);
+
+  size_t corner_count = mesh.face_vertices.size();
+  size_t new_vertex_count =
+      mesh.vertex_count() + topology.edges.size() + mesh.face_count();
+  subdivided->points.resize(3 * new_vertex_count);
+  subdivided->face_offsets.resize(corner_count + 1);
+  subdivided->face_offsets[0] = 0;
+  subdivided->face_vertices.resize(4 * corner_count);
+
+  // Edge points depend on face points, and vertex points on both.
+  FacePointTask face_points(mesh, topology, subdivided);
+  ParallelFor(mesh.face_count(), kMinRangeSize, &face_points);
+  EdgePointTask edge_points(mesh, topology, subdivided);
+  ParallelFor(topology.edges.size(), kMinRangeSize, &edge_points);
+  VertexPointTask vertex_points(mesh, topology, subdivided);
+  ParallelFor(mesh.vertex_count(), kMinRangeSize, &vertex_points);
+  QuadTask quads(mesh, topology, subdivided);
+  ParallelFor(corner_count, kMinRangeSize, &quads);
+}
+
+}  // namespace model
+}  // namespace ginsu
@@ -0,0 +1,56 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GINSU_MODEL_SUBDIVISION_H_
+#define GINSU_MODEL_SUBDIVISION_H_
+
+#include <stddef.h>
+#include <vector>
+
+namespace ginsu {
+namespace model {
+
+class Mesh;
+
+// A polygon mesh stored in flat arrays: the vertex coordinates, and the vertex
+// indices of each face. This is much cheaper to walk than the linked lists of
+// a Mesh, and is what the subdivision code below works on.
+struct IndexedMesh {
+  // Three coordinates per vertex.
+  std::vector<double> points;
+  // The vertices of face f, counter-clockwise, are face_vertices[i] for i in
+  // [face_offsets[f], face_offsets[f + 1]). There is one more offset than
+  // there are faces.
+  std::vector<unsigned int> face_offsets;
+  std::vector<unsigned int> face_vertices;
+
+  size_t vertex_count() const { return points.size() / 3; }
+  size_t face_count() const {
+    return face_offsets.empty() ? 0 : face_offsets.size() - 1;
+  }
+  // Approximate memory used by the mesh.
+  size_t bytes() const;
+  void Clear();
+};
+
+// Conversions between Mesh and IndexedMesh. Vertices and faces keep the order
+// in which the Mesh lists them.
+void MeshToIndexedMesh(const Mesh& mesh, IndexedMesh* indexed_mesh);
+// Returns false, leaving mesh empty, if indexed_mesh is not a valid
+// polyhedral surface.
+bool IndexedMeshToMesh(const IndexedMesh& indexed_mesh, Mesh* mesh);
+
+// Apply one step of Catmull-Clark subdivision to mesh and store the result in
+// subdivided, which must be a different object. This uses the same rules as
+// CGAL::Subdivision_method_3::CatmullClark_subdivision, border included, but
+// orders the new vertices differently: the moved original vertices come
+// first, then one vertex per edge, then one vertex per face. Face, edge and
+// vertex points are computed in parallel (see ParallelFor). The result only
+// has quads; quad i is the one at corner i of mesh (i.e. at
+// mesh.face_vertices[i]).
+void CatmullClarkStep(const IndexedMesh& mesh, IndexedMesh* subdivided);
+
+}  // namespace model
+}  // namespace ginsu
+#endif  // GINSU_MODEL_SUBDIVISION_H_
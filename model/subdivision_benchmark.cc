@@ -0,0 +1,91 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares CGAL's Catmull-Clark subdivision of a Polyhedron_3 with
+// CatmullClarkStep on an IndexedMesh, serial and parallel.
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include "model/mesh.h"
+#include "model/parallel_for.h"
+#include "model/subdivision.h"
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Subdivision_method_3.h>
+
+namespace {
+
+using ginsu::model::IndexedMesh;
+using ginsu::model::Mesh;
+
+// The demo mesh: corner.off from the CGAL distribution.
+const char kCorner[] =
+    "OFF\n14 24 0\n"
+    "-0.125 -0.125 -0.125\n-0.125 0.125 -0.125\n0.125 0.125 -0.125\n"
+    "0.125 -0.125 -0.125\n-0.125 -0.125 0.125\n-0.125 0.125 0.125\n"
+    "0.125 0.125 0.125\n0.125 -0.125 0.125\n0.5 0 0\n0 0.5 0\n-0.5 0 0\n"
+    "0 -0.5 0\n0 0 0.5\n0 0 -0.5\n"
+    "3 0 1 13\n3 1 2 13\n3 2 3 13\n3 3 0 13\n3 3 2 8\n3 7 3 8\n3 6 7 8\n"
+    "3 2 6 8\n3 7 6 12\n3 4 7 12\n3 5 4 12\n3 6 5 12\n3 4 5 10\n3 5 1 10\n"
+    "3 1 0 10\n3 0 4 10\n3 5 6 9\n3 6 2 9\n3 2 1 9\n3 1 5 9\n3 7 4 11\n"
+    "3 3 7 11\n3 0 3 11\n3 4 0 11\n";
+
+const int kLevels = 6;
+
+double Now() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+// Subdivide kCorner kLevels times with CatmullClarkStep and convert the
+// result to a Mesh. Returns the elapsed time.
+double RunIndexed(size_t* facet_count) {
+  Mesh mesh;
+  std::istringstream stream(kCorner);
+  stream >> mesh;
+  double start = Now();
+  IndexedMesh levels[2];
+  ginsu::model::MeshToIndexedMesh(mesh, &levels[0]);
+  for (int i = 0; i < kLevels; ++i)
+    ginsu::model::CatmullClarkStep(levels[i % 2], &levels[(i + 1) % 2]);
+  double subdivided = Now();
+  Mesh result;
+  ginsu::model::IndexedMeshToMesh(levels[kLevels % 2], &result);
+  double end = Now();
+  printf("    subdivision %.3fs, conversion to Mesh %.3fs\n",
+         subdivided - start, end - subdivided);
+  *facet_count = result.size_of_facets();
+  return end - start;
+}
+
+TEST(SubdivisionBenchmark, CatmullClark) {
+  Mesh mesh;
+  std::istringstream stream(kCorner);
+  stream >> mesh;
+  double start = Now();
+  CGAL::Subdivision_method_3::CatmullClark_subdivision(mesh, kLevels);
+  double cgal_time = Now() - start;
+  printf("CGAL, %d levels: %.3fs, %d facets\n", kLevels, cgal_time,
+         static_cast<int>(mesh.size_of_facets()));
+
+  int thread_count = ginsu::model::GetParallelThreadCount();
+  ginsu::model::SetParallelThreadCount(1);
+  size_t facet_count = 0;
+  printf("IndexedMesh, 1 thread:\n");
+  double serial_time = RunIndexed(&facet_count);
+  printf("    total %.3fs\n", serial_time);
+  EXPECT_EQ(mesh.size_of_facets(), facet_count);
+
+  ginsu::model::SetParallelThreadCount(thread_count);
+  printf("IndexedMesh, %d thread(s):\n", thread_count);
+  double parallel_time = RunIndexed(&facet_count);
+  printf("    total %.3fs\n", parallel_time);
+  EXPECT_EQ(mesh.size_of_facets(), facet_count);
+}
+
+}  // namespace
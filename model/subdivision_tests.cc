@@ -0,0 +1,153 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "model/mesh.h"
+#include "model/parallel_for.h"
+#include "model/subdivision.h"
+#include <CGAL/IO/Polyhedron_iostream.h>
+#include <CGAL/Subdivision_method_3.h>
+
+namespace {
+
+using ginsu::model::IndexedMesh;
+using ginsu::model::Mesh;
+
+// A closed cube with quad faces.
+const char kCube[] =
+    "OFF\n8 6 0\n"
+    "-1 -1 -1\n1 -1 -1\n1 1 -1\n-1 1 -1\n"
+    "-1 -1 1\n1 -1 1\n1 1 1\n-1 1 1\n"
+    "4 0 3 2 1\n4 4 5 6 7\n4 0 1 5 4\n"
+    "4 1 2 6 5\n4 2 3 7 6\n4 3 0 4 7\n";
+
+// An open, non-planar surface with triangles, quads and a pentagon.
+const char kOpenSurface[] =
+    "OFF\n9 6 0\n"
+    "0 0 0\n1 0 0.2\n2 0 0\n0 1 0.1\n1 1 0.5\n2 1 0.1\n0 2 0\n1 2 0.2\n"
+    "2 2 0\n"
+    "4 0 1 4 3\n3 1 2 5\n3 1 5 4\n4 3 4 7 6\n3 4 5 8\n3 4 8 7\n";
+
+class SubdivisionTest : public ::testing::Test {
+ protected:
+  static void ReadMesh(const char* off, Mesh* mesh) {
+    std::istringstream stream(off);
+    stream >> *mesh;
+  }
+
+  // Return true if the two meshes have the same vertices, in any order.
+  static bool SamePoints(const IndexedMesh& mesh1, const IndexedMesh& mesh2) {
+    if (mesh1.vertex_count() != mesh2.vertex_count())
+      return false;
+    std::vector<bool> matched(mesh2.vertex_count(), false);
+    for (size_t v1 = 0; v1 < mesh1.vertex_count(); ++v1) {
+      const double* p1 = &mesh1.points[3 * v1];
+      bool found = false;
+      for (size_t v2 = 0; v2 < mesh2.vertex_count() && !found; ++v2) {
+        const double* p2 = &mesh2.points[3 * v2];
+        found = !matched[v2] && fabs(p1[0] - p2[0]) < 1e-9 &&
+                fabs(p1[1] - p2[1]) < 1e-9 && fabs(p1[2] - p2[2]) < 1e-9;
+        if (found)
+          matched[v2] = true;
+      }
+      if (!found)
+        return false;
+    }
+    return true;
+  }
+
+  // Check that num_steps steps of CatmullClarkStep give the same surface
+  // as CGAL's Catmull-Clark subdivision.
+  static void ExpectSameAsCgal(const char* off, int num_steps) {
+    Mesh cgal_mesh;
+    ReadMesh(off, &cgal_mesh);
+    IndexedMesh subdivided;
+    ginsu::model::MeshToIndexedMesh(cgal_mesh, &subdivided);
+    for (int i = 0; i < num_steps; ++i) {
+      IndexedMesh input;
+      input.points.swap(subdivided.points);
+      input.face_offsets.swap(subdivided.face_offsets);
+      input.face_vertices.swap(subdivided.face_vertices);
+      ginsu::model::CatmullClarkStep(input, &subdivided);
+    }
+    CGAL::Subdivision_method_3::CatmullClark_subdivision(cgal_mesh,
+                                                         num_steps);
+    IndexedMesh expected;
+    ginsu::model::MeshToIndexedMesh(cgal_mesh, &expected);
+
+    ASSERT_EQ(expected.vertex_count(), subdivided.vertex_count());
+    ASSERT_EQ(expected.face_count(), subdivided.face_count());
+    EXPECT_TRUE(SamePoints(expected, subdivided));
+
+    Mesh mesh;
+    ASSERT_TRUE(ginsu::model::IndexedMeshToMesh(subdivided, &mesh));
+    EXPECT_TRUE(mesh.is_valid());
+    EXPECT_EQ(cgal_mesh.size_of_halfedges(), mesh.size_of_halfedges());
+  }
+};
+
+TEST_F(SubdivisionTest, RoundTrip) {
+  Mesh mesh;
+  ReadMesh(kCube, &mesh);
+  IndexedMesh indexed_mesh;
+  ginsu::model::MeshToIndexedMesh(mesh, &indexed_mesh);
+  EXPECT_EQ(8u, indexed_mesh.vertex_count());
+  EXPECT_EQ(6u, indexed_mesh.face_count());
+  EXPECT_EQ(24u, indexed_mesh.face_vertices.size());
+
+  Mesh copy;
+  ASSERT_TRUE(ginsu::model::IndexedMeshToMesh(indexed_mesh, &copy));
+  EXPECT_TRUE(copy.is_valid());
+  EXPECT_TRUE(copy.is_closed());
+  EXPECT_EQ(mesh.size_of_vertices(), copy.size_of_vertices());
+  EXPECT_EQ(mesh.size_of_facets(), copy.size_of_facets());
+}
+
+TEST_F(SubdivisionTest, InvalidIndexedMesh) {
+  // Two faces with the same orientation on a shared edge.
+  IndexedMesh indexed_mesh;
+  double points[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+  unsigned int offsets[] = { 0, 3, 6 };
+  unsigned int vertices[] = { 0, 1, 2, 0, 1, 3 };
+  indexed_mesh.points.assign(points, points + 12);
+  indexed_mesh.face_offsets.assign(offsets, offsets + 3);
+  indexed_mesh.face_vertices.assign(vertices, vertices + 6);
+  Mesh mesh;
+  EXPECT_FALSE(ginsu::model::IndexedMeshToMesh(indexed_mesh, &mesh));
+  EXPECT_TRUE(mesh.empty());
+}
+
+TEST_F(SubdivisionTest, ClosedMeshMatchesCgal) {
+  ExpectSameAsCgal(kCube, 1);
+  ExpectSameAsCgal(kCube, 3);
+}
+
+TEST_F(SubdivisionTest, OpenMeshMatchesCgal) {
+  ExpectSameAsCgal(kOpenSurface, 1);
+  ExpectSameAsCgal(kOpenSurface, 2);
+}
+
+TEST_F(SubdivisionTest, ThreadCountDoesNotChangeResult) {
+  Mesh mesh;
+  ReadMesh(kCube, &mesh);
+  IndexedMesh level1, level2, level3;
+  ginsu::model::MeshToIndexedMesh(mesh, &level1);
+  ginsu::model::CatmullClarkStep(level1, &level2);
+  ginsu::model::CatmullClarkStep(level2, &level3);
+
+  int thread_count = ginsu::model::GetParallelThreadCount();
+  ginsu::model::SetParallelThreadCount(1);
+  IndexedMesh serial;
+  ginsu::model::CatmullClarkStep(level2, &serial);
+  ginsu::model::SetParallelThreadCount(thread_count);
+  EXPECT_TRUE(serial.points == level3.points);
+  EXPECT_TRUE(serial.face_vertices == level3.face_vertices);
+}
+
+}  // namespace
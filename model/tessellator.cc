@@ -3,6 +3,10 @@
 // found in the LICENSE file.
 
 #include "model/tessellator.h"
+
+#include <math.h>
+
+#include "boost/shared_ptr.hpp"
 #include "model/component.h"
 #include "model/kernel.h"
 #include "model/mesh.h"
@@ -10,21 +14,91 @@
 #include <CGAL/Polyhedron_3.h>
 
 namespace {
-// User data passed to the glu callback functions.
-struct UserData {
-  ginsu::model::Tessellator* tessellator;
-  ginsu::model::Tessellator::TriangleData triangle_data;
-};
-
 template<typename T> float ToFloat(T val) {
   return static_cast<float>(CGAL::to_double(val));
 }
 
+// Return true if the polygon given by vertex_count vertices (three coordinates
+// each) is convex and winds counter-clockwise, exactly once, about normal.
+// Such polygons can be triangulated as a simple fan from their first vertex.
+// Collinear vertices are tolerated.
+bool IsConvexPolygon(const GLdouble* vertices, int vertex_count,
+                     const GLdouble normal[3]) {
+  if (normal[0] == 0.0 && normal[1] == 0.0 && normal[2] == 0.0)
+    return false;
+  if (vertex_count == 3)
+    return true;
+
+  // Orientation of the triangle (a, b, c) with respect to normal.
+  struct Orientation {
+    static GLdouble Of(const GLdouble* a, const GLdouble* b, const GLdouble* c,
+                       const GLdouble normal[3]) {
+      GLdouble u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      GLdouble v[3] = { c[0] - b[0], c[1] - b[1], c[2] - b[2] };
+      return normal[0] * (u[1] * v[2] - u[2] * v[1]) +
+             normal[1] * (u[2] * v[0] - u[0] * v[2]) +
+             normal[2] * (u[0] * v[1] - u[1] * v[0]);
+    }
+  };
+  // Every corner must turn left. That isn't enough to rule out polygons that
+  // wind more than once (e.g. a pentagram), so also require every triangle of
+  // the fan about vertex 0 to be positively oriented.
+  const GLdouble* first = vertices;
+  for (int i = 0; i < vertex_count; ++i) {
+    const GLdouble* a = vertices + 3 * i;
+    const GLdouble* b = vertices + 3 * ((i + 1) % vertex_count);
+    const GLdouble* c = vertices + 3 * ((i + 2) % vertex_count);
+    if (Orientation::Of(a, b, c, normal) < 0.0)
+      return false;
+    if (i > 0 && i < vertex_count - 1 &&
+        Orientation::Of(first, a, b, normal) < 0.0)
+      return false;
+  }
+  return true;
+}
+
+// Compute the Newell normal of the polygon given by vertex_count vertices
+// (three coordinates each). Unlike the normal of the plane through three of
+// its vertices, it accounts for the whole contour, so it points the way the
+// polygon winds even when some corners are reflex. Its length is twice the
+// area of the polygon.
+void ComputeNewellNormal(const GLdouble* vertices, int vertex_count,
+                         GLdouble normal[3]) {
+  normal[0] = normal[1] = normal[2] = 0.0;
+  // Sum the cross products relative to the first vertex, which keeps the
+  // terms small for polygons far from the origin.
+  const GLdouble* first = vertices;
+  for (int i = 1; i < vertex_count - 1; ++i) {
+    const GLdouble* a = vertices + 3 * i;
+    const GLdouble* b = vertices + 3 * (i + 1);
+    GLdouble u[3] = { a[0] - first[0], a[1] - first[1], a[2] - first[2] };
+    GLdouble v[3] = { b[0] - first[0], b[1] - first[1], b[2] - first[2] };
+    normal[0] += u[1] * v[2] - u[2] * v[1];
+    normal[1] += u[2] * v[0] - u[0] * v[2];
+    normal[2] += u[0] * v[1] - u[1] * v[0];
+  }
+}
+
 }  // anonymous namespace
 
 namespace ginsu {
 namespace model {
 
+struct Tessellator::UserData {
+  Tessellator* tessellator;
+  TriangleData triangle_data;
+  // Coordinates of the facet vertices passed to gluTessVertex, and the
+  // index of each of these vertices in the batched triangle buffer.
+  const GLdouble* vertices;
+  const unsigned int* indices;
+};
+
+struct Tessellator::FacetCursor {
+  const Mesh* mesh;
+  size_t facet_index;
+  Mesh::Facet_const_iterator facet;
+};
+
 //void Tessellator::Tessellate(const Component& component) {
 //  GLUtesselator* glu_tess = CreateGluTessellator();
 //  // TODO(gwink): Using a fixed-size array to accumulate vertices, for now.
@@ -71,47 +145,260 @@ namespace model {
 //  gluDeleteTess(glu_tess);
 //}
 
+void Tessellator::TriangleBuffer::Clear() {
+  positions.clear();
+  normals.clear();
+  triangle_indices.clear();
+  edge_indices.clear();
+}
+
+Tessellator::Tessellator()
+    : glu_tess_(NULL),
+      batched_output_(false),
+      max_batch_vertices_(0),
+      share_vertices_(false) {
+  ResetStatistics();
+}
+
+Tessellator::~Tessellator() {
+  if (glu_tess_ != NULL)
+    gluDeleteTess(glu_tess_);
+}
+
+void Tessellator::EnableBatchedOutput(size_t max_batch_vertices) {
+  batched_output_ = true;
+  max_batch_vertices_ = max_batch_vertices;
+}
+
+void Tessellator::EnableSharedVertices() {
+  share_vertices_ = true;
+}
+
+void Tessellator::ResetStatistics() {
+  statistics_.fast_path_facets = 0;
+  statistics_.glu_facets = 0;
+  statistics_.glu_fan_facets = 0;
+}
+
 void Tessellator::Tessellate(const Component& component) {
-  GLUtesselator* glu_tess = CreateGluTessellator();
-  // Iterate over the facets in the component.
-  Mesh::Facet_const_iterator facet;
-  for (facet = component.mesh()->facets_begin();
-       facet != component.mesh()->facets_end();
-       ++facet) {
+  Tessellate(component, 0);
+}
+
+void Tessellator::Tessellate(const Component& component,
+                             int subdivision_level) {
+  // Holds on to the subdivided mesh, which may be dropped from the
+  // component's cache in the meantime.
+  boost::shared_ptr<Mesh> mesh =
+      component.GetSubdivisionLevel(subdivision_level);
+  TessellateFacets(*mesh, 0, mesh->size_of_facets());
+}
+
+void Tessellator::TessellateFacets(const Mesh& mesh, size_t facet_begin,
+                                   size_t facet_end) {
+  if (glu_tess_ == NULL)
+    glu_tess_ = CreateGluTessellator();
+  GLUtesselator* glu_tess = glu_tess_;
+  // Coordinates of the current facet's vertices. Glu keeps pointers into this
+  // array until gluTessEndPolygon, so it must be filled before the first
+  // call to gluTessVertex.
+  std::vector<GLdouble> vertices;
+  // The mesh vertex behind each facet vertex, and whether the facet edge
+  // starting at that vertex goes in the edge indices.
+  std::vector<const void*> mesh_vertices;
+  std::vector<bool> edge_owned;
+  // Iterate over the facets in the range, starting from where the previous
+  // call stopped if it can be resumed.
+  Mesh::Facet_const_iterator facet = mesh.facets_begin();
+  size_t facet_index = 0;
+  if (facet_cursor_ != NULL && facet_begin > 0 &&
+      facet_cursor_->mesh == &mesh &&
+      facet_cursor_->facet_index == facet_begin) {
+    facet = facet_cursor_->facet;
+    facet_index = facet_begin;
+  }
+  for (; facet != mesh.facets_end() && facet_index < facet_begin;
+       ++facet, ++facet_index) {
+  }
+  for (; facet != mesh.facets_end() && facet_index < facet_end;
+       ++facet, ++facet_index) {
     UserData user_data;
     Mesh::Facet::Halfedge_around_facet_const_circulator  edge;
     edge = facet->facet_begin();
 
-    // Compute a plane from the first three vertices.
-    Mesh::Facet::Plane_3  plane(edge->vertex()->point(),
-                                edge->next()->vertex()->point(),
-                                edge->next()->next()->vertex()->point());
-    Vector_3 normal = plane.orthogonal_vector();
-    user_data.triangle_data.normal_x = ToFloat(normal.x());
-    user_data.triangle_data.normal_y = ToFloat(normal.y());
-    user_data.triangle_data.normal_z = ToFloat(normal.z());
+    vertices.clear();
+    mesh_vertices.clear();
+    edge_owned.clear();
+    do {
+      const Point_3& point = edge->vertex()->point();
+      vertices.push_back(ToFloat(point.x()));
+      vertices.push_back(ToFloat(point.y()));
+      vertices.push_back(ToFloat(point.z()));
+      mesh_vertices.push_back(&*edge->vertex());
+      // With shared vertices, an edge between two facets is listed by the
+      // facet of its lower-address halfedge only.
+      Mesh::Halfedge_const_handle facet_edge = edge->next();
+      Mesh::Halfedge_const_handle opposite = facet_edge->opposite();
+      edge_owned.push_back(!share_vertices_ || opposite->is_border() ||
+                           &*facet_edge < &*opposite);
+    } while (++edge != facet->facet_begin());
+    int vertex_count = static_cast<int>(vertices.size() / 3);
+    user_data.vertices = &vertices[0];
+
+    // The facet normal, from the whole contour: the plane through the first
+    // three vertices faces the wrong way when the first corner is reflex.
+    GLdouble plane_normal[3];
+    ComputeNewellNormal(&vertices[0], vertex_count, plane_normal);
+    user_data.triangle_data.normal_x = static_cast<float>(plane_normal[0]);
+    user_data.triangle_data.normal_y = static_cast<float>(plane_normal[1]);
+    user_data.triangle_data.normal_z = static_cast<float>(plane_normal[2]);
     user_data.tessellator = this;
 
-    // TODO(gwink): Using a fixed-size array to accumulate vertices, for now.
-    double vertices[64][3];
-    int vertex_count = 0;
-    gluTessBeginPolygon(glu_tess, &user_data);
-    gluTessBeginContour(glu_tess);
-    do {
-      Point_3 point = edge->vertex()->point();
-
-      vertices[vertex_count][0] = ToFloat(point.x());
-      vertices[vertex_count][1] = ToFloat(point.y());
-      vertices[vertex_count][2] = ToFloat(point.z());
-      gluTessVertex(glu_tess, vertices[vertex_count],
-                    vertices[vertex_count]);
-      ++vertex_count;
-    } while(++edge != facet->facet_begin());
-    gluTessEndContour(glu_tess);
-    gluTessEndPolygon(glu_tess);
+    user_data.indices = NULL;
+    if (batched_output_) {
+      // Put the facet vertices in the buffer once; glu's output is then
+      // translated into buffer indices through facet_indices_.
+      float length = ::sqrt(
+          user_data.triangle_data.normal_x * user_data.triangle_data.normal_x +
+          user_data.triangle_data.normal_y * user_data.triangle_data.normal_y +
+          user_data.triangle_data.normal_z * user_data.triangle_data.normal_z);
+      float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+      float unit_normal[3] = { user_data.triangle_data.normal_x * scale,
+                               user_data.triangle_data.normal_y * scale,
+                               user_data.triangle_data.normal_z * scale };
+      facet_indices_.clear();
+      for (int i = 0; i < vertex_count; ++i) {
+        facet_indices_.push_back(
+            AddBufferVertex(mesh_vertices[i], &vertices[3 * i], unit_normal));
+      }
+      // The facet boundary is made of the edges between consecutive
+      // vertices.
+      for (int i = 0; i < vertex_count; ++i) {
+        if (edge_owned[i]) {
+          triangle_buffer_.edge_indices.push_back(facet_indices_[i]);
+          triangle_buffer_.edge_indices.push_back(
+              facet_indices_[(i + 1) % vertex_count]);
+        }
+      }
+      user_data.indices = &facet_indices_[0];
+    }
+
+    if (IsConvexPolygon(&vertices[0], vertex_count, plane_normal)) {
+      // Triangles, and most quads, take this path: emit a fan directly.
+      ++statistics_.fast_path_facets;
+      EmitConvexFacet(user_data, vertex_count);
+    } else {
+      // Concave facets need the full sweep. Handing glu the facet normal
+      // spares it from computing one, and from checking the orientation.
+      ++statistics_.glu_facets;
+      GLdouble fan_count = 0.0;
+      gluGetTessProperty(glu_tess, GLU_TESS_FAN_RENDERED, &fan_count);
+      gluTessNormal(glu_tess, plane_normal[0], plane_normal[1],
+                    plane_normal[2]);
+      gluTessBeginPolygon(glu_tess, &user_data);
+      gluTessBeginContour(glu_tess);
+      for (int i = 0; i < vertex_count; ++i) {
+        gluTessVertex(glu_tess, &vertices[3 * i], &vertices[3 * i]);
+      }
+      gluTessEndContour(glu_tess);
+      gluTessEndPolygon(glu_tess);
+      GLdouble new_fan_count = 0.0;
+      gluGetTessProperty(glu_tess, GLU_TESS_FAN_RENDERED, &new_fan_count);
+      if (new_fan_count > fan_count)
+        ++statistics_.glu_fan_facets;
+    }
+
+    if (batched_output_ && max_batch_vertices_ > 0 &&
+        triangle_buffer_.vertex_count() >= max_batch_vertices_) {
+      FlushTriangleBuffer();
+    }
+  }
+  if (batched_output_) {
+    FlushTriangleBuffer();
   }
 
-  gluDeleteTess(glu_tess);
+  if (facet_cursor_ == NULL)
+    facet_cursor_.reset(new FacetCursor);
+  facet_cursor_->mesh = &mesh;
+  facet_cursor_->facet_index = facet_index;
+  facet_cursor_->facet = facet;
+}
+
+void Tessellator::EmitConvexFacet(const UserData& user_data,
+                                  int vertex_count) {
+  if (batched_output_) {
+    // The facet vertices are already in the buffer.
+    std::vector<unsigned int>& indices = triangle_buffer_.triangle_indices;
+    for (int i = 1; i < vertex_count - 1; ++i) {
+      indices.push_back(user_data.indices[0]);
+      indices.push_back(user_data.indices[i]);
+      indices.push_back(user_data.indices[i + 1]);
+    }
+    return;
+  }
+
+  // Mimic what glu outputs when edge flags are requested: independent
+  // triangles, with each vertex preceded by the flag of the edge it starts.
+  TriangleData triangle_data = user_data.triangle_data;
+  triangle_data.flavor = kTriangles;
+  BeginTriangleData(triangle_data);
+  for (int i = 1; i < vertex_count - 1; ++i) {
+    int corners[3] = { 0, i, i + 1 };
+    bool boundary[3] = { i == 1, true, i + 1 == vertex_count - 1 };
+    for (int j = 0; j < 3; ++j) {
+      const GLdouble* point = user_data.vertices + 3 * corners[j];
+      Vertex v;
+      v.x = ToFloat(point[0]);
+      v.y = ToFloat(point[1]);
+      v.z = ToFloat(point[2]);
+      EdgeFlag(boundary[j]);
+      AddVertex(v);
+    }
+  }
+  EndTriangleData();
+}
+
+unsigned int Tessellator::AddBufferVertex(const void* mesh_vertex,
+                                          const GLdouble position[3],
+                                          const float normal[3]) {
+  // Facet normals that differ by less than this are considered equal.
+  static const float kNormalEpsilon = 1e-5f;
+  int* head = NULL;
+  if (share_vertices_) {
+    head = &shared_vertex_heads_.insert(
+        SharedVertexMap::value_type(mesh_vertex, -1)).first->second;
+    for (int i = *head; i >= 0; i = shared_vertices_[i].next) {
+      unsigned int index = shared_vertices_[i].buffer_index;
+      const float* other = &triangle_buffer_.normals[3 * index];
+      if (::fabs(other[0] - normal[0]) < kNormalEpsilon &&
+          ::fabs(other[1] - normal[1]) < kNormalEpsilon &&
+          ::fabs(other[2] - normal[2]) < kNormalEpsilon) {
+        return index;
+      }
+    }
+  }
+
+  unsigned int index =
+      static_cast<unsigned int>(triangle_buffer_.vertex_count());
+  for (int j = 0; j < 3; ++j) {
+    triangle_buffer_.positions.push_back(static_cast<float>(position[j]));
+    triangle_buffer_.normals.push_back(normal[j]);
+  }
+  if (head != NULL) {
+    SharedVertex shared_vertex = { index, *head };
+    *head = static_cast<int>(shared_vertices_.size());
+    shared_vertices_.push_back(shared_vertex);
+  }
+  return index;
+}
+
+void Tessellator::FlushTriangleBuffer() {
+  if (!triangle_buffer_.empty()) {
+    AddTriangleBuffer(triangle_buffer_);
+    triangle_buffer_.Clear();
+  }
+  // Buffer indices don't carry over to the next buffer.
+  shared_vertex_heads_.clear();
+  shared_vertices_.clear();
 }
 
 void Tessellator::BeginTriangleData(const TriangleData& triangles) {
@@ -130,65 +417,57 @@ void Tessellator::EdgeFlag(bool flag) {
   // Subclass implements.
 }
 
+void Tessellator::AddTriangleBuffer(const TriangleBuffer& buffer) {
+  // Subclass implements.
+}
+
 GLUtesselator* Tessellator::CreateGluTessellator() {
   GLUtesselator* glu_tess = gluNewTess();
-  gluTessCallback(glu_tess, GLenum(GLU_TESS_VERTEX_DATA),
-                  (CallbackFunc) &VertexGluCallback);
-  gluTessCallback(glu_tess, GLenum(GLU_TESS_BEGIN_DATA),
-                  (CallbackFunc) &BeginGluCallback);
-  gluTessCallback(glu_tess, GLenum(GLU_TESS_END_DATA),
-                  (CallbackFunc) &EndGluCallback);
+  gluTessCallback(glu_tess, GLenum(GLU_TESS_TRIANGLES_DATA),
+                  (CallbackFunc) &TrianglesGluCallback);
   gluTessCallback(glu_tess, GLenum(GLU_TESS_ERROR_DATA),
                   (CallbackFunc) &ErrorGluCallback);
-  gluTessCallback(glu_tess, GLenum(GLU_TESS_EDGE_FLAG_DATA),
-                  (CallbackFunc) &EdgeFlagGluCallback);
   gluTessProperty(glu_tess, GLenum(GLU_TESS_WINDING_RULE),
                   GLU_TESS_WINDING_POSITIVE);
   return glu_tess;
 }
 
-void Tessellator::BeginGluCallback(GLenum which, void* user_data) {
-  UserData* data = reinterpret_cast<UserData*>(user_data);
-  data->triangle_data.flavor = kTriangles;
-  switch(which) {
-    case GL_TRIANGLE_FAN: {
-      data->triangle_data.flavor = kTriangleFan;
-      break;
-    }
-    case GL_TRIANGLE_STRIP: {
-      data->triangle_data.flavor = kTriangleStrip;
-      break;
-    }
-    default: {
-      break;
-    }
-  }
-  data->tessellator->BeginTriangleData(data->triangle_data);
-}
-
-void Tessellator::EndGluCallback(void* user_data) {
-  UserData* data = reinterpret_cast<UserData*>(user_data);
-  data->tessellator->EndTriangleData();
-}
-
 void Tessellator::ErrorGluCallback(GLenum errorCode, void* user_data) {
   UserData* data = reinterpret_cast<UserData*>(user_data);
 }
 
-void Tessellator::VertexGluCallback(void* vertex, void* user_data) {
-  UserData* data = reinterpret_cast<UserData*>(user_data);
-  GLdouble* point = reinterpret_cast<GLdouble*>(vertex);
-
-  Vertex v;
-  v.x = ToFloat(point[0]);
-  v.y = ToFloat(point[1]);
-  v.z = ToFloat(point[2]);
-  data->tessellator->AddVertex(v);
-}
-
-void Tessellator::EdgeFlagGluCallback(GLboolean flag, void *user_data) {
+void Tessellator::TrianglesGluCallback(int count, void** vertex_data,
+                                       GLboolean* boundary_edge,
+                                       void* user_data) {
   UserData* data = static_cast<UserData*>(user_data);
-  data->tessellator->EdgeFlag(flag);
+  Tessellator* tessellator = data->tessellator;
+  if (tessellator->batched_output_) {
+    // The vertices were put in the buffer along with their facet; just
+    // record their indices.
+    std::vector<unsigned int>& indices =
+        tessellator->triangle_buffer_.triangle_indices;
+    for (int i = 0; i < 3 * count; ++i) {
+      const GLdouble* point = static_cast<const GLdouble*>(vertex_data[i]);
+      indices.push_back(data->indices[(point - data->vertices) / 3]);
+    }
+    return;
+  }
+
+  // Independent triangles, with each vertex preceded by the flag of the
+  // edge it starts, as for convex facets.
+  TriangleData triangle_data = data->triangle_data;
+  triangle_data.flavor = kTriangles;
+  tessellator->BeginTriangleData(triangle_data);
+  for (int i = 0; i < 3 * count; ++i) {
+    const GLdouble* point = static_cast<const GLdouble*>(vertex_data[i]);
+    Vertex v;
+    v.x = ToFloat(point[0]);
+    v.y = ToFloat(point[1]);
+    v.z = ToFloat(point[2]);
+    tessellator->EdgeFlag(boundary_edge[i] != 0);
+    tessellator->AddVertex(v);
+  }
+  tessellator->EndTriangleData();
 }
 
 }  // namespace model
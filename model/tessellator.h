@@ -4,16 +4,23 @@
 #ifndef GINSU_MODEL_TESSELLATOR_H_
 #define GINSU_MODEL_TESSELLATOR_H_
 
+#include <stddef.h>
+#include <vector>
+
+#include "boost/scoped_ptr.hpp"
+#include "boost/tr1/unordered_map.hpp"
 #include "third_party/glu_tessellator/glu_tessellator.h"
 
 namespace ginsu {
 namespace model {
-  
+
 class Component;
+class Mesh;
 
 // Component tessellator. Usage:
 // 1. Subclass Tessellator and override BeginTriangleData, AddVertex and
-//    EndTriangleData.
+//    EndTriangleData. Alternatively, call EnableBatchedOutput and override
+//    AddTriangleBuffer to receive the triangles in large contiguous batches.
 // 2. Invoke Tessellate(component) for each component to convert to triangles.
 class Tessellator {
  public:
@@ -35,11 +42,72 @@ class Tessellator {
     float normal_x, normal_y, normal_z;  // Normal vector of embedding plane
   };
 
+  // A batch of triangles, as delivered to AddTriangleBuffer. Positions and
+  // normals are stored as three consecutive floats per vertex, so that the
+  // arrays can be appended to a vertex array in a single copy. Normals are
+  // unit-length facet normals. Triangles are listed as three indices each
+  // (i.e. GL_TRIANGLES) and boundary edges as two indices each (GL_LINES);
+  // indices are relative to the start of this buffer.
+  struct TriangleBuffer {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<unsigned int> triangle_indices;
+    std::vector<unsigned int> edge_indices;
+
+    size_t vertex_count() const { return positions.size() / 3; }
+    bool empty() const { return positions.empty(); }
+    void Clear();
+  };
+
+  // Counts of facets by tessellation path. Triangles and convex facets are
+  // fanned directly; concave facets go through the glu tessellator.
+  // glu_fan_facets counts the glu facets that glu could still render as a
+  // fan, without running the sweep.
+  struct Statistics {
+    int fast_path_facets;
+    int glu_facets;
+    int glu_fan_facets;
+  };
+
+  Tessellator();
+  virtual ~Tessellator();
+
   // Tessellate the given component. Will call the callbacks below to deliver
   // the tessellation data to the subclass.
   void Tessellate(const Component& component);
+  // Tessellate the component after subdivision_level steps of Catmull-Clark
+  // subdivision (see Component::max_display_subdivision).
+  void Tessellate(const Component& component, int subdivision_level);
+  // Tessellate the facets of mesh in [facet_begin, facet_end), counting in
+  // the order of the mesh's facet list. Only reads mesh, so different
+  // tessellators may work on the same mesh concurrently. Facets are stored
+  // in a list, so finding facet_begin takes a walk, unless the previous call
+  // was on the same mesh and ended at facet_begin; the mesh must not be
+  // modified between such calls.
+  void TessellateFacets(const Mesh& mesh, size_t facet_begin,
+                        size_t facet_end);
+
+  // Statistics accumulated over all calls to Tessellate since construction or
+  // the last call to ResetStatistics.
+  const Statistics& statistics() const { return statistics_; }
+  void ResetStatistics();
 
  protected:
+  // Deliver the tessellation through AddTriangleBuffer rather than through
+  // the per-vertex callbacks. A buffer is handed to the subclass as soon as it
+  // holds max_batch_vertices vertices or more, and once more at the end of
+  // each component. Facets are never split across buffers. Use a
+  // max_batch_vertices of 0 to get a single buffer per component.
+  void EnableBatchedOutput(size_t max_batch_vertices);
+
+  // In batched mode, share buffer vertices between the facets around a mesh
+  // vertex instead of copying each facet's vertices. Since normals are flat,
+  // a mesh vertex is still split into one buffer vertex per distinct facet
+  // normal; coplanar facets (e.g. the triangulation of a flat region) share
+  // all their vertices. Each mesh edge is then listed only once in the edge
+  // indices.
+  void EnableSharedVertices();
+
   // Override these function in a subclass to catch the tessellated geometry.
   // The default implementation does nothing. Not that it is possible for
   // AddVertex to never be called. Such empty faces should simply be
@@ -49,15 +117,61 @@ class Tessellator {
   virtual void EndTriangleData();
   virtual void EdgeFlag(bool flag);
 
-  // Callbacks for the glu tessellator.
-  static void BeginGluCallback(GLenum which, void* user_data);
-  static void EndGluCallback(void* user_data);
+  // Override in a subclass to catch the batched geometry (see
+  // EnableBatchedOutput). The buffer is cleared once the call returns. The
+  // default implementation does nothing.
+  virtual void AddTriangleBuffer(const TriangleBuffer& buffer);
+
+  // Callbacks for the glu tessellator. glu hands over the triangles of each
+  // facet in a single call to TrianglesGluCallback, with their boundary
+  // edges (see GLU_TESS_TRIANGLES_DATA).
   static void ErrorGluCallback(GLenum errorCode, void* user_data);
-  static void VertexGluCallback(void* vertex, void* user_data);
-  static void EdgeFlagGluCallback(GLboolean flag, void *user_data);
+  static void TrianglesGluCallback(int count, void** vertex_data,
+                                   GLboolean* boundary_edge, void* user_data);
 
   // Create and configure a glu tessellator.
   static GLUtesselator* CreateGluTessellator();
+
+ private:
+  // User data passed to the glu callback functions.
+  struct UserData;
+  // Where the previous call to TessellateFacets stopped.
+  struct FacetCursor;
+
+  // Triangulate a convex facet as a fan, bypassing glu. The facet vertices
+  // are those referred to by user_data.
+  void EmitConvexFacet(const UserData& user_data, int vertex_count);
+  // Append a vertex with the given position and unit normal to
+  // triangle_buffer_ and return its index. When vertex sharing is on, an
+  // existing vertex for the same mesh_vertex and normal is reused instead.
+  unsigned int AddBufferVertex(const void* mesh_vertex,
+                               const GLdouble position[3],
+                               const float normal[3]);
+  // Deliver triangle_buffer_ to the subclass, if non-empty, and clear it.
+  void FlushTriangleBuffer();
+
+  // The glu tessellator, created on first use and kept until destruction.
+  GLUtesselator* glu_tess_;
+  boost::scoped_ptr<FacetCursor> facet_cursor_;
+  bool batched_output_;
+  size_t max_batch_vertices_;
+  // Batched output accumulates here.
+  TriangleBuffer triangle_buffer_;
+  // Buffer index of each vertex of the current facet.
+  std::vector<unsigned int> facet_indices_;
+
+  // Shared vertices, valid for the current triangle_buffer_ only. Each mesh
+  // vertex maps to the head of a chain of buffer vertices, one per distinct
+  // normal.
+  struct SharedVertex {
+    unsigned int buffer_index;
+    int next;  // Index in shared_vertices_, or -1.
+  };
+  typedef std::tr1::unordered_map<const void*, int> SharedVertexMap;
+  bool share_vertices_;
+  SharedVertexMap shared_vertex_heads_;
+  std::vector<SharedVertex> shared_vertices_;
+  Statistics statistics_;
 };
 
 }  // namespace model
@@ -0,0 +1,144 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Times the glu tessellator on single polygons of 1k to 100k vertices.
+
+#include <math.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "third_party/glu_tessellator/glu_tessellator.h"
+
+namespace {
+
+double Now() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return time.tv_sec + time.tv_usec * 1e-6;
+}
+
+// Make a comb of tooth_count teeth pointing along x, as three coordinates
+// per vertex. A sweep line along y crosses every tooth, so the sweep has
+// about half the edges in its dictionary at once, and each gap between two
+// teeth starts a region that has to be looked up in the dictionary.
+void MakeComb(int tooth_count, std::vector<double>* vertices) {
+  const double tooth_width = 1.0 / (2 * tooth_count);
+  vertices->assign(3, 0.0);
+  for (int i = 0; i < tooth_count; ++i) {
+    double bottom = 2 * i * tooth_width;
+    double top = bottom + tooth_width;
+    double corners[4][2] = {
+      {2.0, bottom}, {2.0, top}, {1.0, top}, {1.0, top + tooth_width}
+    };
+    // The last tooth has no gap above it.
+    int corner_count = (i + 1 < tooth_count) ? 4 : 2;
+    for (int j = 0; j < corner_count; ++j) {
+      vertices->push_back(corners[j][0]);
+      vertices->push_back(corners[j][1]);
+      vertices->push_back(0.0);
+    }
+  }
+  vertices->push_back(0.0);
+  vertices->push_back((2 * tooth_count - 1) * tooth_width);
+  vertices->push_back(0.0);
+}
+
+// Make a grid of square_count squares, slightly shifted so that few of
+// them line up, as three coordinates per vertex. Each square is a contour
+// of its own, so there are many regions but few edges in the dictionary at
+// a time, and most of the time goes to sorting and walking the events.
+void MakeSquares(int square_count, std::vector<double>* vertices) {
+  const int row_size = static_cast<int>(sqrt(static_cast<double>(
+      square_count)));
+  vertices->clear();
+  for (int i = 0; i < square_count; ++i) {
+    double x = i % row_size + 0.1 * (i % 5);
+    double y = i / row_size + 0.1 * (i % 3);
+    double corners[4][2] = {{x, y}, {x + 0.5, y}, {x + 0.5, y + 0.5},
+                            {x, y + 0.5}};
+    for (int j = 0; j < 4; ++j) {
+      vertices->push_back(corners[j][0]);
+      vertices->push_back(corners[j][1]);
+      vertices->push_back(0.0);
+    }
+  }
+}
+
+void CountVertexCallback(void* /* vertex_data */, void* polygon_data) {
+  ++*static_cast<int*>(polygon_data);
+}
+
+// Requesting edge flags makes glu output independent triangles.
+void EdgeFlagCallback(GLboolean /* flag */, void* /* polygon_data */) {
+}
+
+// Tessellate the polygon, made of contours of contour_size vertices each,
+// and return the elapsed time.
+double Tessellate(GLUtesselator* glu_tess, std::vector<double>* vertices,
+                  int contour_size, int* triangle_count) {
+  int vertex_count = 0;
+  double start = Now();
+  gluTessBeginPolygon(glu_tess, &vertex_count);
+  for (size_t i = 0; i < vertices->size(); i += 3) {
+    if (i % (3 * contour_size) == 0) {
+      if (i > 0)
+        gluTessEndContour(glu_tess);
+      gluTessBeginContour(glu_tess);
+    }
+    gluTessVertex(glu_tess, &(*vertices)[i], &(*vertices)[i]);
+  }
+  gluTessEndContour(glu_tess);
+  gluTessEndPolygon(glu_tess);
+  double end = Now();
+  *triangle_count = vertex_count / 3;
+  return end - start;
+}
+
+GLUtesselator* NewGluTessellator() {
+  GLUtesselator* glu_tess = gluNewTess();
+  gluTessCallback(glu_tess, GLenum(GLU_TESS_VERTEX_DATA),
+                  (CallbackFunc) &CountVertexCallback);
+  gluTessCallback(glu_tess, GLenum(GLU_TESS_EDGE_FLAG_DATA),
+                  (CallbackFunc) &EdgeFlagCallback);
+  gluTessNormal(glu_tess, 0.0, 0.0, 1.0);
+  return glu_tess;
+}
+
+const int kVertexCounts[] = {1000, 3000, 10000, 30000, 100000};
+
+TEST(TessellatorBenchmark, GluComb) {
+  GLUtesselator* glu_tess = NewGluTessellator();
+  std::vector<double> vertices;
+  for (size_t i = 0; i < sizeof(kVertexCounts) / sizeof(kVertexCounts[0]);
+       ++i) {
+    MakeComb(kVertexCounts[i] / 4, &vertices);
+    int vertex_count = static_cast<int>(vertices.size()) / 3;
+    int triangle_count = 0;
+    double time = Tessellate(glu_tess, &vertices, vertex_count,
+                             &triangle_count);
+    printf("Comb, %d vertices: %.3fs\n", vertex_count, time);
+    EXPECT_EQ(vertex_count - 2, triangle_count);
+  }
+  gluDeleteTess(glu_tess);
+}
+
+TEST(TessellatorBenchmark, GluSquares) {
+  GLUtesselator* glu_tess = NewGluTessellator();
+  std::vector<double> vertices;
+  for (size_t i = 0; i < sizeof(kVertexCounts) / sizeof(kVertexCounts[0]);
+       ++i) {
+    MakeSquares(kVertexCounts[i] / 4, &vertices);
+    int vertex_count = static_cast<int>(vertices.size()) / 3;
+    int triangle_count = 0;
+    double time = Tessellate(glu_tess, &vertices, 4, &triangle_count);
+    printf("Squares, %d vertices: %.3fs\n", vertex_count, time);
+    EXPECT_EQ(vertex_count / 2, triangle_count);
+  }
+  gluDeleteTess(glu_tess);
+}
+
+}  // namespace
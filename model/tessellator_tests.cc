@@ -0,0 +1,676 @@
+// Copyright (c) 2010 The Ginsu Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "boost/scoped_ptr.hpp"
+#include "model/component.h"
+#include "model/kernel.h"
+#include "model/mesh.h"
+#include "model/parallel_for.h"
+#include "model/parallel_tessellator.h"
+#include "model/tessellator.h"
+#include "third_party/glu_tessellator/glu_tessellator.h"
+
+namespace {
+
+using ginsu::model::Component;
+using ginsu::model::ParallelTessellator;
+using ginsu::model::RangeTask;
+using ginsu::model::Tessellator;
+
+// Collects the tessellation of a component in a single buffer.
+class BufferTessellator : public Tessellator {
+ public:
+  BufferTessellator() {
+    EnableBatchedOutput(0);
+    EnableSharedVertices();
+  }
+
+  const TriangleBuffer& Run(const Component& component,
+                            int subdivision_level) {
+    buffer_.Clear();
+    Tessellate(component, subdivision_level);
+    return buffer_;
+  }
+
+ protected:
+  virtual void AddTriangleBuffer(const TriangleBuffer& buffer) {
+    buffer_ = buffer;
+  }
+
+ private:
+  TriangleBuffer buffer_;
+};
+
+// Collects every batch of the tessellation of a component.
+class BatchTessellator : public Tessellator {
+ public:
+  BatchTessellator(size_t max_batch_vertices, bool share_vertices) {
+    EnableBatchedOutput(max_batch_vertices);
+    if (share_vertices)
+      EnableSharedVertices();
+  }
+
+  const std::vector<TriangleBuffer>& Run(const Component& component,
+                                         int subdivision_level) {
+    buffers_.clear();
+    Tessellate(component, subdivision_level);
+    return buffers_;
+  }
+
+ protected:
+  virtual void AddTriangleBuffer(const TriangleBuffer& buffer) {
+    buffers_.push_back(buffer);
+  }
+
+ private:
+  std::vector<TriangleBuffer> buffers_;
+};
+
+// Collects the triangles of a component through the per-vertex callbacks.
+class VertexTessellator : public Tessellator {
+ public:
+  VertexTessellator() : vertex_count_(0) {}
+
+  // Return the number of triangles.
+  int Run(const Component& component) {
+    vertex_count_ = 0;
+    normals_.clear();
+    Tessellate(component);
+    return vertex_count_ / 3;
+  }
+
+  // The normal of each BeginTriangleData call, three floats each.
+  const std::vector<float>& normals() const { return normals_; }
+
+ protected:
+  virtual void BeginTriangleData(const TriangleData& triangles) {
+    normals_.push_back(triangles.normal_x);
+    normals_.push_back(triangles.normal_y);
+    normals_.push_back(triangles.normal_z);
+  }
+  virtual void AddVertex(const Vertex& vertex) { ++vertex_count_; }
+
+ private:
+  int vertex_count_;
+  std::vector<float> normals_;
+};
+
+// A polygon for glu, and what glu made of it.
+struct GluPolygon {
+  // Three coordinates per vertex; the contours follow each other.
+  std::vector<double> vertices;
+  std::vector<int> contour_sizes;
+  // The output triangles, as indices in vertices, and for each of them
+  // whether the edge it starts is on the boundary.
+  std::vector<int> triangle_indices;
+  std::vector<bool> boundary_edges;
+  GLboolean edge_flag;
+  // Whether glu rendered the polygon as a fan, without the sweep.
+  bool rendered_as_fan;
+  // Allocations made while tessellating the polygon, and whether all the
+  // memory was freed once its tessellator was deleted.
+  int allocation_count;
+  bool all_freed;
+  // Blocks still allocated once the polygon was done.
+  int kept_block_count;
+};
+
+// Make a concave star, with a square hole in every other one so that the
+// sweep has to merge contours.
+void MakeStarPolygon(int seed, GluPolygon* polygon) {
+  const int branch_count = 3 + seed % 13;
+  const double inner_radius = 0.3 + 0.1 * (seed % 4);
+  const double angle_offset = 0.01 * seed;
+  for (int i = 0; i < 2 * branch_count; ++i) {
+    double radius = (i % 2 == 0) ? 1.0 : inner_radius;
+    double angle = angle_offset + M_PI * i / branch_count;
+    polygon->vertices.push_back(radius * cos(angle));
+    polygon->vertices.push_back(radius * sin(angle));
+    polygon->vertices.push_back(0.0);
+  }
+  polygon->contour_sizes.push_back(2 * branch_count);
+  if (seed % 2 == 1) {
+    static const double kHole[4][2] = {
+      {-0.1, -0.1}, {-0.1, 0.1}, {0.1, 0.1}, {0.1, -0.1}
+    };
+    for (int i = 0; i < 4; ++i) {
+      polygon->vertices.push_back(kHole[i][0]);
+      polygon->vertices.push_back(kHole[i][1]);
+      polygon->vertices.push_back(0.0);
+    }
+    polygon->contour_sizes.push_back(4);
+  }
+}
+
+// Allocation hooks that count the blocks in use.
+struct AllocationCounter {
+  int allocation_count;
+  int block_count;
+};
+
+void* CountingAlloc(void* user_data, size_t size) {
+  AllocationCounter* counter = static_cast<AllocationCounter*>(user_data);
+  ++counter->allocation_count;
+  ++counter->block_count;
+  return malloc(size);
+}
+
+void* CountingRealloc(void* user_data, void* ptr, size_t size) {
+  if (ptr == NULL)
+    return CountingAlloc(user_data, size);
+  return realloc(ptr, size);
+}
+
+void CountingFree(void* user_data, void* ptr) {
+  if (ptr != NULL)
+    --static_cast<AllocationCounter*>(user_data)->block_count;
+  free(ptr);
+}
+
+// Make a polygon that is concave, but that glu can still fan from its
+// first vertex: a disk with a notch, with a wavy rim of vertex_count - 1
+// vertices.
+void MakeNotchedDiskPolygon(int vertex_count, GluPolygon* polygon) {
+  polygon->vertices.assign(3, 0.0);
+  for (int i = 0; i < vertex_count - 1; ++i) {
+    double radius = (i % 2 == 0) ? 1.0 : 0.9;
+    double angle = 1.5 * M_PI * i / (vertex_count - 2);
+    polygon->vertices.push_back(radius * cos(angle));
+    polygon->vertices.push_back(radius * sin(angle));
+    polygon->vertices.push_back(0.0);
+  }
+  polygon->contour_sizes.push_back(vertex_count);
+}
+
+void GluVertexCallback(void* vertex_data, void* polygon_data) {
+  GluPolygon* polygon = static_cast<GluPolygon*>(polygon_data);
+  const double* vertex = static_cast<const double*>(vertex_data);
+  polygon->triangle_indices.push_back(
+      static_cast<int>(vertex - &polygon->vertices[0]) / 3);
+  polygon->boundary_edges.push_back(polygon->edge_flag != 0);
+}
+
+// Requesting edge flags makes glu output independent triangles.
+void GluEdgeFlagCallback(GLboolean flag, void* polygon_data) {
+  static_cast<GluPolygon*>(polygon_data)->edge_flag = flag;
+}
+
+void GluTrianglesCallback(int count, void** vertex_data,
+                          GLboolean* boundary_edge, void* polygon_data) {
+  GluPolygon* polygon = static_cast<GluPolygon*>(polygon_data);
+  for (int i = 0; i < 3 * count; ++i) {
+    const double* vertex = static_cast<const double*>(vertex_data[i]);
+    polygon->triangle_indices.push_back(
+        static_cast<int>(vertex - &polygon->vertices[0]) / 3);
+    polygon->boundary_edges.push_back(boundary_edge[i] != 0);
+  }
+}
+
+// The triangles of polygon, each with its boundary edges, rotated to start
+// at its lowest index and sorted, so as to compare tessellations regardless
+// of the order of the output.
+std::vector<std::vector<int> > SortedTriangles(const GluPolygon& polygon) {
+  std::vector<std::vector<int> > triangles;
+  for (size_t i = 0; i + 2 < polygon.triangle_indices.size(); i += 3) {
+    int first = static_cast<int>(
+        std::min_element(&polygon.triangle_indices[i],
+                         &polygon.triangle_indices[i] + 3) -
+        &polygon.triangle_indices[i]);
+    std::vector<int> triangle;
+    for (int j = 0; j < 3; ++j) {
+      size_t corner = i + (first + j) % 3;
+      triangle.push_back(polygon.triangle_indices[corner]);
+      triangle.push_back(polygon.boundary_edges[corner]);
+    }
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+// Tessellates a range of polygons with its own glu tessellator.
+class GluTessellateTask : public RangeTask {
+ public:
+  // Get the triangles through the triangle list callback if triangle_list
+  // is true, and through the vertex and edge flag callbacks otherwise.
+  explicit GluTessellateTask(std::vector<GluPolygon>* polygons,
+                             bool triangle_list = false)
+      : polygons_(polygons),
+        triangle_list_(triangle_list) {}
+
+  virtual void Run(size_t begin, size_t end) {
+    AllocationCounter counter = {0, 0};
+    GLUtesselator* glu_tess = gluNewTess();
+    gluTessAllocator(glu_tess, &CountingAlloc, &CountingRealloc,
+                     &CountingFree, &counter);
+    gluTessCallback(glu_tess, GLenum(GLU_TESS_VERTEX_DATA),
+                    (CallbackFunc) &GluVertexCallback);
+    gluTessCallback(glu_tess, GLenum(GLU_TESS_EDGE_FLAG_DATA),
+                    (CallbackFunc) &GluEdgeFlagCallback);
+    if (triangle_list_) {
+      gluTessCallback(glu_tess, GLenum(GLU_TESS_TRIANGLES_DATA),
+                      (CallbackFunc) &GluTrianglesCallback);
+    }
+    gluTessNormal(glu_tess, 0.0, 0.0, 1.0);
+    for (size_t i = begin; i < end; ++i) {
+      GluPolygon& polygon = (*polygons_)[i];
+      counter.allocation_count = 0;
+      GLdouble fan_count = 0.0;
+      gluGetTessProperty(glu_tess, GLU_TESS_FAN_RENDERED, &fan_count);
+      gluTessBeginPolygon(glu_tess, &polygon);
+      double* vertex = &polygon.vertices[0];
+      for (size_t c = 0; c < polygon.contour_sizes.size(); ++c) {
+        gluTessBeginContour(glu_tess);
+        for (int v = 0; v < polygon.contour_sizes[c]; ++v, vertex += 3)
+          gluTessVertex(glu_tess, vertex, vertex);
+        gluTessEndContour(glu_tess);
+      }
+      gluTessEndPolygon(glu_tess);
+      GLdouble new_fan_count = 0.0;
+      gluGetTessProperty(glu_tess, GLU_TESS_FAN_RENDERED, &new_fan_count);
+      polygon.rendered_as_fan = new_fan_count > fan_count;
+      polygon.allocation_count = counter.allocation_count;
+      polygon.kept_block_count = counter.block_count;
+    }
+    gluDeleteTess(glu_tess);
+    for (size_t i = begin; i < end; ++i)
+      (*polygons_)[i].all_freed = counter.block_count == 0;
+  }
+
+ private:
+  std::vector<GluPolygon>* polygons_;
+  bool triangle_list_;
+};
+
+class TessellatorTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    thread_count_ = ginsu::model::GetParallelThreadCount();
+    cube_.reset(Component::MakeCube());
+  }
+  virtual void TearDown() {
+    ginsu::model::SetParallelThreadCount(thread_count_);
+  }
+
+  static bool SameBuffers(const Tessellator::TriangleBuffer& buffer1,
+                          const Tessellator::TriangleBuffer& buffer2) {
+    return buffer1.positions == buffer2.positions &&
+           buffer1.normals == buffer2.normals &&
+           buffer1.triangle_indices == buffer2.triangle_indices &&
+           buffer1.edge_indices == buffer2.edge_indices;
+  }
+
+  int thread_count_;
+  boost::scoped_ptr<Component> cube_;
+};
+
+TEST_F(TessellatorTest, ParallelMatchesSerial) {
+  // Small enough to be tessellated in one range.
+  BufferTessellator serial;
+  Tessellator::TriangleBuffer expected = serial.Run(*cube_, 2);
+
+  ParallelTessellator parallel;
+  parallel.AddComponent(*cube_, 2);
+  parallel.Run();
+  ASSERT_EQ(1u, parallel.component_count());
+  EXPECT_TRUE(SameBuffers(expected, parallel.result(0)));
+}
+
+TEST_F(TessellatorTest, SplitComponentKeepsTrianglesAndEdges) {
+  // 6144 quads, tessellated in several ranges. Vertices on the seams between
+  // ranges are duplicated, but each triangle and edge comes out once.
+  BufferTessellator serial;
+  Tessellator::TriangleBuffer expected = serial.Run(*cube_, 5);
+
+  ParallelTessellator parallel;
+  parallel.AddComponent(*cube_, 5);
+  parallel.Run();
+  const Tessellator::TriangleBuffer& result = parallel.result(0);
+  EXPECT_EQ(2u * 6144u * 3u, result.triangle_indices.size());
+  EXPECT_EQ(expected.triangle_indices.size(), result.triangle_indices.size());
+  EXPECT_EQ(expected.edge_indices.size(), result.edge_indices.size());
+  EXPECT_LE(expected.vertex_count(), result.vertex_count());
+  for (size_t i = 0; i < result.triangle_indices.size(); ++i)
+    ASSERT_LT(result.triangle_indices[i], result.vertex_count());
+}
+
+TEST_F(TessellatorTest, ThreadCountDoesNotChangeResult) {
+  ginsu::model::SetParallelThreadCount(1);
+  ParallelTessellator single_thread;
+  for (int level = 0; level <= 5; ++level)
+    single_thread.AddComponent(*cube_, level);
+  single_thread.Run();
+
+  ginsu::model::SetParallelThreadCount(4);
+  ParallelTessellator four_threads;
+  for (int level = 0; level <= 5; ++level)
+    four_threads.AddComponent(*cube_, level);
+  four_threads.Run();
+
+  ASSERT_EQ(6u, four_threads.component_count());
+  for (size_t i = 0; i < four_threads.component_count(); ++i)
+    EXPECT_TRUE(SameBuffers(single_thread.result(i), four_threads.result(i)));
+}
+
+TEST_F(TessellatorTest, BatchedOutput) {
+  // Without vertex sharing, each of the 6 quads brings its own 4 vertices,
+  // 2 triangles and 4 boundary edges.
+  BatchTessellator tessellator(0, false);
+  const std::vector<Tessellator::TriangleBuffer>& buffers =
+      tessellator.Run(*cube_, 0);
+  ASSERT_EQ(1u, buffers.size());
+  const Tessellator::TriangleBuffer& buffer = buffers[0];
+  EXPECT_EQ(6u * 4u, buffer.vertex_count());
+  EXPECT_EQ(buffer.positions.size(), buffer.normals.size());
+  EXPECT_EQ(12u * 3u, buffer.triangle_indices.size());
+  EXPECT_EQ(24u * 2u, buffer.edge_indices.size());
+  for (size_t i = 0; i < buffer.triangle_indices.size(); ++i)
+    EXPECT_LT(buffer.triangle_indices[i], buffer.vertex_count());
+  for (size_t i = 0; i < buffer.edge_indices.size(); ++i)
+    EXPECT_LT(buffer.edge_indices[i], buffer.vertex_count());
+  for (size_t i = 0; i < buffer.vertex_count(); ++i) {
+    const float* normal = &buffer.normals[3 * i];
+    EXPECT_NEAR(1.0f, normal[0] * normal[0] + normal[1] * normal[1] +
+                      normal[2] * normal[2], 1e-5f);
+  }
+
+  // The per-vertex callbacks see the same triangles.
+  VertexTessellator unbatched;
+  EXPECT_EQ(12, unbatched.Run(*cube_));
+}
+
+TEST_F(TessellatorTest, ConvexFacetsAreFanned) {
+  // The quads of the subdivided cube never reach glu.
+  BatchTessellator tessellator(0, false);
+  tessellator.Run(*cube_, 1);
+  EXPECT_EQ(6 * 4, tessellator.statistics().fast_path_facets);
+  EXPECT_EQ(0, tessellator.statistics().glu_facets);
+
+  // A convex pentagon is fanned from its first vertex.
+  std::istringstream input(
+      "OFF\n"
+      "6 2 0\n"
+      "0 0 0\n  2 0 0\n  3 1 0\n  1 2 0\n  -1 1 0\n  0 0 1\n"
+      "5 0 1 2 3 4\n"
+      "3 1 0 5\n");
+  Component* component = Component::MakeEmpty();
+  component->ReadOffStream(input);
+  tessellator.ResetStatistics();
+  const std::vector<Tessellator::TriangleBuffer>& buffers =
+      tessellator.Run(*component, 0);
+  EXPECT_EQ(2, tessellator.statistics().fast_path_facets);
+  EXPECT_EQ(0, tessellator.statistics().glu_facets);
+  ASSERT_EQ(1u, buffers.size());
+  ASSERT_EQ(3u * 4u, buffers[0].triangle_indices.size());
+  static const unsigned int kFan[9] = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+  EXPECT_TRUE(std::equal(kFan, kFan + 9,
+                         buffers[0].triangle_indices.begin()));
+
+  // The per-vertex callbacks get the fan as independent triangles.
+  VertexTessellator unbatched;
+  EXPECT_EQ(4, unbatched.Run(*component));
+  EXPECT_EQ(2, unbatched.statistics().fast_path_facets);
+  delete component;
+}
+
+TEST_F(TessellatorTest, SharedVerticesSplitByNormal) {
+  // Each cube corner is shared by three facets with three different
+  // normals, so it still makes three vertices; but each of the 12 edges is
+  // now listed once.
+  BatchTessellator shared(0, true);
+  const Tessellator::TriangleBuffer& cube = shared.Run(*cube_, 0)[0];
+  EXPECT_EQ(8u * 3u, cube.vertex_count());
+  EXPECT_EQ(12u * 3u, cube.triangle_indices.size());
+  EXPECT_EQ(12u * 2u, cube.edge_indices.size());
+  for (size_t i = 0; i < cube.vertex_count(); ++i) {
+    int same_position_count = 0;
+    for (size_t j = 0; j < cube.vertex_count(); ++j) {
+      if (std::equal(&cube.positions[3 * i], &cube.positions[3 * i] + 3,
+                     &cube.positions[3 * j])) {
+        ++same_position_count;
+        if (i != j) {
+          EXPECT_FALSE(std::equal(&cube.normals[3 * i],
+                                  &cube.normals[3 * i] + 3,
+                                  &cube.normals[3 * j]));
+        }
+      }
+    }
+    EXPECT_EQ(3, same_position_count);
+  }
+
+  // The two triangles of a flat square share all their vertices, and their
+  // diagonal is listed once.
+  std::istringstream input(
+      "OFF\n"
+      "4 2 0\n"
+      "0 0 0\n  1 0 0\n  1 1 0\n  0 1 0\n"
+      "3 0 1 2\n"
+      "3 0 2 3\n");
+  Component* component = Component::MakeEmpty();
+  component->ReadOffStream(input);
+  const Tessellator::TriangleBuffer& square = shared.Run(*component, 0)[0];
+  EXPECT_EQ(4u, square.vertex_count());
+  EXPECT_EQ(2u * 3u, square.triangle_indices.size());
+  EXPECT_EQ(5u * 2u, square.edge_indices.size());
+
+  BatchTessellator unshared(0, false);
+  const Tessellator::TriangleBuffer& copied = unshared.Run(*component, 0)[0];
+  EXPECT_EQ(6u, copied.vertex_count());
+  EXPECT_EQ(6u * 2u, copied.edge_indices.size());
+  delete component;
+}
+
+TEST_F(TessellatorTest, BatchesMergeIntoOneIndexList) {
+  // As the view does for its single DrawElementsUInt per geometry, append
+  // small batches one after the other, offsetting the indices of each by
+  // the vertices before it.
+  const size_t kMaxBatchVertices = 16;
+  BatchTessellator batched(kMaxBatchVertices, true);
+  const std::vector<Tessellator::TriangleBuffer>& buffers =
+      batched.Run(*cube_, 2);
+  ASSERT_LT(1u, buffers.size());
+  Tessellator::TriangleBuffer merged;
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    const Tessellator::TriangleBuffer& buffer = buffers[i];
+    // Only the last batch may be left short, and facets are not split.
+    if (i + 1 < buffers.size())
+      EXPECT_LE(kMaxBatchVertices, buffer.vertex_count());
+    EXPECT_GT(kMaxBatchVertices + 4, buffer.vertex_count());
+    unsigned int base_index = merged.vertex_count();
+    for (size_t j = 0; j < buffer.triangle_indices.size(); ++j) {
+      ASSERT_LT(buffer.triangle_indices[j], buffer.vertex_count());
+      merged.triangle_indices.push_back(base_index +
+                                        buffer.triangle_indices[j]);
+    }
+    for (size_t j = 0; j < buffer.edge_indices.size(); ++j) {
+      ASSERT_LT(buffer.edge_indices[j], buffer.vertex_count());
+      merged.edge_indices.push_back(base_index + buffer.edge_indices[j]);
+    }
+    merged.positions.insert(merged.positions.end(), buffer.positions.begin(),
+                            buffer.positions.end());
+  }
+
+  // The merged triangles and edges are those of a single batch, vertices on
+  // the seams between batches being duplicated.
+  BatchTessellator single(0, true);
+  const Tessellator::TriangleBuffer& expected = single.Run(*cube_, 2)[0];
+  EXPECT_LE(expected.vertex_count(), merged.vertex_count());
+  ASSERT_EQ(expected.triangle_indices.size(), merged.triangle_indices.size());
+  ASSERT_EQ(expected.edge_indices.size(), merged.edge_indices.size());
+  for (size_t i = 0; i < merged.triangle_indices.size(); ++i) {
+    const float* position =
+        &merged.positions[3 * merged.triangle_indices[i]];
+    ASSERT_TRUE(std::equal(position, position + 3,
+        &expected.positions[3 * expected.triangle_indices[i]]));
+  }
+  for (size_t i = 0; i < merged.edge_indices.size(); ++i) {
+    const float* position = &merged.positions[3 * merged.edge_indices[i]];
+    ASSERT_TRUE(std::equal(position, position + 3,
+        &expected.positions[3 * expected.edge_indices[i]]));
+  }
+}
+
+TEST_F(TessellatorTest, ConcurrentGluTessellators) {
+  // Many small ranges, so that glu tessellators run side by side on all the
+  // threads.
+  const int kPolygonCount = 4000;
+  std::vector<GluPolygon> expected(kPolygonCount);
+  for (int i = 0; i < kPolygonCount; ++i)
+    MakeStarPolygon(i, &expected[i]);
+  std::vector<GluPolygon> polygons(expected);
+
+  ginsu::model::SetParallelThreadCount(1);
+  GluTessellateTask serial_task(&expected);
+  ginsu::model::ParallelFor(expected.size(), expected.size(), &serial_task);
+
+  ginsu::model::SetParallelThreadCount(8);
+  GluTessellateTask parallel_task(&polygons);
+  ginsu::model::ParallelFor(polygons.size(), 16, &parallel_task);
+
+  for (int i = 0; i < kPolygonCount; ++i) {
+    // A polygon with n vertices and h holes makes n - 2 + 2h triangles.
+    int vertex_count = static_cast<int>(expected[i].vertices.size()) / 3;
+    int hole_count = static_cast<int>(expected[i].contour_sizes.size()) - 1;
+    ASSERT_EQ(3 * (vertex_count - 2 + 2 * hole_count),
+              static_cast<int>(expected[i].triangle_indices.size()));
+    ASSERT_EQ(expected[i].triangle_indices, polygons[i].triangle_indices);
+    // Everything goes through the hooks, and is released with the
+    // tessellator. Polygons that glu fans only need the vertex cache, which
+    // is kept from one polygon to the next.
+    if (!polygons[i].rendered_as_fan)
+      ASSERT_LT(0, polygons[i].allocation_count);
+    ASSERT_TRUE(polygons[i].all_freed);
+  }
+}
+
+TEST_F(TessellatorTest, GluMeshStorageIsReused) {
+  std::vector<GluPolygon> polygons(3);
+  MakeStarPolygon(11, &polygons[0]);
+  MakeStarPolygon(11, &polygons[1]);
+  MakeStarPolygon(1, &polygons[2]);
+  GluTessellateTask task(&polygons);
+  task.Run(0, polygons.size());
+
+  // The vertices, faces and edges of the second polygon fit in the storage
+  // kept from the first one, and so do those of the smaller third one.
+  EXPECT_LT(polygons[1].allocation_count, polygons[0].allocation_count);
+  EXPECT_LT(0, polygons[0].kept_block_count);
+  EXPECT_EQ(polygons[0].kept_block_count, polygons[1].kept_block_count);
+  EXPECT_EQ(polygons[0].kept_block_count, polygons[2].kept_block_count);
+  EXPECT_EQ(polygons[0].triangle_indices, polygons[1].triangle_indices);
+  EXPECT_TRUE(polygons[2].all_freed);
+}
+
+TEST_F(TessellatorTest, GluFansLargeContours) {
+  std::vector<GluPolygon> polygons(3);
+  MakeNotchedDiskPolygon(8, &polygons[0]);
+  MakeNotchedDiskPolygon(1000, &polygons[1]);
+  MakeStarPolygon(4, &polygons[2]);
+  GluTessellateTask task(&polygons);
+  task.Run(0, polygons.size());
+
+  // However long, the notched disks are fanned; the star needs the sweep.
+  EXPECT_TRUE(polygons[0].rendered_as_fan);
+  EXPECT_TRUE(polygons[1].rendered_as_fan);
+  EXPECT_FALSE(polygons[2].rendered_as_fan);
+  for (size_t i = 0; i < polygons.size(); ++i) {
+    // The edge flags still mark the n boundary edges of the n - 2
+    // triangles.
+    int vertex_count = static_cast<int>(polygons[i].vertices.size()) / 3;
+    EXPECT_EQ(3 * (vertex_count - 2),
+              static_cast<int>(polygons[i].triangle_indices.size()));
+    int boundary_edge_count = 0;
+    for (size_t j = 0; j < polygons[i].boundary_edges.size(); ++j) {
+      if (polygons[i].boundary_edges[j])
+        ++boundary_edge_count;
+    }
+    EXPECT_EQ(vertex_count, boundary_edge_count);
+    EXPECT_TRUE(polygons[i].all_freed);
+  }
+}
+
+TEST_F(TessellatorTest, GluTriangleList) {
+  const int kPolygonCount = 200;
+  std::vector<GluPolygon> expected(kPolygonCount + 1);
+  for (int i = 0; i < kPolygonCount; ++i)
+    MakeStarPolygon(i, &expected[i]);
+  MakeNotchedDiskPolygon(300, &expected[kPolygonCount]);
+  std::vector<GluPolygon> polygons(expected);
+  GluTessellateTask task(&expected);
+  task.Run(0, expected.size());
+  GluTessellateTask list_task(&polygons, true);
+  list_task.Run(0, polygons.size());
+
+  // The same triangles and boundary edges as through the per-vertex
+  // callbacks, from the sweep as well as from the fan.
+  for (size_t i = 0; i < polygons.size(); ++i) {
+    ASSERT_FALSE(polygons[i].triangle_indices.empty());
+    ASSERT_EQ(expected[i].rendered_as_fan, polygons[i].rendered_as_fan);
+    ASSERT_EQ(SortedTriangles(expected[i]), SortedTriangles(polygons[i]));
+    ASSERT_TRUE(polygons[i].all_freed);
+  }
+  EXPECT_TRUE(polygons[kPolygonCount].rendered_as_fan);
+}
+
+TEST_F(TessellatorTest, ConcaveFacetStatistics) {
+  // A concave facet that glu fans, next to a convex one.
+  std::istringstream input(
+      "OFF\n"
+      "6 2 0\n"
+      "0 0 0\n  2 0 0\n  1.5 1 0\n  2 2 0\n  0 2 0\n  0 0 1\n"
+      "5 0 1 2 3 4\n"
+      "3 1 0 5\n");
+  Component* component = Component::MakeEmpty();
+  component->ReadOffStream(input);
+  BufferTessellator tessellator;
+  const Tessellator::TriangleBuffer& buffer = tessellator.Run(*component, 0);
+  EXPECT_EQ(3u * 4u, buffer.triangle_indices.size());
+  EXPECT_EQ(1, tessellator.statistics().fast_path_facets);
+  EXPECT_EQ(1, tessellator.statistics().glu_facets);
+  EXPECT_EQ(1, tessellator.statistics().glu_fan_facets);
+  tessellator.ResetStatistics();
+  EXPECT_EQ(0, tessellator.statistics().glu_fan_facets);
+  delete component;
+}
+
+TEST_F(TessellatorTest, ReflexFirstCorner) {
+  // The same concave pentagon, listed from its reflex corner at (1.5, 1).
+  // The plane through the first three vertices faces down, but the facet
+  // faces up.
+  std::istringstream input(
+      "OFF\n"
+      "6 2 0\n"
+      "0 0 0\n  2 0 0\n  1.5 1 0\n  2 2 0\n  0 2 0\n  0 0 1\n"
+      "5 1 2 3 4 0\n"
+      "3 1 0 5\n");
+  Component* component = Component::MakeEmpty();
+  component->ReadOffStream(input);
+
+  BufferTessellator batched;
+  const Tessellator::TriangleBuffer& buffer = batched.Run(*component, 0);
+  EXPECT_EQ(3u * 4u, buffer.triangle_indices.size());
+  EXPECT_EQ(1, batched.statistics().glu_facets);
+  // The pentagon's vertices are shaded as facing up.
+  int up_count = 0;
+  for (size_t i = 0; i < buffer.vertex_count(); ++i) {
+    if (buffer.normals[3 * i + 2] > 0.99f)
+      ++up_count;
+  }
+  EXPECT_EQ(5, up_count);
+
+  VertexTessellator unbatched;
+  EXPECT_EQ(4, unbatched.Run(*component));
+  ASSERT_EQ(6u, unbatched.normals().size());
+  EXPECT_LT(0.0f, unbatched.normals()[2]);
+  delete component;
+}
+
+}  // namespace
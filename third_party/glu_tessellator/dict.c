@@ -44,11 +44,12 @@
 #include "memalloc.h"
 
 /* really __gl_dictListNewDict */
-Dict *dictNewDict( void *frame,
+Dict *dictNewDict( GLUmemory *memory, void *frame,
 		   int (*leq)(void *frame, DictKey key1, DictKey key2) )
 {
-  Dict *dict = (Dict *) memAlloc( sizeof( Dict ));
+  Dict *dict = (Dict *) memAlloc( memory, sizeof( Dict ));
   DictNode *head;
+  int level;
 
   if (dict == NULL) return NULL;
 
@@ -57,7 +58,16 @@ Dict *dictNewDict( void *frame,
   head->key = NULL;
   head->next = head;
   head->prev = head;
+  head->height = DICT_MAX_HEIGHT;
+  head->up = dict->headUp;
+  for( level = 1; level < DICT_MAX_HEIGHT; ++level ) {
+    head->up[level-1].next = head;
+    head->up[level-1].prev = head;
+  }
 
+  dict->height = 1;
+  dict->seed = 1;
+  dict->memory = memory;
   dict->frame = frame;
   dict->leq = leq;
 
@@ -67,47 +77,108 @@ Dict *dictNewDict( void *frame,
 /* really __gl_dictListDeleteDict */
 void dictDeleteDict( Dict *dict )
 {
-  DictNode *node;
+  DictNode *node, *next;
 
-  for( node = dict->head.next; node != &dict->head; node = node->next ) {
-    memFree( node );
+  for( node = dict->head.next; node != &dict->head; node = next ) {
+    next = node->next;
+    memFree( dict->memory, node );
+  }
+  memFree( dict->memory, dict );
+}
+
+/* RandomHeight picks the number of levels of a new node: each level
+ * above the first with probability 1/4.  The generator is a linear
+ * congruential one, seeded the same for each dictionary, so that
+ * tessellations are reproducible (the heights do not affect the results
+ * anyway).
+ */
+static int RandomHeight( Dict *dict )
+{
+  unsigned long bits;
+  int height = 1;
+
+  dict->seed = (dict->seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+  bits = dict->seed >> 8;
+  while( height < DICT_MAX_HEIGHT && (bits & 3) == 0 ) {
+    ++height;
+    bits >>= 2;
   }
-  memFree( dict );
+  return height;
 }
 
 /* really __gl_dictListInsertBefore */
 DictNode *dictInsertBefore( Dict *dict, DictNode *node, DictKey key )
 {
-  DictNode *newNode;
+  DictNode *newNode, *pred;
+  int height, level;
 
   do {
     node = node->prev;
   } while( node->key != NULL && ! (*dict->leq)(dict->frame, node->key, key));
 
-  newNode = (DictNode *) memAlloc( sizeof( DictNode ));
+  height = RandomHeight( dict );
+  newNode = (DictNode *) memAlloc( dict->memory, sizeof( DictNode )
+				   + (height - 1) * sizeof( DictLink ));
   if (newNode == NULL) return NULL;
 
   newNode->key = key;
+  newNode->height = height;
+  newNode->up = (DictLink *)(newNode + 1);
   newNode->next = node->next;
   node->next->prev = newNode;
   newNode->prev = node;
   node->next = newNode;
 
+  /* On each level, the new node goes after the closest node before it
+   * which is tall enough; look for it among the nodes of the level below.
+   */
+  pred = node;
+  for( level = 1; level < height; ++level ) {
+    while( pred->height <= level ) {
+      pred = (level == 1) ? pred->prev : pred->up[level-2].prev;
+    }
+    newNode->up[level-1].next = pred->up[level-1].next;
+    pred->up[level-1].next->up[level-1].prev = newNode;
+    newNode->up[level-1].prev = pred;
+    pred->up[level-1].next = newNode;
+  }
+  if (height > dict->height) dict->height = height;
+
   return newNode;
 }
 
 /* really __gl_dictListDelete */
-void dictDelete( Dict *dict, DictNode *node ) /*ARGSUSED*/
+void dictDelete( Dict *dict, DictNode *node )
 {
+  int level;
+
+  for( level = 1; level < node->height; ++level ) {
+    DictLink *link = &node->up[level-1];
+    link->next->up[level-1].prev = link->prev;
+    link->prev->up[level-1].next = link->next;
+  }
   node->next->prev = node->prev;
   node->prev->next = node->next;
-  memFree( node );
+  memFree( dict->memory, node );
 }
 
 /* really __gl_dictListSearch */
 DictNode *dictSearch( Dict *dict, DictKey key )
 {
   DictNode *node = &dict->head;
+  DictNode *next;
+  int level;
+
+  /* On each level, move forward while the next key is less than key. */
+  for( level = dict->height - 1; level > 0; --level ) {
+    for( ;; ) {
+      next = node->up[level-1].next;
+      if (next->key == NULL || (*dict->leq)(dict->frame, key, next->key)) {
+	break;
+      }
+      node = next;
+    }
+  }
 
   do {
     node = node->next;
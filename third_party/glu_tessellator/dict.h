@@ -42,13 +42,15 @@
 #ifndef __dict_list_h_
 #define __dict_list_h_
 
+#include "memalloc.h"
+
 /* Use #define's so that another heap implementation can use this one */
 
 #define DictKey		DictListKey
 #define Dict		DictList
 #define DictNode	DictListNode
 
-#define dictNewDict(frame,leq)		__gl_dictListNewDict(frame,leq)
+#define dictNewDict(memory,frame,leq)	__gl_dictListNewDict(memory,frame,leq)
 #define dictDeleteDict(dict)		__gl_dictListDeleteDict(dict)
 
 #define dictSearch(dict,key)		__gl_dictListSearch(dict,key)
@@ -69,6 +71,7 @@ typedef struct Dict Dict;
 typedef struct DictNode DictNode;
 
 Dict		*dictNewDict(
+			GLUmemory *memory,
 			void *frame,
 			int (*leq)(void *frame, DictKey key1, DictKey key2) );
 			
@@ -77,6 +80,11 @@ void		dictDeleteDict( Dict *dict );
 /* Search returns the node with the smallest key greater than or equal
  * to the given key.  If there is no such key, returns a node whose
  * key is NULL.  Similarly, Succ(Max(d)) has a NULL key, etc.
+ *
+ * InsertBefore inserts the key just after the last node before the given
+ * one whose key is less than or equal to it, so it is fast when the new
+ * key belongs right before the given node, as in the sweep.  Search takes
+ * expected logarithmic time, and Delete takes expected constant time.
  */
 DictNode	*dictSearch( Dict *dict, DictKey key );
 DictNode	*dictInsertBefore( Dict *dict, DictNode *node, DictKey key );
@@ -92,14 +100,36 @@ void		dictDelete( Dict *dict, DictNode *node );
 
 /*** Private data structures ***/
 
+/* The dictionary is a skip list (see W. Pugh, Skip Lists: A Probabilistic
+ * Alternative to Balanced Trees, Communications of the ACM, 33(6):668-676,
+ * June 1990).  Every node is on the sorted, circular doubly-linked list of
+ * level 0, and a random quarter of the nodes on each level is also on the
+ * level above, so that Search can skip most of the nodes.  Upper levels are
+ * doubly linked too, so that a node can be linked or unlinked at every
+ * level without searching for its neighbors from the head.
+ */
+#define DICT_MAX_HEIGHT	12
+
+typedef struct DictLink DictLink;
+struct DictLink {
+  DictNode	*next;
+  DictNode	*prev;
+};
+
 struct DictNode {
   DictKey	key;
-  DictNode	*next;
+  DictNode	*next;		/* level 0 */
   DictNode	*prev;
+  int		height;		/* number of levels the node is on */
+  DictLink	*up;		/* links of levels 1 to height-1 */
 };
 
 struct Dict {
-  DictNode	head;
+  DictNode	head;		/* key is NULL, on all the levels */
+  DictLink	headUp[DICT_MAX_HEIGHT - 1];
+  int		height;		/* highest level in use, plus 1 */
+  unsigned long	seed;		/* for node heights */
+  GLUmemory	*memory;
   void		*frame;
   int		(*leq)(void *frame, DictKey key1, DictKey key2);
 };
@@ -4,6 +4,8 @@
 #ifndef GINSU_TESSELLATOR_GLU_TESSELLATOR_H_
 #define GINSU_TESSELLATOR_GLU_TESSELLATOR_H_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,6 +43,25 @@ extern "C" {
 #define GLU_TESS_COORD_TOO_LARGE             100155
 #define GLU_TESS_NEED_COMBINE_CALLBACK       100156
 
+// Ginsu extension, for gluGetTessProperty: the number of polygons that the
+// tessellator tried to render directly as a fan, which it does for single
+// contours, and the number of those it did render that way rather than with
+// the full sweep.
+#define GLU_TESS_FAN_TRIED                   100190
+#define GLU_TESS_FAN_RENDERED                100191
+
+// Ginsu extension, for gluTessCallback: receive the tessellation of each
+// polygon in a single call, as independent triangles, instead of through the
+// begin, vertex, edge flag and end callbacks. The callback is
+//   void Triangles(int count, void** vertex_data, GLboolean* boundary_edge,
+//                  void* polygon_data);
+// where vertex_data holds the vertex data of the 3 * count triangle corners,
+// and boundary_edge[i] tells whether the edge from corner i to the next
+// corner of its triangle is on the polygon boundary. Both arrays belong to
+// the tessellator and are only valid during the call. The callback is not
+// used with GLU_TESS_BOUNDARY_ONLY.
+#define GLU_TESS_TRIANGLES_DATA              100192
+
 #define GLU_INVALID_ENUM                     100900
 #define GLU_INVALID_VALUE                    100901
 #define GLU_OUT_OF_MEMORY                    100902
@@ -73,9 +94,25 @@ extern void gluTessEndPolygon(GLUtesselator* tess);
 extern void gluTessNormal (GLUtesselator* tess,
                            GLdouble valueX, GLdouble valueY, GLdouble valueZ);
 extern void gluTessProperty(GLUtesselator* tess, GLenum which, GLdouble data);
+extern void gluGetTessProperty(GLUtesselator* tess, GLenum which,
+                               GLdouble* value);
 extern void gluTessVertex(GLUtesselator* tess, GLdouble *location,
                           void* data);
 
+// Allocation hooks for gluTessAllocator. user_data is the pointer given to
+// gluTessAllocator.
+typedef void* (*GLUallocFunc)(void* user_data, size_t size);
+typedef void* (*GLUreallocFunc)(void* user_data, void* ptr, size_t size);
+typedef void (*GLUfreeFunc)(void* user_data, void* ptr);
+
+// Ginsu extension: route all the memory allocations of tess, except that of
+// tess itself, through the given hooks instead of malloc, realloc and free.
+// The hooks are only ever called from the thread using tess. Must not be
+// called between gluTessBeginPolygon and gluTessEndPolygon.
+extern void gluTessAllocator(GLUtesselator* tess, GLUallocFunc alloc_func,
+                             GLUreallocFunc realloc_func,
+                             GLUfreeFunc free_func, void* user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,21 +41,131 @@
 
 #include "memalloc.h"
 
-int __gl_memInit( size_t maxFast )
-{
-#ifndef NO_MALLOPT
-/*  mallopt( M_MXFAST, maxFast );*/
 #ifdef MEMORY_DEBUG
-  mallopt( M_DEBUG, 1 );
+#include <string.h>
 #endif
+
+static void *DefaultAlloc( void *data, size_t n )
+{
+#ifdef MEMORY_DEBUG
+  void *p = malloc( n );
+  return (p == NULL) ? NULL : memset( p, 0xa5, n );
+#else
+  return malloc( n );
 #endif
-   return 1;
 }
 
-#ifdef MEMORY_DEBUG
-void *__gl_memAlloc( size_t n )
+static void *DefaultRealloc( void *data, void *p, size_t n )
 {
-  return memset( malloc( n ), 0xa5, n );
+  return realloc( p, n );
+}
+
+static void DefaultFree( void *data, void *p )
+{
+  free( p );
 }
-#endif
 
+void __gl_memInit( GLUmemory *memory )
+{
+  memory->alloc = &DefaultAlloc;
+  memory->realloc = &DefaultRealloc;
+  memory->free = &DefaultFree;
+  memory->data = NULL;
+}
+
+/* Blocks and chunk headers are aligned for the strictest of pointers and
+ * doubles, which is all the mesh structures contain.
+ */
+#define POOL_ALIGN	(sizeof(double) > sizeof(void *) ? \
+			 sizeof(double) : sizeof(void *))
+#define POOL_ROUND(n)	(((n) + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN)
+
+/* Chunks start small, since most polygons are small, and double in size
+ * up to a limit.
+ */
+#define POOL_FIRST_CHUNK_BLOCKS	32
+#define POOL_MAX_CHUNK_BLOCKS	4096
+
+struct GLUpoolChunk {
+  GLUpoolChunk	*next;
+  size_t	blockCount;
+};
+
+#define CHUNK_HEADER_SIZE	POOL_ROUND(sizeof(GLUpoolChunk))
+
+void __gl_poolInit( GLUpool *pool, size_t blockSize )
+{
+  if (blockSize < sizeof(void *)) blockSize = sizeof(void *);
+  pool->blockSize = POOL_ROUND(blockSize);
+  pool->freeList = NULL;
+  pool->chunks = NULL;
+  pool->current = NULL;
+  pool->next = pool->end = NULL;
+}
+
+/* Move on to the chunk after the current one, allocating it if there is
+ * none left from before the last reset.
+ */
+static int NextChunk( GLUmemory *memory, GLUpool *pool )
+{
+  GLUpoolChunk *chunk;
+
+  chunk = (pool->current == NULL) ? pool->chunks : pool->current->next;
+  if (chunk == NULL) {
+    size_t blockCount = POOL_FIRST_CHUNK_BLOCKS;
+    if (pool->current != NULL) {
+      blockCount = 2 * pool->current->blockCount;
+      if (blockCount > POOL_MAX_CHUNK_BLOCKS) {
+	blockCount = POOL_MAX_CHUNK_BLOCKS;
+      }
+    }
+    chunk = (GLUpoolChunk *)memAlloc( memory, CHUNK_HEADER_SIZE
+				      + blockCount * pool->blockSize );
+    if (chunk == NULL) return 0;
+    chunk->next = NULL;
+    chunk->blockCount = blockCount;
+    if (pool->current == NULL) {
+      pool->chunks = chunk;
+    } else {
+      pool->current->next = chunk;
+    }
+  }
+  pool->current = chunk;
+  pool->next = (char *)chunk + CHUNK_HEADER_SIZE;
+  pool->end = pool->next + chunk->blockCount * pool->blockSize;
+  return 1;
+}
+
+void *__gl_poolAlloc( GLUmemory *memory, GLUpool *pool )
+{
+  void *block = pool->freeList;
+
+  if (block != NULL) {
+    pool->freeList = *(void **)block;
+    return block;
+  }
+  if (pool->next == pool->end && !NextChunk( memory, pool )) {
+    return NULL;
+  }
+  block = pool->next;
+  pool->next += pool->blockSize;
+  return block;
+}
+
+void __gl_poolReset( GLUpool *pool )
+{
+  pool->freeList = NULL;
+  pool->current = NULL;
+  pool->next = pool->end = NULL;
+}
+
+void __gl_poolDelete( GLUmemory *memory, GLUpool *pool )
+{
+  GLUpoolChunk *chunk, *next;
+
+  for( chunk = pool->chunks; chunk != NULL; chunk = next ) {
+    next = chunk->next;
+    memFree( memory, chunk );
+  }
+  __gl_poolInit( pool, pool->blockSize );
+}
@@ -44,18 +44,50 @@
 
 #include <stdlib.h>
 
-#define memRealloc	realloc
-#define memFree		free
-
-#define memInit		__gl_memInit
-/*extern void		__gl_memInit( size_t );*/
-extern int		__gl_memInit( size_t );
-
-#ifndef MEMORY_DEBUG
-#define memAlloc	malloc
-#else
-#define memAlloc	__gl_memAlloc
-extern void *		__gl_memAlloc( size_t );
-#endif
+/* Allocation hooks of a tessellator.  Everything allocated on behalf of a
+ * tessellator (mesh, edge dictionary, priority queue, sweep regions) goes
+ * through the hooks of that tessellator, which the structures keep a
+ * pointer to.  Tessellators thus share no state, and may be used from
+ * different threads at the same time.
+ */
+typedef struct GLUmemory GLUmemory;
+struct GLUmemory {
+  void *(*alloc)( void *data, size_t size );
+  void *(*realloc)( void *data, void *ptr, size_t size );
+  void (*free)( void *data, void *ptr );
+  void *data;
+};
+
+/* Set hooks that call malloc, realloc and free. */
+extern void		__gl_memInit( GLUmemory *memory );
+
+#define memAlloc( m, n )	((m)->alloc( (m)->data, (n) ))
+#define memRealloc( m, p, n )	((m)->realloc( (m)->data, (p), (n) ))
+#define memFree( m, p )		((m)->free( (m)->data, (p) ))
+
+/* A pool of fixed-size blocks, carved out of chunks obtained from the
+ * hooks.  Freed blocks go on a free list for reuse.  __gl_poolReset makes
+ * every block available again at once but keeps the chunks, so that a
+ * tessellator reuses the same memory from one polygon to the next;
+ * __gl_poolDelete gives the chunks back to the hooks.
+ */
+typedef struct GLUpoolChunk GLUpoolChunk;
+typedef struct GLUpool GLUpool;
+struct GLUpool {
+  size_t	blockSize;	/* rounded up to keep blocks aligned */
+  void		*freeList;	/* freed blocks, linked through their first word */
+  GLUpoolChunk	*chunks;	/* all the chunks, in allocation order */
+  GLUpoolChunk	*current;	/* chunk being carved, or NULL before the first */
+  char		*next;		/* first unused byte of current */
+  char		*end;		/* end of current */
+};
+
+extern void		__gl_poolInit( GLUpool *pool, size_t blockSize );
+extern void		*__gl_poolAlloc( GLUmemory *memory, GLUpool *pool );
+extern void		__gl_poolReset( GLUpool *pool );
+extern void		__gl_poolDelete( GLUmemory *memory, GLUpool *pool );
+
+#define poolFree( pool, p )	(*(void **)(p) = (pool)->freeList, \
+				 (pool)->freeList = (p))
 
 #endif
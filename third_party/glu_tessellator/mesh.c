@@ -49,14 +49,14 @@
 #define FALSE 0
 #endif
 
-static GLUvertex *allocVertex()
+static GLUvertex *allocVertex( GLUmesh *mesh )
 {
-   return (GLUvertex *)memAlloc( sizeof( GLUvertex ));
+   return (GLUvertex *)__gl_poolAlloc( mesh->memory, &mesh->pools->vertices );
 }
 
-static GLUface *allocFace()
+static GLUface *allocFace( GLUmesh *mesh )
 {
-   return (GLUface *)memAlloc( sizeof( GLUface ));
+   return (GLUface *)__gl_poolAlloc( mesh->memory, &mesh->pools->faces );
 }
 
 /************************ Utility Routines ************************/
@@ -70,12 +70,13 @@ typedef struct { GLUhalfEdge e, eSym; } EdgePair;
  * No vertex or face structures are allocated, but these must be assigned
  * before the current edge operation is completed.
  */
-static GLUhalfEdge *MakeEdge( GLUhalfEdge *eNext )
+static GLUhalfEdge *MakeEdge( GLUmesh *mesh, GLUhalfEdge *eNext )
 {
   GLUhalfEdge *e;
   GLUhalfEdge *eSym;
   GLUhalfEdge *ePrev;
-  EdgePair *pair = (EdgePair *)memAlloc( sizeof( EdgePair ));
+  EdgePair *pair = (EdgePair *)__gl_poolAlloc( mesh->memory,
+					       &mesh->pools->edges );
   if (pair == NULL) return NULL;
 
   e = &pair->e;
@@ -205,7 +206,7 @@ static void MakeFace( GLUface *newFace, GLUhalfEdge *eOrig, GLUface *fNext )
 /* KillEdge( eDel ) destroys an edge (the half-edges eDel and eDel->Sym),
  * and removes from the global edge list.
  */
-static void KillEdge( GLUhalfEdge *eDel )
+static void KillEdge( GLUmesh *mesh, GLUhalfEdge *eDel )
 {
   GLUhalfEdge *ePrev, *eNext;
 
@@ -218,14 +219,14 @@ static void KillEdge( GLUhalfEdge *eDel )
   eNext->Sym->next = ePrev;
   ePrev->Sym->next = eNext;
 
-  memFree( eDel );
+  poolFree( &mesh->pools->edges, eDel );
 }
 
 
 /* KillVertex( vDel ) destroys a vertex and removes it from the global
  * vertex list.  It updates the vertex loop to point to a given new vertex.
  */
-static void KillVertex( GLUvertex *vDel, GLUvertex *newOrg )
+static void KillVertex( GLUmesh *mesh, GLUvertex *vDel, GLUvertex *newOrg )
 {
   GLUhalfEdge *e, *eStart = vDel->anEdge;
   GLUvertex *vPrev, *vNext;
@@ -243,13 +244,13 @@ static void KillVertex( GLUvertex *vDel, GLUvertex *newOrg )
   vNext->prev = vPrev;
   vPrev->next = vNext;
 
-  memFree( vDel );
+  poolFree( &mesh->pools->vertices, vDel );
 }
 
 /* KillFace( fDel ) destroys a face and removes it from the global face
  * list.  It updates the face loop to point to a given new face.
  */
-static void KillFace( GLUface *fDel, GLUface *newLface )
+static void KillFace( GLUmesh *mesh, GLUface *fDel, GLUface *newLface )
 {
   GLUhalfEdge *e, *eStart = fDel->anEdge;
   GLUface *fPrev, *fNext;
@@ -267,7 +268,7 @@ static void KillFace( GLUface *fDel, GLUface *newLface )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fDel );
+  poolFree( &mesh->pools->faces, fDel );
 }
 
 
@@ -278,20 +279,20 @@ static void KillFace( GLUface *fDel, GLUface *newLface )
  */
 GLUhalfEdge *__gl_meshMakeEdge( GLUmesh *mesh )
 {
-  GLUvertex *newVertex1= allocVertex();
-  GLUvertex *newVertex2= allocVertex();
-  GLUface *newFace= allocFace();
+  GLUvertex *newVertex1= allocVertex( mesh );
+  GLUvertex *newVertex2= allocVertex( mesh );
+  GLUface *newFace= allocFace( mesh );
   GLUhalfEdge *e;
 
   /* if any one is null then all get freed */
   if (newVertex1 == NULL || newVertex2 == NULL || newFace == NULL) {
-     if (newVertex1 != NULL) memFree(newVertex1);
-     if (newVertex2 != NULL) memFree(newVertex2);
-     if (newFace != NULL) memFree(newFace);     
+     if (newVertex1 != NULL) poolFree(&mesh->pools->vertices, newVertex1);
+     if (newVertex2 != NULL) poolFree(&mesh->pools->vertices, newVertex2);
+     if (newFace != NULL) poolFree(&mesh->pools->faces, newFace);
      return NULL;
   } 
 
-  e = MakeEdge( &mesh->eHead );
+  e = MakeEdge( mesh, &mesh->eHead );
   if (e == NULL) return NULL;
 
   MakeVertex( newVertex1, e, &mesh->vHead );
@@ -324,7 +325,7 @@ GLUhalfEdge *__gl_meshMakeEdge( GLUmesh *mesh )
  * If eDst == eOrg->Onext, the new vertex will have a single edge.
  * If eDst == eOrg->Oprev, the old vertex will have a single edge.
  */
-int __gl_meshSplice( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
+int __gl_meshSplice( GLUmesh *mesh, GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
 {
   int joiningLoops = FALSE;
   int joiningVertices = FALSE;
@@ -334,19 +335,19 @@ int __gl_meshSplice( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
   if( eDst->Org != eOrg->Org ) {
     /* We are merging two disjoint vertices -- destroy eDst->Org */
     joiningVertices = TRUE;
-    KillVertex( eDst->Org, eOrg->Org );
+    KillVertex( mesh, eDst->Org, eOrg->Org );
   }
   if( eDst->Lface != eOrg->Lface ) {
     /* We are connecting two disjoint loops -- destroy eDst->Lface */
     joiningLoops = TRUE;
-    KillFace( eDst->Lface, eOrg->Lface );
+    KillFace( mesh, eDst->Lface, eOrg->Lface );
   }
 
   /* Change the edge structure */
   Splice( eDst, eOrg );
 
   if( ! joiningVertices ) {
-    GLUvertex *newVertex= allocVertex();
+    GLUvertex *newVertex= allocVertex( mesh );
     if (newVertex == NULL) return 0;
 
     /* We split one vertex into two -- the new vertex is eDst->Org.
@@ -356,7 +357,7 @@ int __gl_meshSplice( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
     eOrg->Org->anEdge = eOrg;
   }
   if( ! joiningLoops ) {
-    GLUface *newFace= allocFace();  
+    GLUface *newFace= allocFace( mesh );
     if (newFace == NULL) return 0;
 
     /* We split one loop into two -- the new loop is eDst->Lface.
@@ -380,7 +381,7 @@ int __gl_meshSplice( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
  * plus a few calls to memFree, but this would allocate and delete
  * unnecessary vertices and faces.
  */
-int __gl_meshDelete( GLUhalfEdge *eDel )
+int __gl_meshDelete( GLUmesh *mesh, GLUhalfEdge *eDel )
 {
   GLUhalfEdge *eDelSym = eDel->Sym;
   int joiningLoops = FALSE;
@@ -391,11 +392,11 @@ int __gl_meshDelete( GLUhalfEdge *eDel )
   if( eDel->Lface != eDel->Rface ) {
     /* We are joining two loops into one -- remove the left face */
     joiningLoops = TRUE;
-    KillFace( eDel->Lface, eDel->Rface );
+    KillFace( mesh, eDel->Lface, eDel->Rface );
   }
 
   if( eDel->Onext == eDel ) {
-    KillVertex( eDel->Org, NULL );
+    KillVertex( mesh, eDel->Org, NULL );
   } else {
     /* Make sure that eDel->Org and eDel->Rface point to valid half-edges */
     eDel->Rface->anEdge = eDel->Oprev;
@@ -403,7 +404,7 @@ int __gl_meshDelete( GLUhalfEdge *eDel )
 
     Splice( eDel, eDel->Oprev );
     if( ! joiningLoops ) {
-      GLUface *newFace= allocFace();
+      GLUface *newFace= allocFace( mesh );
       if (newFace == NULL) return 0; 
 
       /* We are splitting one loop into two -- create a new loop for eDel. */
@@ -415,8 +416,8 @@ int __gl_meshDelete( GLUhalfEdge *eDel )
    * may have been deleted.  Now we disconnect eDel->Dst.
    */
   if( eDelSym->Onext == eDelSym ) {
-    KillVertex( eDelSym->Org, NULL );
-    KillFace( eDelSym->Lface, NULL );
+    KillVertex( mesh, eDelSym->Org, NULL );
+    KillFace( mesh, eDelSym->Lface, NULL );
   } else {
     /* Make sure that eDel->Dst and eDel->Lface point to valid half-edges */
     eDel->Lface->anEdge = eDelSym->Oprev;
@@ -425,7 +426,7 @@ int __gl_meshDelete( GLUhalfEdge *eDel )
   }
 
   /* Any isolated vertices or faces have already been freed. */
-  KillEdge( eDel );
+  KillEdge( mesh, eDel );
 
   return 1;
 }
@@ -442,10 +443,10 @@ int __gl_meshDelete( GLUhalfEdge *eDel )
  * eNew == eOrg->Lnext, and eNew->Dst is a newly created vertex.
  * eOrg and eNew will have the same left face.
  */
-GLUhalfEdge *__gl_meshAddEdgeVertex( GLUhalfEdge *eOrg )
+GLUhalfEdge *__gl_meshAddEdgeVertex( GLUmesh *mesh, GLUhalfEdge *eOrg )
 {
   GLUhalfEdge *eNewSym;
-  GLUhalfEdge *eNew = MakeEdge( eOrg );
+  GLUhalfEdge *eNew = MakeEdge( mesh, eOrg );
   if (eNew == NULL) return NULL;
 
   eNewSym = eNew->Sym;
@@ -456,7 +457,7 @@ GLUhalfEdge *__gl_meshAddEdgeVertex( GLUhalfEdge *eOrg )
   /* Set the vertex and face information */
   eNew->Org = eOrg->Dst;
   {
-    GLUvertex *newVertex= allocVertex();
+    GLUvertex *newVertex= allocVertex( mesh );
     if (newVertex == NULL) return NULL;
 
     MakeVertex( newVertex, eNewSym, eNew->Org );
@@ -471,10 +472,10 @@ GLUhalfEdge *__gl_meshAddEdgeVertex( GLUhalfEdge *eOrg )
  * such that eNew == eOrg->Lnext.  The new vertex is eOrg->Dst == eNew->Org.
  * eOrg and eNew will have the same left face.
  */
-GLUhalfEdge *__gl_meshSplitEdge( GLUhalfEdge *eOrg )
+GLUhalfEdge *__gl_meshSplitEdge( GLUmesh *mesh, GLUhalfEdge *eOrg )
 {
   GLUhalfEdge *eNew;
-  GLUhalfEdge *tempHalfEdge= __gl_meshAddEdgeVertex( eOrg );
+  GLUhalfEdge *tempHalfEdge= __gl_meshAddEdgeVertex( mesh, eOrg );
   if (tempHalfEdge == NULL) return NULL;
 
   eNew = tempHalfEdge->Sym;
@@ -504,11 +505,12 @@ GLUhalfEdge *__gl_meshSplitEdge( GLUhalfEdge *eOrg )
  * If (eOrg->Lnext == eDst), the old face is reduced to a single edge.
  * If (eOrg->Lnext->Lnext == eDst), the old face is reduced to two edges.
  */
-GLUhalfEdge *__gl_meshConnect( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
+GLUhalfEdge *__gl_meshConnect( GLUmesh *mesh,
+			       GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
 {
   GLUhalfEdge *eNewSym;
   int joiningLoops = FALSE;  
-  GLUhalfEdge *eNew = MakeEdge( eOrg );
+  GLUhalfEdge *eNew = MakeEdge( mesh, eOrg );
   if (eNew == NULL) return NULL;
 
   eNewSym = eNew->Sym;
@@ -516,7 +518,7 @@ GLUhalfEdge *__gl_meshConnect( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
   if( eDst->Lface != eOrg->Lface ) {
     /* We are connecting two disjoint loops -- destroy eDst->Lface */
     joiningLoops = TRUE;
-    KillFace( eDst->Lface, eOrg->Lface );
+    KillFace( mesh, eDst->Lface, eOrg->Lface );
   }
 
   /* Connect the new edge appropriately */
@@ -532,7 +534,7 @@ GLUhalfEdge *__gl_meshConnect( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
   eOrg->Lface->anEdge = eNewSym;
 
   if( ! joiningLoops ) {
-    GLUface *newFace= allocFace();
+    GLUface *newFace= allocFace( mesh );
     if (newFace == NULL) return NULL;
 
     /* We split one loop into two -- the new loop is eNew->Lface */
@@ -551,7 +553,7 @@ GLUhalfEdge *__gl_meshConnect( GLUhalfEdge *eOrg, GLUhalfEdge *eDst )
  * An entire mesh can be deleted by zapping its faces, one at a time,
  * in any order.  Zapped faces cannot be used in further mesh operations!
  */
-void __gl_meshZapFace( GLUface *fZap )
+void __gl_meshZapFace( GLUmesh *mesh, GLUface *fZap )
 {
   GLUhalfEdge *eStart = fZap->anEdge;
   GLUhalfEdge *e, *eNext, *eSym;
@@ -568,7 +570,7 @@ void __gl_meshZapFace( GLUface *fZap )
       /* delete the edge -- see __gl_MeshDelete above */
 
       if( e->Onext == e ) {
-	KillVertex( e->Org, NULL );
+	KillVertex( mesh, e->Org, NULL );
       } else {
 	/* Make sure that e->Org points to a valid half-edge */
 	e->Org->anEdge = e->Onext;
@@ -576,13 +578,13 @@ void __gl_meshZapFace( GLUface *fZap )
       }
       eSym = e->Sym;
       if( eSym->Onext == eSym ) {
-	KillVertex( eSym->Org, NULL );
+	KillVertex( mesh, eSym->Org, NULL );
       } else {
 	/* Make sure that eSym->Org points to a valid half-edge */
 	eSym->Org->anEdge = eSym->Onext;
 	Splice( eSym, eSym->Oprev );
       }
-      KillEdge( e );
+      KillEdge( mesh, e );
     }
   } while( e != eStart );
 
@@ -592,23 +594,40 @@ void __gl_meshZapFace( GLUface *fZap )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fZap );
+  poolFree( &mesh->pools->faces, fZap );
+}
+
+
+void __gl_meshInitPools( GLUmeshPools *pools )
+{
+  __gl_poolInit( &pools->vertices, sizeof( GLUvertex ));
+  __gl_poolInit( &pools->faces, sizeof( GLUface ));
+  __gl_poolInit( &pools->edges, sizeof( EdgePair ));
+}
+
+void __gl_meshDeletePools( GLUmemory *memory, GLUmeshPools *pools )
+{
+  __gl_poolDelete( memory, &pools->vertices );
+  __gl_poolDelete( memory, &pools->faces );
+  __gl_poolDelete( memory, &pools->edges );
 }
 
 
 /* __gl_meshNewMesh() creates a new mesh with no edges, no vertices,
  * and no loops (what we usually call a "face").
  */
-GLUmesh *__gl_meshNewMesh( void )
+GLUmesh *__gl_meshNewMesh( GLUmemory *memory, GLUmeshPools *pools )
 {
   GLUvertex *v;
   GLUface *f;
   GLUhalfEdge *e;
   GLUhalfEdge *eSym;
-  GLUmesh *mesh = (GLUmesh *)memAlloc( sizeof( GLUmesh ));
+  GLUmesh *mesh = (GLUmesh *)memAlloc( memory, sizeof( GLUmesh ));
   if (mesh == NULL) {
      return NULL;
   }
+  mesh->memory = memory;
+  mesh->pools = pools;
   
   v = &mesh->vHead;
   f = &mesh->fHead;
@@ -660,6 +679,8 @@ GLUmesh *__gl_meshUnion( GLUmesh *mesh1, GLUmesh *mesh2 )
   GLUvertex *v2 = &mesh2->vHead;
   GLUhalfEdge *e2 = &mesh2->eHead;
 
+  assert( mesh1->pools == mesh2->pools );
+
   /* Add the faces, vertices, and edges of mesh2 to those of mesh1 */
   if( f2->next != f2 ) {
     f1->prev->next = f2->next;
@@ -682,7 +703,7 @@ GLUmesh *__gl_meshUnion( GLUmesh *mesh1, GLUmesh *mesh2 )
     e1->Sym->next = e2->Sym->next;
   }
 
-  memFree( mesh2 );
+  memFree( mesh2->memory, mesh2 );
   return mesh1;
 }
 
@@ -696,40 +717,26 @@ void __gl_meshDeleteMesh( GLUmesh *mesh )
   GLUface *fHead = &mesh->fHead;
 
   while( fHead->next != fHead ) {
-    __gl_meshZapFace( fHead->next );
+    __gl_meshZapFace( mesh, fHead->next );
   }
   assert( mesh->vHead.next == &mesh->vHead );
 
-  memFree( mesh );
+  memFree( mesh->memory, mesh );
 }
 
 #else
 
 /* __gl_meshDeleteMesh( mesh ) will free all storage for any valid mesh.
+ * Everything the pools hold belongs to the mesh (see GLUmeshPools), so
+ * they are just reset, keeping their memory for the next mesh.
  */
 void __gl_meshDeleteMesh( GLUmesh *mesh )
 {
-  GLUface *f, *fNext;
-  GLUvertex *v, *vNext;
-  GLUhalfEdge *e, *eNext;
-
-  for( f = mesh->fHead.next; f != &mesh->fHead; f = fNext ) {
-    fNext = f->next;
-    memFree( f );
-  }
-
-  for( v = mesh->vHead.next; v != &mesh->vHead; v = vNext ) {
-    vNext = v->next;
-    memFree( v );
-  }
-
-  for( e = mesh->eHead.next; e != &mesh->eHead; e = eNext ) {
-    /* One call frees both e and e->Sym (see EdgePair above) */
-    eNext = e->next;
-    memFree( e );
-  }
+  __gl_poolReset( &mesh->pools->vertices );
+  __gl_poolReset( &mesh->pools->faces );
+  __gl_poolReset( &mesh->pools->edges );
 
-  memFree( mesh );
+  memFree( mesh->memory, mesh );
 }
 
 #endif
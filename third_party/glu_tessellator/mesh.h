@@ -43,6 +43,7 @@
 #define __mesh_h_
 
 #include "glu_tessellator.h"
+#include "memalloc.h"
 
 typedef struct GLUmesh GLUmesh; 
 
@@ -167,7 +168,21 @@ struct GLUhalfEdge {
 #define Rnext	Oprev->Sym	/* 3 pointers */
 
 
+/* Storage for the vertices, faces and edges of a mesh.  Deleting a mesh
+ * resets its pools rather than freeing each structure, so the pools may be
+ * kept from one mesh to the next, but only meshes that end up merged by
+ * __gl_meshUnion may share them at the same time.
+ */
+typedef struct GLUmeshPools GLUmeshPools;
+struct GLUmeshPools {
+  GLUpool	vertices;
+  GLUpool	faces;
+  GLUpool	edges;		/* half-edge pairs */
+};
+
 struct GLUmesh {
+  GLUmemory	*memory;	/* allocation hooks of the tessellator */
+  GLUmeshPools	*pools;		/* where the structures below come from */
   GLUvertex	vHead;		/* dummy header for vertex list */
   GLUface	fHead;		/* dummy header for face list */
   GLUhalfEdge	eHead;		/* dummy header for edge list */
@@ -188,6 +203,10 @@ struct GLUmesh {
  * Other internal data (v->data, v->activeRegion, f->data, f->marked,
  * f->trail, e->winding) is set to zero.
  *
+ * All operations that may create or destroy structures take the mesh that
+ * the edges belong to as their first argument; the mesh holds the
+ * allocation hooks to use (see memalloc.h).
+ *
  * ********************** Basic Edge Operations **************************
  *
  * __gl_meshMakeEdge( mesh ) creates one edge, two vertices, and a loop.
@@ -233,15 +252,22 @@ struct GLUmesh {
  *
  * ************************ Other Operations *****************************
  *
- * __gl_meshNewMesh() creates a new mesh with no edges, no vertices,
- * and no loops (what we usually call a "face").
+ * __gl_meshInitPools( pools ) prepares empty pools for meshes, and
+ * __gl_meshDeletePools( memory, pools ) frees the storage they hold.  The
+ * pools must be deleted with the hooks of the meshes that used them.
+ *
+ * __gl_meshNewMesh( memory, pools ) creates a new mesh with no edges, no
+ * vertices, and no loops (what we usually call a "face"), whose structures
+ * are allocated from the given pools, which get their memory through the
+ * given hooks.
  *
  * __gl_meshUnion( mesh1, mesh2 ) forms the union of all structures in
  * both meshes, and returns the new mesh (the old meshes are destroyed).
  *
- * __gl_meshDeleteMesh( mesh ) will free all storage for any valid mesh.
+ * __gl_meshDeleteMesh( mesh ) will free all storage for any valid mesh,
+ * returning the vertices, faces and edges to its pools.
  *
- * __gl_meshZapFace( fZap ) destroys a face and removes it from the
+ * __gl_meshZapFace( mesh, fZap ) destroys a face and removes it from the
  * global face list.  All edges of fZap will have a NULL pointer as their
  * left face.  Any edges which also have a NULL pointer as their right face
  * are deleted entirely (along with any isolated vertices this produces).
@@ -252,17 +278,21 @@ struct GLUmesh {
  */
 
 GLUhalfEdge	*__gl_meshMakeEdge( GLUmesh *mesh );
-int		__gl_meshSplice( GLUhalfEdge *eOrg, GLUhalfEdge *eDst );
-int		__gl_meshDelete( GLUhalfEdge *eDel );
+int		__gl_meshSplice( GLUmesh *mesh,
+				 GLUhalfEdge *eOrg, GLUhalfEdge *eDst );
+int		__gl_meshDelete( GLUmesh *mesh, GLUhalfEdge *eDel );
 
-GLUhalfEdge	*__gl_meshAddEdgeVertex( GLUhalfEdge *eOrg );
-GLUhalfEdge	*__gl_meshSplitEdge( GLUhalfEdge *eOrg );
-GLUhalfEdge	*__gl_meshConnect( GLUhalfEdge *eOrg, GLUhalfEdge *eDst );
+GLUhalfEdge	*__gl_meshAddEdgeVertex( GLUmesh *mesh, GLUhalfEdge *eOrg );
+GLUhalfEdge	*__gl_meshSplitEdge( GLUmesh *mesh, GLUhalfEdge *eOrg );
+GLUhalfEdge	*__gl_meshConnect( GLUmesh *mesh,
+				   GLUhalfEdge *eOrg, GLUhalfEdge *eDst );
 
-GLUmesh		*__gl_meshNewMesh( void );
+void		__gl_meshInitPools( GLUmeshPools *pools );
+void		__gl_meshDeletePools( GLUmemory *memory, GLUmeshPools *pools );
+GLUmesh		*__gl_meshNewMesh( GLUmemory *memory, GLUmeshPools *pools );
 GLUmesh		*__gl_meshUnion( GLUmesh *mesh1, GLUmesh *mesh2 );
 void		__gl_meshDeleteMesh( GLUmesh *mesh );
-void		__gl_meshZapFace( GLUface *fZap );
+void		__gl_meshZapFace( GLUmesh *mesh, GLUface *fZap );
 
 #ifdef NDEBUG
 #define		__gl_meshCheckMesh( mesh )
@@ -74,24 +74,49 @@ static int LongAxis( GLdouble v[3] )
   return i;
 }
 
+/* Below this ratio between the length of the Newell normal (twice the
+ * net area of the contours) and the square of the polygon extent, the
+ * contours are taken to be degenerate, or to cancel each other out, and
+ * the normal is computed from the largest triangle instead.
+ */
+#define NEWELL_MIN_AREA	1e-8
+
+#define UpdateRange(v)							\
+  for( i = 0; i < 3; ++i ) {						\
+    c = (v)->coords[i];							\
+    if( c < minVal[i] ) { minVal[i] = c; minVert[i] = (v); }		\
+    if( c > maxVal[i] ) { maxVal[i] = c; maxVert[i] = (v); }		\
+  }
+
 static void ComputeNormal( struct GLUtesselator *tess, GLdouble norm[3] )
 {
   GLUvertex *v, *v1, *v2;
-  GLdouble c, tLen2, maxLen2;
+  GLUhalfEdge *e, *eHead = &tess->mesh->eHead;
+  GLdouble c, tLen2, maxLen2, range;
   GLdouble maxVal[3], minVal[3], d1[3], d2[3], tNorm[3];
   GLUvertex *maxVert[3], *minVert[3];
   GLUvertex *vHead = &tess->mesh->vHead;
+  GLdouble *p, *q;
   int i;
 
   maxVal[0] = maxVal[1] = maxVal[2] = -2 * GLU_TESS_MAX_COORD;
   minVal[0] = minVal[1] = minVal[2] = 2 * GLU_TESS_MAX_COORD;
 
-  for( v = vHead->next; v != vHead; v = v->next ) {
-    for( i = 0; i < 3; ++i ) {
-      c = v->coords[i];
-      if( c < minVal[i] ) { minVal[i] = c; minVert[i] = v; }
-      if( c > maxVal[i] ) { maxVal[i] = c; maxVert[i] = v; }
-    }
+  /* In a single pass over the contour edges, find the extent of the
+   * polygon, and its normal by Newell's method: the sum over the edges
+   * of the signed areas of their projections onto the coordinate planes.
+   * Each edge is visited in either direction, and e->winding tells which
+   * one follows the contour.
+   */
+  norm[0] = norm[1] = norm[2] = 0;
+  for( e = eHead->next; e != eHead; e = e->next ) {
+    p = e->Org->coords;
+    q = e->Dst->coords;
+    norm[0] += e->winding * (p[1] - q[1]) * (p[2] + q[2]);
+    norm[1] += e->winding * (p[2] - q[2]) * (p[0] + q[0]);
+    norm[2] += e->winding * (p[0] - q[0]) * (p[1] + q[1]);
+    UpdateRange( e->Org );
+    UpdateRange( e->Dst );
   }
 
   /* Find two vertices separated by at least 1/sqrt(3) of the maximum
@@ -105,6 +130,11 @@ static void ComputeNormal( struct GLUtesselator *tess, GLdouble norm[3] )
     norm[0] = 0; norm[1] = 0; norm[2] = 1;
     return;
   }
+  range = maxVal[i] - minVal[i];
+  if( Dot( norm, norm ) > (NEWELL_MIN_AREA * range * range)
+			  * (NEWELL_MIN_AREA * range * range) ) {
+    return;
+  }
 
   /* Look for a third vertex which forms the triangle with maximum area
    * (Length of normal == twice the triangle area)
@@ -249,10 +279,32 @@ void __gl_projectPolygon( struct GLUtesselator *tess )
 #endif
 
   /* Project the vertices onto the sweep plane */
+#if defined(FOR_TRITE_TEST_PROGRAM) || defined(TRUE_PROJECT) \
+    || defined(SLANTED_SWEEP)
   for( v = vHead->next; v != vHead; v = v->next ) {
     v->s = Dot( v->coords, sUnit );
     v->t = Dot( v->coords, tUnit );
   }
+#else
+  /* sUnit and tUnit are unit coordinate axes, up to the sign of tUnit, so
+   * the projection only takes picking two of the coordinates.
+   */
+  {
+    int sAxis = (i+1)%3, tAxis = (i+2)%3;
+
+    if( tUnit[tAxis] > 0 ) {
+      for( v = vHead->next; v != vHead; v = v->next ) {
+	v->s = v->coords[sAxis];
+	v->t = v->coords[tAxis];
+      }
+    } else {
+      for( v = vHead->next; v != vHead; v = v->next ) {
+	v->s = v->coords[sAxis];
+	v->t = - v->coords[tAxis];
+      }
+    }
+  }
+#endif
   if( computedNormal ) {
     CheckOrientation( tess );
   }
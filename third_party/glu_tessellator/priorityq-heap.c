@@ -60,23 +60,27 @@
 #endif
 
 /* really __gl_pqHeapNewPriorityQ */
-PriorityQ *pqNewPriorityQ( int (*leq)(PQkey key1, PQkey key2) )
+PriorityQ *pqNewPriorityQ( GLUmemory *memory,
+			   int (*leq)(PQkey key1, PQkey key2) )
 {
-  PriorityQ *pq = (PriorityQ *)memAlloc( sizeof( PriorityQ ));
+  PriorityQ *pq = (PriorityQ *)memAlloc( memory, sizeof( PriorityQ ));
   if (pq == NULL) return NULL;
 
+  pq->memory = memory;
   pq->size = 0;
   pq->max = INIT_SIZE;
-  pq->nodes = (PQnode *)memAlloc( (INIT_SIZE + 1) * sizeof(pq->nodes[0]) );
+  pq->nodes = (PQnode *)memAlloc( memory,
+				  (INIT_SIZE + 1) * sizeof(pq->nodes[0]) );
   if (pq->nodes == NULL) {
-     memFree(pq);
+     memFree(memory, pq);
      return NULL;
   }
 
-  pq->handles = (PQhandleElem *)memAlloc( (INIT_SIZE + 1) * sizeof(pq->handles[0]) );
+  pq->handles = (PQhandleElem *)memAlloc( memory,
+				  (INIT_SIZE + 1) * sizeof(pq->handles[0]) );
   if (pq->handles == NULL) {
-     memFree(pq->nodes);
-     memFree(pq);
+     memFree(memory, pq->nodes);
+     memFree(memory, pq);
      return NULL;
   }
 
@@ -92,9 +96,10 @@ PriorityQ *pqNewPriorityQ( int (*leq)(PQkey key1, PQkey key2) )
 /* really __gl_pqHeapDeletePriorityQ */
 void pqDeletePriorityQ( PriorityQ *pq )
 {
-  memFree( pq->handles );
-  memFree( pq->nodes );
-  memFree( pq );
+  GLUmemory *memory = pq->memory;
+  memFree( memory, pq->handles );
+  memFree( memory, pq->nodes );
+  memFree( memory, pq );
 }
 
 
@@ -177,14 +182,14 @@ PQhandle pqInsert( PriorityQ *pq, PQkey keyNew )
 
     /* If the heap overflows, double its size. */
     pq->max <<= 1;
-    pq->nodes = (PQnode *)memRealloc( pq->nodes, 
+    pq->nodes = (PQnode *)memRealloc( pq->memory, pq->nodes,
 				     (size_t) 
 				     ((pq->max + 1) * sizeof( pq->nodes[0] )));
     if (pq->nodes == NULL) {
        pq->nodes = saveNodes;	/* restore ptr to free upon return */
        return LONG_MAX;
     }
-    pq->handles = (PQhandleElem *)memRealloc( pq->handles,
+    pq->handles = (PQhandleElem *)memRealloc( pq->memory, pq->handles,
 			                     (size_t)
 			                      ((pq->max + 1) * 
 					       sizeof( pq->handles[0] )));
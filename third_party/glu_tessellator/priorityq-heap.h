@@ -42,13 +42,15 @@
 #ifndef __priorityq_heap_h_
 #define __priorityq_heap_h_
 
+#include "memalloc.h"
+
 /* Use #define's so that another heap implementation can use this one */
 
 #define PQkey			PQHeapKey
 #define PQhandle		PQHeapHandle
 #define PriorityQ		PriorityQHeap
 
-#define pqNewPriorityQ(leq)	__gl_pqHeapNewPriorityQ(leq)
+#define pqNewPriorityQ(memory,leq)	__gl_pqHeapNewPriorityQ(memory,leq)
 #define pqDeletePriorityQ(pq)	__gl_pqHeapDeletePriorityQ(pq)
 
 /* The basic operations are insertion of a new key (pqInsert),
@@ -91,6 +93,7 @@ typedef struct { PQhandle handle; } PQnode;
 typedef struct { PQkey key; PQhandle node; } PQhandleElem;
 
 struct PriorityQ {
+  GLUmemory	*memory;
   PQnode	*nodes;
   PQhandleElem	*handles;
   long		size, max;
@@ -99,7 +102,8 @@ struct PriorityQ {
   int		(*leq)(PQkey key1, PQkey key2);
 };
   
-PriorityQ	*pqNewPriorityQ( int (*leq)(PQkey key1, PQkey key2) );
+PriorityQ	*pqNewPriorityQ( GLUmemory *memory,
+				 int (*leq)(PQkey key1, PQkey key2) );
 void		pqDeletePriorityQ( PriorityQ *pq );
 
 void		pqInit( PriorityQ *pq );
@@ -62,7 +62,7 @@
 #define PQhandle		PQSortHandle
 #define PriorityQ		PriorityQSort
 
-#define pqNewPriorityQ(leq)	__gl_pqSortNewPriorityQ(leq)
+#define pqNewPriorityQ(memory,leq)	__gl_pqSortNewPriorityQ(memory,leq)
 #define pqDeletePriorityQ(pq)	__gl_pqSortDeletePriorityQ(pq)
 
 /* The basic operations are insertion of a new key (pqInsert),
@@ -102,6 +102,7 @@ typedef PQHeapHandle PQhandle;
 typedef struct PriorityQ PriorityQ;
 
 struct PriorityQ {
+  GLUmemory	*memory;
   PriorityQHeap	*heap;
   PQkey		*keys;
   PQkey		**order;
@@ -110,7 +111,8 @@ struct PriorityQ {
   int		(*leq)(PQkey key1, PQkey key2);
 };
   
-PriorityQ	*pqNewPriorityQ( int (*leq)(PQkey key1, PQkey key2) );
+PriorityQ	*pqNewPriorityQ( GLUmemory *memory,
+				 int (*leq)(PQkey key1, PQkey key2) );
 void		pqDeletePriorityQ( PriorityQ *pq );
 
 int		pqInit( PriorityQ *pq );
@@ -53,23 +53,26 @@
 #include "priorityq-sort.h"
 
 /* really __gl_pqSortNewPriorityQ */
-PriorityQ *pqNewPriorityQ( int (*leq)(PQkey key1, PQkey key2) )
+PriorityQ *pqNewPriorityQ( GLUmemory *memory,
+			   int (*leq)(PQkey key1, PQkey key2) )
 {
-  PriorityQ *pq = (PriorityQ *)memAlloc( sizeof( PriorityQ ));
+  PriorityQ *pq = (PriorityQ *)memAlloc( memory, sizeof( PriorityQ ));
   if (pq == NULL) return NULL;
 
-  pq->heap = __gl_pqHeapNewPriorityQ( leq );
+  pq->memory = memory;
+  pq->heap = __gl_pqHeapNewPriorityQ( memory, leq );
   if (pq->heap == NULL) {
-     memFree(pq);
+     memFree(memory, pq);
      return NULL;
   }
 
-  pq->keys = (PQHeapKey *)memAlloc( INIT_SIZE * sizeof(pq->keys[0]) );
+  pq->keys = (PQHeapKey *)memAlloc( memory, INIT_SIZE * sizeof(pq->keys[0]) );
   if (pq->keys == NULL) {
      __gl_pqHeapDeletePriorityQ(pq->heap);
-     memFree(pq);
+     memFree(memory, pq);
      return NULL;
   }
+  pq->order = NULL;
 
   pq->size = 0;
   pq->max = INIT_SIZE;
@@ -83,9 +86,9 @@ void pqDeletePriorityQ( PriorityQ *pq )
 {
   assert(pq != NULL); 
   if (pq->heap != NULL) __gl_pqHeapDeletePriorityQ( pq->heap );
-  if (pq->order != NULL) memFree( pq->order );
-  if (pq->keys != NULL) memFree( pq->keys );
-  memFree( pq );
+  if (pq->order != NULL) memFree( pq->memory, pq->order );
+  if (pq->keys != NULL) memFree( pq->memory, pq->keys );
+  memFree( pq->memory, pq );
 }
 
 
@@ -93,37 +96,110 @@ void pqDeletePriorityQ( PriorityQ *pq )
 #define GT(x,y)		(! LEQ(x,y))
 #define Swap(a,b)	if(1){PQkey *tmp = *a; *a = *b; *b = tmp;}else
 
-/* really __gl_pqSortInit */
-int pqInit( PriorityQ *pq )
+#ifndef FOR_TRITE_TEST_PROGRAM
+
+/* The keys are vertices, so that the order array can also be sorted by
+ * radix on the bits of the (s,t) coordinates.  Quicksort is faster for
+ * small queues, but its comparisons go through two levels of pointers,
+ * and from about 8k keys on, the radix sort's sequential passes win
+ * (by a third at 100k keys).
+ */
+#define RADIX_SORT_MIN_SIZE	8192
+#define RADIX_BITS		8
+#define RADIX_SIZE		(1 << RADIX_BITS)
+#define RADIX_WORD_DIGITS	((64 + RADIX_BITS - 1) / RADIX_BITS)
+#define RADIX_DIGITS		(2 * RADIX_WORD_DIGITS)	/* t, then s */
+
+typedef struct {
+  unsigned long long	bits[2];	/* t and s, see SortableBits */
+  PQkey			*key;
+} RadixItem;
+
+#define Digit(item,d)	((unsigned)((item)->bits[(d) / RADIX_WORD_DIGITS] \
+			 >> ((d) % RADIX_WORD_DIGITS * RADIX_BITS)) \
+			 & (RADIX_SIZE - 1))
+
+/* SortableBits maps a coordinate to an integer in the same order: the
+ * bits of a positive double grow with it, so only the sign needs fixing.
+ */
+static unsigned long long SortableBits( GLdouble x )
+{
+  union { GLdouble d; unsigned long long u; } bits;
+  const unsigned long long sign = 1ULL << 63;
+
+  bits.d = (x == 0) ? 0 : x;	/* -0 and +0 are equal for VertLeq */
+  return (bits.u & sign) ? ~bits.u : (bits.u | sign);
+}
+
+/* RadixSortOrder sorts the order array in descending order with a stable
+ * LSD radix sort, one byte of t then s at a time.  Bytes that are the same
+ * for all the keys, such as the sign and exponent bytes of coordinates
+ * that are all in the same range, are skipped.  Returns 0, leaving the
+ * sorting to Quicksort, if the queue is small or memory runs out.
+ */
+static int RadixSortOrder( PriorityQ *pq )
+{
+  long n = pq->size;
+  long i, sum, *count;
+  RadixItem *from, *to, *tmp;
+  int d;
+
+  if( n < RADIX_SORT_MIN_SIZE ) return 0;
+  from = (RadixItem *)memAlloc( pq->memory, 2 * n * sizeof( RadixItem )
+			       + RADIX_DIGITS * RADIX_SIZE * sizeof( long ));
+  if (from == NULL) return 0;
+  to = from + n;
+  count = (long *)(to + n);
+
+  for( i = 0; i < RADIX_DIGITS * RADIX_SIZE; ++i ) {
+    count[i] = 0;
+  }
+  for( i = 0; i < n; ++i ) {
+    GLUvertex *v = (GLUvertex *)pq->keys[i];
+    from[i].bits[0] = SortableBits( v->t );
+    from[i].bits[1] = SortableBits( v->s );
+    from[i].key = &pq->keys[i];
+    for( d = 0; d < RADIX_DIGITS; ++d ) {
+      ++count[d * RADIX_SIZE + Digit( &from[i], d )];
+    }
+  }
+
+  for( d = 0; d < RADIX_DIGITS; ++d ) {
+    long *start = count + d * RADIX_SIZE;
+    if( start[Digit( &from[0], d )] == n ) continue;
+    for( sum = 0, i = 0; i < RADIX_SIZE; ++i ) {
+      long c = start[i];
+      start[i] = sum;
+      sum += c;
+    }
+    for( i = 0; i < n; ++i ) {
+      to[start[Digit( &from[i], d )]++] = from[i];
+    }
+    tmp = from; from = to; to = tmp;
+  }
+
+  for( i = 0; i < n; ++i ) {
+    pq->order[n - 1 - i] = from[i].key;
+  }
+  memFree( pq->memory, (from < to) ? from : to );
+  return 1;
+}
+
+#else
+#define RadixSortOrder(pq)	0
+#endif
+
+/* QuickSortOrder sorts the order array in descending order,
+ * using randomized Quicksort.
+ */
+static void QuickSortOrder( PriorityQ *pq )
 {
   PQkey **p, **r, **i, **j, *piv;
   struct { PQkey **p, **r; } Stack[50], *top = Stack;
   unsigned long seed = 2016473283;
 
-  /* Create an array of indirect pointers to the keys, so that we
-   * the handles we have returned are still valid.
-   */
-/*
-  pq->order = (PQHeapKey **)memAlloc( (size_t)
-                                  (pq->size * sizeof(pq->order[0])) );
-*/
-  pq->order = (PQHeapKey **)memAlloc( (size_t)
-                                  ((pq->size+1) * sizeof(pq->order[0])) );
-/* the previous line is a patch to compensate for the fact that IBM */
-/* machines return a null on a malloc of zero bytes (unlike SGI),   */
-/* so we have to put in this defense to guard against a memory      */
-/* fault four lines down. from fossum@austin.ibm.com.               */
-  if (pq->order == NULL) return 0;
-
   p = pq->order;
   r = p + pq->size - 1;
-  for( piv = pq->keys, i = p; i <= r; ++piv, ++i ) {
-    *i = piv;
-  }
-
-  /* Sort the indirect pointers in descending order,
-   * using randomized Quicksort
-   */
   top->p = p; top->r = r; ++top;
   while( --top >= Stack ) {
     p = top->p;
@@ -159,6 +235,37 @@ int pqInit( PriorityQ *pq )
       *j = piv;
     }
   }
+}
+
+/* really __gl_pqSortInit */
+int pqInit( PriorityQ *pq )
+{
+  PQkey **p, **r, **i, *piv;
+
+  /* Create an array of indirect pointers to the keys, so that we
+   * the handles we have returned are still valid.
+   */
+/*
+  pq->order = (PQHeapKey **)memAlloc( (size_t)
+                                  (pq->size * sizeof(pq->order[0])) );
+*/
+  pq->order = (PQHeapKey **)memAlloc( pq->memory, (size_t)
+                                  ((pq->size+1) * sizeof(pq->order[0])) );
+/* the previous line is a patch to compensate for the fact that IBM */
+/* machines return a null on a malloc of zero bytes (unlike SGI),   */
+/* so we have to put in this defense to guard against a memory      */
+/* fault four lines down. from fossum@austin.ibm.com.               */
+  if (pq->order == NULL) return 0;
+
+  p = pq->order;
+  r = p + pq->size - 1;
+  for( piv = pq->keys, i = p; i <= r; ++piv, ++i ) {
+    *i = piv;
+  }
+
+  if( ! RadixSortOrder( pq )) {
+    QuickSortOrder( pq );
+  }
   pq->max = pq->size;
   pq->initialized = TRUE;
   __gl_pqHeapInit( pq->heap );	/* always succeeds */
@@ -189,7 +296,7 @@ PQhandle pqInsert( PriorityQ *pq, PQkey keyNew )
 
     /* If the heap overflows, double its size. */
     pq->max <<= 1;
-    pq->keys = (PQHeapKey *)memRealloc( pq->keys, 
+    pq->keys = (PQHeapKey *)memRealloc( pq->memory, pq->keys,
 	 	                        (size_t)
 	                                 (pq->max * sizeof( pq->keys[0] )));
     if (pq->keys == NULL) {	
@@ -41,9 +41,11 @@
 
 #include <assert.h>
 #include <stddef.h>
+#include <setjmp.h>
 #include "mesh.h"
 #include "tess.h"
 #include "render.h"
+#include "memalloc.h"
 
 #ifndef TRUE
 #define TRUE 1
@@ -74,6 +76,74 @@ static void RenderLonelyTriangles( GLUtesselator *tess, GLUface *head );
 
 
 
+/************************ Triangle list output ******************/
+
+#define TESS_INIT_TRIANGLES	64
+
+/* ReserveTriangles( tess, count ) makes room for count triangles in the
+ * arrays handed to the triangle list callback.  The arrays grow as needed
+ * and are kept from one polygon to the next.  Returns 0 if memory is
+ * exhausted.
+ */
+static int ReserveTriangles( GLUtesselator *tess, int count )
+{
+  void **vertices;
+  GLboolean *boundary;
+  int size;
+
+  if( count <= tess->triSize ) return 1;
+  size = (tess->triSize == 0) ? TESS_INIT_TRIANGLES : tess->triSize;
+  while( size < count ) size *= 2;
+
+  vertices = (void **)((tess->triVertices == NULL)
+	     ? memAlloc( &tess->memory, 3 * size * sizeof( void * ))
+	     : memRealloc( &tess->memory, tess->triVertices,
+			   3 * size * sizeof( void * )));
+  if (vertices == NULL) return 0;
+  tess->triVertices = vertices;
+  boundary = (GLboolean *)((tess->triBoundary == NULL)
+	     ? memAlloc( &tess->memory, 3 * size * sizeof( GLboolean ))
+	     : memRealloc( &tess->memory, tess->triBoundary,
+			   3 * size * sizeof( GLboolean )));
+  if (boundary == NULL) return 0;
+  tess->triBoundary = boundary;
+  tess->triSize = size;
+  return 1;
+}
+
+/* __gl_renderTriangles( tess, mesh ) outputs the triangles of the mesh
+ * all at once, through the triangle list callback (a Ginsu extension).
+ * There are no strips or fans to look for: each interior face is a
+ * triangle, and each of its edges is on the boundary if the face on the
+ * other side is exterior.
+ */
+void __gl_renderTriangles( GLUtesselator *tess, GLUmesh *mesh )
+{
+  GLUface *f;
+  GLUhalfEdge *e;
+  int count = 0, i = 0;
+
+  for( f = mesh->fHead.next; f != &mesh->fHead; f = f->next ) {
+    if( f->inside ) ++count;
+  }
+  if( count == 0 ) return;
+  if( !ReserveTriangles( tess, count )) longjmp(tess->env,1);
+
+  for( f = mesh->fHead.next; f != &mesh->fHead; f = f->next ) {
+    if( ! f->inside ) continue;
+    e = f->anEdge;
+    do {
+      tess->triVertices[i] = e->Org->data;
+      tess->triBoundary[i] = ! e->Rface->inside;
+      ++i;
+      e = e->Lnext;
+    } while( e != f->anEdge );
+  }
+  assert( i == 3 * count );
+  CALL_TRIANGLES_DATA( count );
+}
+
+
 /************************ Strips and Fans decomposition ******************/
 
 /* __gl_renderMesh( tess, mesh ) takes a mesh and breaks it into triangle
@@ -435,9 +505,59 @@ static int ComputeNormal( GLUtesselator *tess, GLdouble norm[3], int check )
   return sign;
 }
 
+/* RenderFanTriangles( tess, sign ) renders the fan of the cached vertices
+ * about the first one as separate triangles, reversed if the contour is
+ * clockwise (sign < 0).  Like RenderLonelyTriangles, it precedes each
+ * vertex with the edge flag of the edge it starts, whenever the flag
+ * changes.  If there is a triangle list callback, the triangles go
+ * through it instead.
+ */
+static void RenderFanTriangles( GLUtesselator *tess, int sign )
+{
+  CachedVertex *v0 = tess->cache;
+  CachedVertex *corner[3];
+  int n = tess->cacheCount;
+  int i, j, k = 0, newState;
+  int edgeState = -1;	/* force edge state output for first vertex */
+  int list = (tess->callTrianglesData != &__gl_noTrianglesData);
+
+  if( list ) {
+    if( !ReserveTriangles( tess, n - 2 )) longjmp(tess->env,1);
+  } else {
+    CALL_BEGIN_OR_BEGIN_DATA( GL_TRIANGLES );
+  }
+  for( i = 1; i < n - 1; ++i ) {
+    corner[0] = v0;
+    corner[1] = (sign > 0) ? v0 + i : v0 + n - i;
+    corner[2] = (sign > 0) ? v0 + i + 1 : v0 + n - i - 1;
+    for( j = 0; j < 3; ++j ) {
+      /* The edge from corner 1 to corner 2 is always on the boundary; the
+       * edges at v0 only are for the first and last triangles.
+       */
+      newState = (j == 1) || (j == 0 && i == 1) || (j == 2 && i == n - 2);
+      if( list ) {
+	tess->triVertices[k] = corner[j]->data;
+	tess->triBoundary[k++] = newState;
+	continue;
+      }
+      if( edgeState != newState ) {
+	edgeState = newState;
+	CALL_EDGE_FLAG_OR_EDGE_FLAG_DATA( edgeState );
+      }
+      CALL_VERTEX_OR_VERTEX_DATA( corner[j]->data );
+    }
+  }
+  if( list ) {
+    CALL_TRIANGLES_DATA( n - 2 );
+  } else {
+    CALL_END_OR_END_DATA();
+  }
+}
+
 /* __gl_renderCache( tess ) takes a single contour and tries to render it
  * as a triangle fan.  This handles convex polygons, as well as some
- * non-convex polygons if we get lucky.
+ * non-convex polygons if we get lucky.  When edge flags are requested, the
+ * fan is rendered as separate triangles instead.
  *
  * Returns TRUE if the polygon was successfully rendered.  The rendering
  * output is provided as callbacks (see the api).
@@ -487,6 +607,13 @@ GLboolean __gl_renderCache( GLUtesselator *tess )
     return TRUE;
   }
 
+  if( (tess->flagBoundary
+       || tess->callTrianglesData != &__gl_noTrianglesData)
+      && ! tess->boundaryOnly ) {
+    RenderFanTriangles( tess, sign );
+    return TRUE;
+  }
+
   CALL_BEGIN_OR_BEGIN_DATA( tess->boundaryOnly ? GL_LINE_LOOP
 			  : (tess->cacheCount > 3) ? GL_TRIANGLE_FAN
 			  : GL_TRIANGLES );
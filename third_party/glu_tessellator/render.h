@@ -55,6 +55,11 @@ struct GLUmesh;
 void __gl_renderMesh( struct GLUtesselator *tess, struct GLUmesh *mesh );
 void __gl_renderBoundary( struct GLUtesselator *tess, struct GLUmesh *mesh );
 
+/* __gl_renderTriangles( tess, mesh ) outputs the triangles of the mesh
+ * all at once, through the triangle list callback (a Ginsu extension).
+ */
+void __gl_renderTriangles( struct GLUtesselator *tess, struct GLUmesh *mesh );
+
 GLboolean __gl_renderCache( struct GLUtesselator *tess );
 
 #endif
@@ -159,17 +159,18 @@ static void DeleteRegion( struct GLUtesselator *tess, ActiveRegion *reg )
   }
   reg->eUp->activeRegion = NULL;
   dictDelete( tess->dict, reg->nodeUp ); /* __gl_dictListDelete */
-  memFree( reg );
+  memFree( &tess->memory, reg );
 }
 
 
-static int FixUpperEdge( ActiveRegion *reg, GLUhalfEdge *newEdge )
+static int FixUpperEdge( struct GLUtesselator *tess, ActiveRegion *reg,
+			 GLUhalfEdge *newEdge )
 /*
  * Replace an upper edge which needs fixing (see ConnectRightVertex).
  */
 {
   assert( reg->fixUpperEdge );
-  if ( !__gl_meshDelete( reg->eUp ) ) return 0;
+  if ( !__gl_meshDelete( tess->mesh, reg->eUp ) ) return 0;
   reg->fixUpperEdge = FALSE;
   reg->eUp = newEdge;
   newEdge->activeRegion = reg;
@@ -177,7 +178,8 @@ static int FixUpperEdge( ActiveRegion *reg, GLUhalfEdge *newEdge )
   return 1; 
 }
 
-static ActiveRegion *TopLeftRegion( ActiveRegion *reg )
+static ActiveRegion *TopLeftRegion( struct GLUtesselator *tess,
+				    ActiveRegion *reg )
 {
   GLUvertex *org = reg->eUp->Org;
   GLUhalfEdge *e;
@@ -191,9 +193,9 @@ static ActiveRegion *TopLeftRegion( ActiveRegion *reg )
    * now is the time to fix it.
    */
   if( reg->fixUpperEdge ) {
-    e = __gl_meshConnect( RegionBelow(reg)->eUp->Sym, reg->eUp->Lnext );
+    e = __gl_meshConnect( tess->mesh, RegionBelow(reg)->eUp->Sym, reg->eUp->Lnext );
     if (e == NULL) return NULL;
-    if ( !FixUpperEdge( reg, e ) ) return NULL;
+    if ( !FixUpperEdge( tess, reg, e ) ) return NULL;
     reg = RegionAbove( reg );
   }
   return reg;
@@ -220,7 +222,8 @@ static ActiveRegion *AddRegionBelow( struct GLUtesselator *tess,
  * Winding number and "inside" flag are not updated.
  */
 {
-  ActiveRegion *regNew = (ActiveRegion *)memAlloc( sizeof( ActiveRegion ));
+  ActiveRegion *regNew = (ActiveRegion *)memAlloc( &tess->memory,
+						   sizeof( ActiveRegion ));
   if (regNew == NULL) longjmp(tess->env,1);
 
   regNew->eUp = eNewUp;
@@ -319,15 +322,15 @@ static GLUhalfEdge *FinishLeftRegions( struct GLUtesselator *tess,
       /* If the edge below was a temporary edge introduced by
        * ConnectRightVertex, now is the time to fix it.
        */
-      e = __gl_meshConnect( ePrev->Lprev, e->Sym );
+      e = __gl_meshConnect( tess->mesh, ePrev->Lprev, e->Sym );
       if (e == NULL) longjmp(tess->env,1);
-      if ( !FixUpperEdge( reg, e ) ) longjmp(tess->env,1);
+      if ( !FixUpperEdge( tess, reg, e ) ) longjmp(tess->env,1);
     }
 
     /* Relink edges so that ePrev->Onext == e */
     if( ePrev->Onext != e ) {
-      if ( !__gl_meshSplice( e->Oprev, e ) ) longjmp(tess->env,1);
-      if ( !__gl_meshSplice( ePrev, e ) ) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, e->Oprev, e ) ) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, ePrev, e ) ) longjmp(tess->env,1);
     }
     FinishRegion( tess, regPrev );	/* may change reg->eUp */
     ePrev = reg->eUp;
@@ -379,8 +382,8 @@ static void AddRightEdges( struct GLUtesselator *tess, ActiveRegion *regUp,
 
     if( e->Onext != ePrev ) {
       /* Unlink e from its current position, and relink below ePrev */
-      if ( !__gl_meshSplice( e->Oprev, e ) ) longjmp(tess->env,1);
-      if ( !__gl_meshSplice( ePrev->Oprev, e ) ) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, e->Oprev, e ) ) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, ePrev->Oprev, e ) ) longjmp(tess->env,1);
     }
     /* Compute the winding number and "inside" flag for the new regions */
     reg->windingNumber = regPrev->windingNumber - e->winding;
@@ -393,7 +396,7 @@ static void AddRightEdges( struct GLUtesselator *tess, ActiveRegion *regUp,
     if( ! firstTime && CheckForRightSplice( tess, regPrev )) {
       AddWinding( e, ePrev );
       DeleteRegion( tess, regPrev );
-      if ( !__gl_meshDelete( ePrev ) ) longjmp(tess->env,1);
+      if ( !__gl_meshDelete( tess->mesh, ePrev ) ) longjmp(tess->env,1);
     }
     firstTime = FALSE;
     regPrev = reg;
@@ -448,7 +451,7 @@ static void SpliceMergeVertices( struct GLUtesselator *tess, GLUhalfEdge *e1,
   data[0] = e1->Org->data;
   data[1] = e2->Org->data;
   CallCombine( tess, e1->Org, data, weights, FALSE );
-  if ( !__gl_meshSplice( e1, e2 ) ) longjmp(tess->env,1); 
+  if ( !__gl_meshSplice( tess->mesh, e1, e2 ) ) longjmp(tess->env,1); 
 }
 
 static void VertexWeights( GLUvertex *isect, GLUvertex *org, GLUvertex *dst,
@@ -533,8 +536,8 @@ static int CheckForRightSplice( struct GLUtesselator *tess, ActiveRegion *regUp
     /* eUp->Org appears to be below eLo */
     if( ! VertEq( eUp->Org, eLo->Org )) {
       /* Splice eUp->Org into eLo */
-      if ( __gl_meshSplitEdge( eLo->Sym ) == NULL) longjmp(tess->env,1);
-      if ( !__gl_meshSplice( eUp, eLo->Oprev ) ) longjmp(tess->env,1);
+      if ( __gl_meshSplitEdge( tess->mesh, eLo->Sym ) == NULL) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, eUp, eLo->Oprev ) ) longjmp(tess->env,1);
       regUp->dirty = regLo->dirty = TRUE;
 
     } else if( eUp->Org != eLo->Org ) {
@@ -547,8 +550,8 @@ static int CheckForRightSplice( struct GLUtesselator *tess, ActiveRegion *regUp
 
     /* eLo->Org appears to be above eUp, so splice eLo->Org into eUp */
     RegionAbove(regUp)->dirty = regUp->dirty = TRUE;
-    if (__gl_meshSplitEdge( eUp->Sym ) == NULL) longjmp(tess->env,1);
-    if ( !__gl_meshSplice( eLo->Oprev, eUp ) ) longjmp(tess->env,1);
+    if (__gl_meshSplitEdge( tess->mesh, eUp->Sym ) == NULL) longjmp(tess->env,1);
+    if ( !__gl_meshSplice( tess->mesh, eLo->Oprev, eUp ) ) longjmp(tess->env,1);
   }
   return TRUE;
 }
@@ -585,18 +588,18 @@ static int CheckForLeftSplice( struct GLUtesselator *tess, ActiveRegion *regUp )
 
     /* eLo->Dst is above eUp, so splice eLo->Dst into eUp */
     RegionAbove(regUp)->dirty = regUp->dirty = TRUE;
-    e = __gl_meshSplitEdge( eUp );
+    e = __gl_meshSplitEdge( tess->mesh, eUp );
     if (e == NULL) longjmp(tess->env,1);
-    if ( !__gl_meshSplice( eLo->Sym, e ) ) longjmp(tess->env,1);
+    if ( !__gl_meshSplice( tess->mesh, eLo->Sym, e ) ) longjmp(tess->env,1);
     e->Lface->inside = regUp->inside;
   } else {
     if( EdgeSign( eLo->Dst, eUp->Dst, eLo->Org ) > 0 ) return FALSE;
 
     /* eUp->Dst is below eLo, so splice eUp->Dst into eLo */
     regUp->dirty = regLo->dirty = TRUE;
-    e = __gl_meshSplitEdge( eLo );
+    e = __gl_meshSplitEdge( tess->mesh, eLo );
     if (e == NULL) longjmp(tess->env,1);    
-    if ( !__gl_meshSplice( eUp->Lnext, eLo->Sym ) ) longjmp(tess->env,1);
+    if ( !__gl_meshSplice( tess->mesh, eUp->Lnext, eLo->Sym ) ) longjmp(tess->env,1);
     e->Rface->inside = regUp->inside;
   }
   return TRUE;
@@ -692,9 +695,9 @@ static int CheckForIntersect( struct GLUtesselator *tess, ActiveRegion *regUp )
      */
     if( dstLo == tess->event ) {
       /* Splice dstLo into eUp, and process the new region(s) */
-      if (__gl_meshSplitEdge( eUp->Sym ) == NULL) longjmp(tess->env,1);
-      if ( !__gl_meshSplice( eLo->Sym, eUp ) ) longjmp(tess->env,1);
-      regUp = TopLeftRegion( regUp );
+      if (__gl_meshSplitEdge( tess->mesh, eUp->Sym ) == NULL) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, eLo->Sym, eUp ) ) longjmp(tess->env,1);
+      regUp = TopLeftRegion( tess, regUp );
       if (regUp == NULL) longjmp(tess->env,1);
       eUp = RegionBelow(regUp)->eUp;
       FinishLeftRegions( tess, RegionBelow(regUp), regLo );
@@ -703,8 +706,8 @@ static int CheckForIntersect( struct GLUtesselator *tess, ActiveRegion *regUp )
     }
     if( dstUp == tess->event ) {
       /* Splice dstUp into eLo, and process the new region(s) */
-      if (__gl_meshSplitEdge( eLo->Sym ) == NULL) longjmp(tess->env,1);
-      if ( !__gl_meshSplice( eUp->Lnext, eLo->Oprev ) ) longjmp(tess->env,1); 
+      if (__gl_meshSplitEdge( tess->mesh, eLo->Sym ) == NULL) longjmp(tess->env,1);
+      if ( !__gl_meshSplice( tess->mesh, eUp->Lnext, eLo->Oprev ) ) longjmp(tess->env,1); 
       regLo = regUp;
       regUp = TopRightRegion( regUp );
       e = RegionBelow(regUp)->eUp->Rprev;
@@ -719,13 +722,13 @@ static int CheckForIntersect( struct GLUtesselator *tess, ActiveRegion *regUp )
      */
     if( EdgeSign( dstUp, tess->event, &isect ) >= 0 ) {
       RegionAbove(regUp)->dirty = regUp->dirty = TRUE;
-      if (__gl_meshSplitEdge( eUp->Sym ) == NULL) longjmp(tess->env,1);
+      if (__gl_meshSplitEdge( tess->mesh, eUp->Sym ) == NULL) longjmp(tess->env,1);
       eUp->Org->s = tess->event->s;
       eUp->Org->t = tess->event->t;
     }
     if( EdgeSign( dstLo, tess->event, &isect ) <= 0 ) {
       regUp->dirty = regLo->dirty = TRUE;
-      if (__gl_meshSplitEdge( eLo->Sym ) == NULL) longjmp(tess->env,1);
+      if (__gl_meshSplitEdge( tess->mesh, eLo->Sym ) == NULL) longjmp(tess->env,1);
       eLo->Org->s = tess->event->s;
       eLo->Org->t = tess->event->t;
     }
@@ -741,9 +744,9 @@ static int CheckForIntersect( struct GLUtesselator *tess, ActiveRegion *regUp )
    * the mesh (ie. eUp->Lface) to be smaller than the faces in the
    * unprocessed original contours (which will be eLo->Oprev->Lface).
    */
-  if (__gl_meshSplitEdge( eUp->Sym ) == NULL) longjmp(tess->env,1);
-  if (__gl_meshSplitEdge( eLo->Sym ) == NULL) longjmp(tess->env,1);
-  if ( !__gl_meshSplice( eLo->Oprev, eUp ) ) longjmp(tess->env,1);
+  if (__gl_meshSplitEdge( tess->mesh, eUp->Sym ) == NULL) longjmp(tess->env,1);
+  if (__gl_meshSplitEdge( tess->mesh, eLo->Sym ) == NULL) longjmp(tess->env,1);
+  if ( !__gl_meshSplice( tess->mesh, eLo->Oprev, eUp ) ) longjmp(tess->env,1);
   eUp->Org->s = isect.s;
   eUp->Org->t = isect.t;
   eUp->Org->pqHandle = pqInsert( tess->pq, eUp->Org ); /* __gl_pqSortInsert */
@@ -798,12 +801,12 @@ static void WalkDirtyRegions( struct GLUtesselator *tess, ActiveRegion *regUp )
 	 */
 	if( regLo->fixUpperEdge ) {
 	  DeleteRegion( tess, regLo );
-	  if ( !__gl_meshDelete( eLo ) ) longjmp(tess->env,1);
+	  if ( !__gl_meshDelete( tess->mesh, eLo ) ) longjmp(tess->env,1);
 	  regLo = RegionBelow( regUp );
 	  eLo = regLo->eUp;
 	} else if( regUp->fixUpperEdge ) {
 	  DeleteRegion( tess, regUp );
-	  if ( !__gl_meshDelete( eUp ) ) longjmp(tess->env,1);
+	  if ( !__gl_meshDelete( tess->mesh, eUp ) ) longjmp(tess->env,1);
 	  regUp = RegionAbove( regLo );
 	  eUp = regUp->eUp;
 	}
@@ -837,7 +840,7 @@ static void WalkDirtyRegions( struct GLUtesselator *tess, ActiveRegion *regUp )
       /* A degenerate loop consisting of only two edges -- delete it. */
       AddWinding( eLo, eUp );
       DeleteRegion( tess, regUp );
-      if ( !__gl_meshDelete( eUp ) ) longjmp(tess->env,1);
+      if ( !__gl_meshDelete( tess->mesh, eUp ) ) longjmp(tess->env,1);
       regUp = RegionAbove( regLo );
     }
   }
@@ -893,15 +896,15 @@ static void ConnectRightVertex( struct GLUtesselator *tess, ActiveRegion *regUp,
    * through vEvent, or may coincide with new intersection vertex
    */
   if( VertEq( eUp->Org, tess->event )) {
-    if ( !__gl_meshSplice( eTopLeft->Oprev, eUp ) ) longjmp(tess->env,1);
-    regUp = TopLeftRegion( regUp );
+    if ( !__gl_meshSplice( tess->mesh, eTopLeft->Oprev, eUp ) ) longjmp(tess->env,1);
+    regUp = TopLeftRegion( tess, regUp );
     if (regUp == NULL) longjmp(tess->env,1);
     eTopLeft = RegionBelow( regUp )->eUp;
     FinishLeftRegions( tess, RegionBelow(regUp), regLo );
     degenerate = TRUE;
   }
   if( VertEq( eLo->Org, tess->event )) {
-    if ( !__gl_meshSplice( eBottomLeft, eLo->Oprev ) ) longjmp(tess->env,1);
+    if ( !__gl_meshSplice( tess->mesh, eBottomLeft, eLo->Oprev ) ) longjmp(tess->env,1);
     eBottomLeft = FinishLeftRegions( tess, regLo, NULL );
     degenerate = TRUE;
   }
@@ -918,7 +921,7 @@ static void ConnectRightVertex( struct GLUtesselator *tess, ActiveRegion *regUp,
   } else {
     eNew = eUp;
   }
-  eNew = __gl_meshConnect( eBottomLeft->Lprev, eNew );
+  eNew = __gl_meshConnect( tess->mesh, eBottomLeft->Lprev, eNew );
   if (eNew == NULL) longjmp(tess->env,1);
 
   /* Prevent cleanup, otherwise eNew might disappear before we've even
@@ -961,13 +964,13 @@ static void ConnectLeftDegenerate( struct GLUtesselator *tess,
   
   if( ! VertEq( e->Dst, vEvent )) {
     /* General case -- splice vEvent into edge e which passes through it */
-    if (__gl_meshSplitEdge( e->Sym ) == NULL) longjmp(tess->env,1);
+    if (__gl_meshSplitEdge( tess->mesh, e->Sym ) == NULL) longjmp(tess->env,1);
     if( regUp->fixUpperEdge ) {
       /* This edge was fixable -- delete unused portion of original edge */
-      if ( !__gl_meshDelete( e->Onext ) ) longjmp(tess->env,1);
+      if ( !__gl_meshDelete( tess->mesh, e->Onext ) ) longjmp(tess->env,1);
       regUp->fixUpperEdge = FALSE;
     }
-    if ( !__gl_meshSplice( vEvent->anEdge, e ) ) longjmp(tess->env,1);
+    if ( !__gl_meshSplice( tess->mesh, vEvent->anEdge, e ) ) longjmp(tess->env,1);
     SweepEvent( tess, vEvent );	/* recurse */
     return;
   }
@@ -986,10 +989,10 @@ static void ConnectLeftDegenerate( struct GLUtesselator *tess,
      */
     assert( eTopLeft != eTopRight );   /* there are some left edges too */
     DeleteRegion( tess, reg );
-    if ( !__gl_meshDelete( eTopRight ) ) longjmp(tess->env,1);
+    if ( !__gl_meshDelete( tess->mesh, eTopRight ) ) longjmp(tess->env,1);
     eTopRight = eTopLeft->Oprev;
   }
-  if ( !__gl_meshSplice( vEvent->anEdge, eTopRight ) ) longjmp(tess->env,1);
+  if ( !__gl_meshSplice( tess->mesh, vEvent->anEdge, eTopRight ) ) longjmp(tess->env,1);
   if( ! EdgeGoesLeft( eTopLeft )) {
     /* e->Dst had no left-going edges -- indicate this to AddRightEdges() */
     eTopLeft = NULL;
@@ -1042,16 +1045,16 @@ static void ConnectLeftVertex( struct GLUtesselator *tess, GLUvertex *vEvent )
 
   if( regUp->inside || reg->fixUpperEdge) {
     if( reg == regUp ) {
-      eNew = __gl_meshConnect( vEvent->anEdge->Sym, eUp->Lnext );
+      eNew = __gl_meshConnect( tess->mesh, vEvent->anEdge->Sym, eUp->Lnext );
       if (eNew == NULL) longjmp(tess->env,1);
     } else {
-      GLUhalfEdge *tempHalfEdge= __gl_meshConnect( eLo->Dnext, vEvent->anEdge);
+      GLUhalfEdge *tempHalfEdge= __gl_meshConnect( tess->mesh, eLo->Dnext, vEvent->anEdge);
       if (tempHalfEdge == NULL) longjmp(tess->env,1);
 
       eNew = tempHalfEdge->Sym;
     }
     if( reg->fixUpperEdge ) {
-      if ( !FixUpperEdge( reg, eNew ) ) longjmp(tess->env,1);
+      if ( !FixUpperEdge( tess, reg, eNew ) ) longjmp(tess->env,1);
     } else {
       ComputeWinding( tess, AddRegionBelow( tess, regUp, eNew ));
     }
@@ -1098,7 +1101,7 @@ static void SweepEvent( struct GLUtesselator *tess, GLUvertex *vEvent )
    * to their winding number, and delete the edges from the dictionary.
    * This takes care of all the left-going edges from vEvent.
    */
-  regUp = TopLeftRegion( e->activeRegion );
+  regUp = TopLeftRegion( tess, e->activeRegion );
   if (regUp == NULL) longjmp(tess->env,1);
   reg = RegionBelow( regUp );
   eTopLeft = reg->eUp;
@@ -1132,7 +1135,8 @@ static void AddSentinel( struct GLUtesselator *tess, GLdouble t )
  */
 {
   GLUhalfEdge *e;
-  ActiveRegion *reg = (ActiveRegion *)memAlloc( sizeof( ActiveRegion ));
+  ActiveRegion *reg = (ActiveRegion *)memAlloc( &tess->memory,
+						sizeof( ActiveRegion ));
   if (reg == NULL) longjmp(tess->env,1);
 
   e = __gl_meshMakeEdge( tess->mesh );
@@ -1162,7 +1166,8 @@ static void InitEdgeDict( struct GLUtesselator *tess )
  */
 {
   /* __gl_dictListNewDict */
-  tess->dict = dictNewDict( tess, (int (*)(void *, DictKey, DictKey)) EdgeLeq );
+  tess->dict = dictNewDict( &tess->memory, tess,
+			   (int (*)(void *, DictKey, DictKey)) EdgeLeq );
   if (tess->dict == NULL) longjmp(tess->env,1);
 
   AddSentinel( tess, -SENTINEL_COORD );
@@ -1188,7 +1193,7 @@ static void DoneEdgeDict( struct GLUtesselator *tess )
     }
     assert( reg->windingNumber == 0 );
     DeleteRegion( tess, reg );
-/*    __gl_meshDelete( reg->eUp );*/
+/*    __gl_meshDelete( tess->mesh, reg->eUp );*/
   }
   dictDeleteDict( tess->dict );	/* __gl_dictListDeleteDict */
 }
@@ -1211,7 +1216,7 @@ static void RemoveDegenerateEdges( struct GLUtesselator *tess )
       /* Zero-length edge, contour has at least 3 edges */
       
       SpliceMergeVertices( tess, eLnext, e );	/* deletes e->Org */
-      if ( !__gl_meshDelete( e ) ) longjmp(tess->env,1); /* e is a self-loop */
+      if ( !__gl_meshDelete( tess->mesh, e ) ) longjmp(tess->env,1); /* e is a self-loop */
       e = eLnext;
       eLnext = e->Lnext;
     }
@@ -1220,10 +1225,10 @@ static void RemoveDegenerateEdges( struct GLUtesselator *tess )
       
       if( eLnext != e ) {
 	if( eLnext == eNext || eLnext == eNext->Sym ) { eNext = eNext->next; }
-	if ( !__gl_meshDelete( eLnext ) ) longjmp(tess->env,1);
+	if ( !__gl_meshDelete( tess->mesh, eLnext ) ) longjmp(tess->env,1);
       }
       if( e == eNext || e == eNext->Sym ) { eNext = eNext->next; }
-      if ( !__gl_meshDelete( e ) ) longjmp(tess->env,1);
+      if ( !__gl_meshDelete( tess->mesh, e ) ) longjmp(tess->env,1);
     }
   }
 }
@@ -1238,7 +1243,8 @@ static int InitPriorityQ( struct GLUtesselator *tess )
   GLUvertex *v, *vHead;
 
   /* __gl_pqSortNewPriorityQ */
-  pq = tess->pq = pqNewPriorityQ( (int (*)(PQkey, PQkey)) __gl_vertLeq );
+  pq = tess->pq = pqNewPriorityQ( &tess->memory,
+				     (int (*)(PQkey, PQkey)) __gl_vertLeq );
   if (pq == NULL) return 0;
 
   vHead = &tess->mesh->vHead;
@@ -1290,7 +1296,7 @@ static int RemoveDegenerateFaces( GLUmesh *mesh )
     if( e->Lnext->Lnext == e ) {
       /* A face with only two edges */
       AddWinding( e->Onext, e );
-      if ( !__gl_meshDelete( e ) ) return 0;
+      if ( !__gl_meshDelete( mesh, e ) ) return 0;
     }
   }
   return 1;
@@ -75,6 +75,10 @@
 /*ARGSUSED*/ void GLAPIENTRY __gl_noVertexData( void *data,
 					      void *polygonData ) {}
 /*ARGSUSED*/ void GLAPIENTRY __gl_noEndData( void *polygonData ) {}
+/*ARGSUSED*/ void GLAPIENTRY __gl_noTrianglesData( int count,
+						 void **vertexData,
+						 GLboolean *boundaryEdge,
+						 void *polygonData ) {}
 /*ARGSUSED*/ void GLAPIENTRY __gl_noErrorData( GLenum errnum,
 					     void *polygonData ) {}
 /*ARGSUSED*/ void GLAPIENTRY __gl_noCombineData( GLdouble coords[3],
@@ -87,13 +91,6 @@ void GLAPIENTRY gluTessBeginPolygon( GLUtesselator *tess, void *data );
 void GLAPIENTRY gluTessBeginContour( GLUtesselator *tess );
 void GLAPIENTRY gluTessEndContour( GLUtesselator *tess );
 
-/* Half-edges are allocated in pairs (see mesh.c) */
-typedef struct { GLUhalfEdge e, eSym; } EdgePair;
-
-#define MAX(a,b)	((a) > (b) ? (a) : (b))
-#define MAX_FAST_ALLOC	(MAX(sizeof(EdgePair), \
-			 MAX(sizeof(GLUvertex),sizeof(GLUface))))
-
 
 GLUtesselator * GLAPIENTRY
 gluNewTess( void )
@@ -104,15 +101,25 @@ gluNewTess( void )
    * are initialized where they are used.
    */
 
-  if (memInit( MAX_FAST_ALLOC ) == 0) {
-     return 0;			/* out of memory */
-  }
-  tess = (GLUtesselator *)memAlloc( sizeof( GLUtesselator ));
+  /* The tessellator itself comes from malloc; everything else goes
+   * through its allocation hooks (see gluTessAllocator).
+   */
+  tess = (GLUtesselator *)malloc( sizeof( GLUtesselator ));
   if (tess == NULL) {
      return 0;			/* out of memory */
   }
+  __gl_memInit( &tess->memory );
+  __gl_meshInitPools( &tess->meshPools );
 
   tess->state = T_DORMANT;
+  tess->mesh = NULL;
+  tess->cacheSize = 0;
+  tess->cache = NULL;
+  tess->cacheTried = 0;
+  tess->cacheRendered = 0;
+  tess->triSize = 0;
+  tess->triVertices = NULL;
+  tess->triBoundary = NULL;
 
   tess->normal[0] = 0;
   tess->normal[1] = 0;
@@ -138,6 +145,7 @@ gluNewTess( void )
   tess->callEndData= &__gl_noEndData;
   tess->callErrorData= &__gl_noErrorData;
   tess->callCombineData= &__gl_noCombineData;
+  tess->callTrianglesData= &__gl_noTrianglesData;
 
   tess->polygonData= NULL;
 
@@ -192,11 +200,44 @@ static void GotoState( GLUtesselator *tess, enum TessState newState )
 }
 
 
+static void FreeStorage( GLUtesselator *tess )
+{
+  /* Free the storage kept from one polygon to the next. */
+
+  __gl_meshDeletePools( &tess->memory, &tess->meshPools );
+  if (tess->cache != NULL) memFree( &tess->memory, tess->cache );
+  if (tess->triVertices != NULL) memFree( &tess->memory, tess->triVertices );
+  if (tess->triBoundary != NULL) memFree( &tess->memory, tess->triBoundary );
+  tess->cache = NULL;
+  tess->cacheSize = 0;
+  tess->triVertices = NULL;
+  tess->triBoundary = NULL;
+  tess->triSize = 0;
+}
+
+
 void GLAPIENTRY
 gluDeleteTess( GLUtesselator *tess )
 {
   RequireState( tess, T_DORMANT );
-  memFree( tess );
+  FreeStorage( tess );
+  free( tess );
+}
+
+
+void GLAPIENTRY
+gluTessAllocator( GLUtesselator *tess, GLUallocFunc allocFunc,
+		  GLUreallocFunc reallocFunc, GLUfreeFunc freeFunc,
+		  void *userData )
+{
+  /* Whatever was allocated with the previous hooks must be freed first. */
+  RequireState( tess, T_DORMANT );
+  FreeStorage( tess );
+
+  tess->memory.alloc = allocFunc;
+  tess->memory.realloc = reallocFunc;
+  tess->memory.free = freeFunc;
+  tess->memory.data = userData;
 }
 
 
@@ -260,6 +301,12 @@ gluGetTessProperty( GLUtesselator *tess, GLenum which, GLdouble *value )
       assert(tess->boundaryOnly == TRUE || tess->boundaryOnly == FALSE);
       *value= tess->boundaryOnly;
       break;
+   case GLU_TESS_FAN_TRIED:
+      *value= tess->cacheTried;
+      break;
+   case GLU_TESS_FAN_RENDERED:
+      *value= tess->cacheRendered;
+      break;
    default:
       *value= 0.0;
       CALL_ERROR_OR_ERROR_DATA( GLU_INVALID_ENUM );
@@ -336,6 +383,11 @@ gluTessCallback( GLUtesselator *tess, GLenum which, void (GLAPIENTRY *fn)())
 						     void **,
 						     void *)) fn;
     return;
+  case GLU_TESS_TRIANGLES_DATA:
+    tess->callTrianglesData = (fn == NULL) ? &__gl_noTrianglesData :
+			       (void (GLAPIENTRY *)(int, void **, GLboolean *,
+						    void *)) fn;
+    return;
   case GLU_TESS_MESH:
     tess->callMesh = (fn == NULL) ? &noMesh : (void (GLAPIENTRY *)(GLUmesh *)) fn;
     return;
@@ -355,12 +407,12 @@ static int AddVertex( GLUtesselator *tess, GLdouble coords[3], void *data )
 
     e = __gl_meshMakeEdge( tess->mesh );
     if (e == NULL) return 0;
-    if ( !__gl_meshSplice( e, e->Sym ) ) return 0;
+    if ( !__gl_meshSplice( tess->mesh, e, e->Sym ) ) return 0;
   } else {
     /* Create a new vertex and edge which immediately follow e
      * in the ordering around the left face.
      */
-    if (__gl_meshSplitEdge( e ) == NULL) return 0;
+    if (__gl_meshSplitEdge( tess->mesh, e ) == NULL) return 0;
     e = e->Lnext;
   }
 
@@ -384,15 +436,28 @@ static int AddVertex( GLUtesselator *tess, GLdouble coords[3], void *data )
 }
 
 
-static void CacheVertex( GLUtesselator *tess, GLdouble coords[3], void *data )
+static int CacheVertex( GLUtesselator *tess, GLdouble coords[3], void *data )
 {
-  CachedVertex *v = &tess->cache[tess->cacheCount];
-
+  CachedVertex *v;
+
+  if( tess->cacheCount == tess->cacheSize ) {
+    /* Grow the cache; if that fails, the caller falls back to the mesh. */
+    int size = (tess->cacheSize == 0) ? TESS_INIT_CACHE : 2 * tess->cacheSize;
+    size_t bytes = size * sizeof( CachedVertex );
+    CachedVertex *cache = (CachedVertex *)((tess->cache == NULL)
+			  ? memAlloc( &tess->memory, bytes )
+			  : memRealloc( &tess->memory, tess->cache, bytes ));
+    if (cache == NULL) return 0;
+    tess->cache = cache;
+    tess->cacheSize = size;
+  }
+  v = &tess->cache[tess->cacheCount];
   v->data = data;
   v->coords[0] = coords[0];
   v->coords[1] = coords[1];
   v->coords[2] = coords[2];
   ++tess->cacheCount;
+  return 1;
 }
 
 
@@ -401,7 +466,7 @@ static int EmptyCache( GLUtesselator *tess )
   CachedVertex *v = tess->cache;
   CachedVertex *vLast;
 
-  tess->mesh = __gl_meshNewMesh();
+  tess->mesh = __gl_meshNewMesh( &tess->memory, &tess->meshPools );
   if (tess->mesh == NULL) return 0;
 
   for( vLast = v + tess->cacheCount; v < vLast; ++v ) {
@@ -446,8 +511,7 @@ gluTessVertex( GLUtesselator *tess, GLdouble coords[3], void *data )
   }
 
   if( tess->mesh == NULL ) {
-    if( tess->cacheCount < TESS_MAX_CACHE ) {
-      CacheVertex( tess, clamped, data );
+    if( CacheVertex( tess, clamped, data )) {
       return;
     }
     if ( !EmptyCache( tess ) ) {
@@ -514,14 +578,16 @@ gluTessEndPolygon( GLUtesselator *tess )
   tess->state = T_DORMANT;
 
   if( tess->mesh == NULL ) {
-    if( ! tess->flagBoundary && tess->callMesh == &noMesh ) {
+    if( tess->callMesh == &noMesh ) {
 
       /* Try some special code to make the easy cases go quickly
-       * (eg. convex polygons).  This code does NOT handle multiple contours,
-       * intersections, edge flags, and of course it does not generate
-       * an explicit mesh either.
+       * (eg. convex polygons).  This code does NOT handle multiple contours
+       * or intersections, and of course it does not generate an explicit
+       * mesh either.
        */
+      ++tess->cacheTried;
       if( __gl_renderCache( tess )) {
+	++tess->cacheRendered;
 	tess->polygonData= NULL; 
 	return;
       }
@@ -561,7 +627,10 @@ gluTessEndPolygon( GLUtesselator *tess )
 
     __gl_meshCheckMesh( mesh );
 
-    if( tess->callBegin != &noBegin || tess->callEnd != &noEnd
+    if( tess->callTrianglesData != &__gl_noTrianglesData
+       && ! tess->boundaryOnly ) {
+      __gl_renderTriangles( tess, mesh );	/* output a triangle list */
+    } else if( tess->callBegin != &noBegin || tess->callEnd != &noEnd
        || tess->callVertex != &noVertex || tess->callEdgeFlag != &noEdgeFlag 
        || tess->callBeginData != &__gl_noBeginData 
        || tess->callEndData != &__gl_noEndData
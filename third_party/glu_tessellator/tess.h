@@ -54,9 +54,11 @@
 enum TessState { T_DORMANT, T_IN_POLYGON, T_IN_CONTOUR };
 
 /* We cache vertex data for single-contour polygons so that we can
- * try a quick-and-dirty decomposition first.
+ * try a quick-and-dirty decomposition first.  The cache starts with room
+ * for TESS_INIT_CACHE vertices and doubles in size as needed, so that
+ * contours of any length can take the quick path.
  */
-#define TESS_MAX_CACHE	100
+#define TESS_INIT_CACHE	128
 
 typedef struct CachedVertex {
   GLdouble	coords[3];
@@ -112,7 +114,16 @@ struct GLUtesselator {
 
   GLboolean	emptyCache;		/* empty cache on next vertex() call */
   int		cacheCount;		/* number of cached vertices */
-  CachedVertex	cache[TESS_MAX_CACHE];	/* the vertex data */
+  int		cacheSize;		/* room in cache, kept between polygons */
+  CachedVertex	*cache;			/* the vertex data */
+  long		cacheTried;		/* polygons given to renderCache() */
+  long		cacheRendered;		/* ...and rendered by it */
+
+  /*** output of the triangle list callback (see render.c) ***/
+
+  int		triSize;	/* room in the arrays below, in triangles */
+  void		**triVertices;	/* vertex data of the triangle corners */
+  GLboolean	*triBoundary;	/* is the edge from each corner a boundary? */
 
   /*** rendering callbacks that also pass polygon data  ***/ 
   void		(GLAPIENTRY *callBeginData)( GLenum type, void *polygonData );
@@ -124,9 +135,15 @@ struct GLUtesselator {
   void		(GLAPIENTRY *callCombineData)( GLdouble coords[3], void *data[4],
 				    GLfloat weight[4], void **outData,
 				    void *polygonData );
+  void		(GLAPIENTRY *callTrianglesData)( int count, void **vertexData,
+				    GLboolean *boundaryEdge,
+				    void *polygonData );
 
   jmp_buf env;			/* place to jump to when memAllocs fail */
 
+  GLUmemory memory;		/* allocation hooks (see memalloc.h) */
+  GLUmeshPools meshPools;	/* storage for the mesh, kept between polygons */
+
   void *polygonData;		/* client data for current polygon */
 };
 
@@ -138,6 +155,8 @@ void GLAPIENTRY __gl_noErrorData( GLenum errnum, void *polygonData );
 void GLAPIENTRY __gl_noCombineData( GLdouble coords[3], void *data[4],
 			 GLfloat weight[4], void **outData,
 			 void *polygonData );
+void GLAPIENTRY __gl_noTrianglesData( int count, void **vertexData,
+			 GLboolean *boundaryEdge, void *polygonData );
 
 #define CALL_BEGIN_OR_BEGIN_DATA(a) \
    if (tess->callBeginData != &__gl_noBeginData) \
@@ -164,6 +183,10 @@ void GLAPIENTRY __gl_noCombineData( GLdouble coords[3], void *data[4],
       (*tess->callCombineData)((a),(b),(c),(d),tess->polygonData); \
    else (*tess->callCombine)((a),(b),(c),(d));
 
+#define CALL_TRIANGLES_DATA(a) \
+   (*tess->callTrianglesData)((a),tess->triVertices,tess->triBoundary, \
+			      tess->polygonData);
+
 #define CALL_ERROR_OR_ERROR_DATA(a) \
    if (tess->callErrorData != &__gl_noErrorData) \
       (*tess->callErrorData)((a),tess->polygonData); \
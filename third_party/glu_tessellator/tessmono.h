@@ -42,7 +42,7 @@
 #ifndef __tessmono_h_
 #define __tessmono_h_
 
-/* __gl_meshTessellateMonoRegion( face ) tessellates a monotone region
+/* __gl_meshTessellateMonoRegion( mesh, face ) tessellates a monotone region
  * (what else would it do??)  The region must consist of a single
  * loop of half-edges (see mesh.h) oriented CCW.  "Monotone" in this
  * case means that any vertical line intersects the interior of the
@@ -69,7 +69,7 @@
  * separate an interior region from an exterior one.
  */
 
-int __gl_meshTessellateMonoRegion( GLUface *face );
+int __gl_meshTessellateMonoRegion( GLUmesh *mesh, GLUface *face );
 int __gl_meshTessellateInterior( GLUmesh *mesh );
 void __gl_meshDiscardExterior( GLUmesh *mesh );
 int __gl_meshSetWindingNumber( GLUmesh *mesh, int value,
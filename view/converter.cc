@@ -4,8 +4,6 @@
 
 #include "view/converter.h"
 
-#include <string.h>
-
 #include "model/component.h"
 #include "osg/Geometry"
 
@@ -14,6 +12,73 @@ enum AttribIndex {
   kAttribIndexVertex,
   kAttribIndexNormal,
 };
+
+// The tessellator hands over triangles in groups of facets of about this many
+// vertices. All groups end up in the same primitive set.
+const size_t kMaxBatchVertices = 16384;
+
+// Append the content of buffer, three floats per vertex, to array.
+void AppendVec3s(const std::vector<float>& buffer, osg::Vec3Array* array) {
+  if (buffer.empty())
+    return;
+  const osg::Vec3* begin = reinterpret_cast<const osg::Vec3*>(&buffer[0]);
+  array->insert(array->end(), begin, begin + buffer.size() / 3);
+}
+
+// Return the Vec3Array bound to the given vertex attribute of geom, emptied,
+// or a new array if there is none. Reusing the array keeps its vertex buffer
+// object alive, so that new data is uploaded to the same buffer.
+osg::Vec3Array* ReuseVec3Array(osg::Geometry* geom, unsigned int index,
+                               const char* name) {
+  osg::Vec3Array* array =
+      dynamic_cast<osg::Vec3Array*>(geom->getVertexAttribArray(index));
+  if (array != NULL) {
+    array->clear();
+  } else {
+    array = new osg::Vec3Array;
+    array->setName(name);
+  }
+  return array;
+}
+
+// Return the primitive set of geom, emptied, or a new one if there is none.
+osg::DrawElementsUInt* ReuseDrawElements(osg::Geometry* geom, GLenum mode) {
+  if (geom->getNumPrimitiveSets() > 0) {
+    osg::DrawElementsUInt* elements =
+        dynamic_cast<osg::DrawElementsUInt*>(geom->getPrimitiveSet(0));
+    if (elements != NULL && elements->getMode() == mode) {
+      elements->clear();
+      return elements;
+    }
+    geom->removePrimitiveSet(0, geom->getNumPrimitiveSets());
+  }
+  return new osg::DrawElementsUInt(mode);
+}
+
+// Make elements the only primitive set of geom, or leave geom with no
+// primitive set at all if elements is empty.
+void SetDrawElements(osg::Geometry* geom, osg::DrawElementsUInt* elements) {
+  bool attached = (geom->getNumPrimitiveSets() > 0);
+  if (elements->empty()) {
+    if (attached)
+      geom->removePrimitiveSet(0);
+  } else {
+    elements->dirty();
+    if (!attached)
+      geom->addPrimitiveSet(elements);
+  }
+  geom->dirtyBound();
+}
+
+// Append indices to elements, offsetting each index by base_index.
+void AppendIndices(const std::vector<unsigned int>& indices,
+                   unsigned int base_index,
+                   osg::DrawElementsUInt* elements) {
+  elements->reserve(elements->size() + indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    elements->push_back(base_index + indices[i]);
+  }
+}
 }  // namespace
 
 namespace ginsu {
@@ -23,105 +88,86 @@ Converter::Converter(osg::Geometry* face_geom,
                      osg::Geometry* edge_geom)
     : face_geom_(face_geom),
       edge_geom_(edge_geom) {
-  memset(&face_data_, 0, sizeof(face_data_));
-  memset(&edge_data_, 0, sizeof(edge_data_));
+  EnableBatchedOutput(kMaxBatchVertices);
+  EnableSharedVertices();
 }
 
 void Converter::Convert(const ginsu::model::Component& component) {
+  Convert(component, 0);
+}
+
+void Converter::Convert(const ginsu::model::Component& component,
+                        int subdivision_level) {
+  BeginConversion();
+  // Tesselate component faces and collect all vertices into vertex_array_,
+  // and all triangles and edges into a single primitive set each.
+  Tessellate(component, subdivision_level);
+  EndConversion();
+}
+
+void Converter::ConvertTriangles(
+    const model::Tessellator::TriangleBuffer& buffer) {
+  BeginConversion();
+  AddTriangleBuffer(buffer);
+  EndConversion();
+}
+
+void Converter::BeginConversion() {
   // At least one of them should be non-null.
   assert((face_geom_ != NULL) || (edge_geom_ != NULL));
 
+  // When converting into geometries that already hold a previous conversion,
+  // refill their arrays and primitive sets rather than replacing them.
+  vertex_array_ = ReuseVec3Array(
+      (face_geom_ != NULL) ? face_geom_ : edge_geom_,
+      kAttribIndexVertex, "osg_Vertex");
   if (face_geom_ != NULL) {
-    face_data_.vertex_array_ = new osg::Vec3Array;
-    face_data_.vertex_array_->setName("osg_Vertex");
-    face_data_.normal_array_ = new osg::Vec3Array;
-    face_data_.normal_array_->setName("osg_Normal");
-  }
-  if (edge_geom_ != NULL) {
-    edge_data_.vertex_array_ = new osg::Vec3Array;
-    edge_data_.vertex_array_->setName("osg_Vertex");
+    normal_array_ = ReuseVec3Array(face_geom_, kAttribIndexNormal,
+                                   "osg_Normal");
+    face_elements_ = ReuseDrawElements(face_geom_, GL_TRIANGLES);
   }
+  if (edge_geom_ != NULL)
+    edge_elements_ = ReuseDrawElements(edge_geom_, GL_LINES);
+}
 
-  // Tesselate component faces and collect all vertices into vertex_array_.
-  Tessellate(component);
+void Converter::EndConversion() {
+  vertex_array_->dirty();
 
   if (face_geom_ != NULL) {
+    normal_array_->dirty();
     face_geom_->setUseDisplayList(false);
     face_geom_->setUseVertexBufferObjects(true);
-    face_geom_->setVertexAttribArray(kAttribIndexVertex,
-        face_data_.vertex_array_);
+    face_geom_->setVertexAttribArray(kAttribIndexVertex, vertex_array_);
     face_geom_->setVertexAttribBinding(kAttribIndexVertex,
         osg::Geometry::BIND_PER_VERTEX);
-    face_geom_->setVertexAttribArray(kAttribIndexNormal,
-        face_data_.normal_array_);
+    face_geom_->setVertexAttribArray(kAttribIndexNormal, normal_array_);
     face_geom_->setVertexAttribNormalize(kAttribIndexNormal, true);
     face_geom_->setVertexAttribBinding(kAttribIndexNormal,
         osg::Geometry::BIND_PER_VERTEX);
+    SetDrawElements(face_geom_, face_elements_.get());
   }
   if (edge_geom_ != NULL) {
     edge_geom_->setUseDisplayList(false);
     edge_geom_->setUseVertexBufferObjects(true);
-    edge_geom_->setVertexAttribArray(kAttribIndexVertex,
-        edge_data_.vertex_array_);
+    edge_geom_->setVertexAttribArray(kAttribIndexVertex, vertex_array_);
     edge_geom_->setVertexAttribBinding(kAttribIndexVertex,
         osg::Geometry::BIND_PER_VERTEX);
-    edge_geom_->addPrimitiveSet(
-        new osg::DrawArrays(GL_LINES, 0, edge_data_.vertex_array_->size()));
+    SetDrawElements(edge_geom_, edge_elements_.get());
   }
+  face_elements_ = NULL;
+  edge_elements_ = NULL;
 }
 
-void Converter::BeginTriangleData(const TriangleData& tri_data) {
-  if (face_geom_ == NULL)
-    return;
+void Converter::AddTriangleBuffer(const TriangleBuffer& buffer) {
+  unsigned int base_index = static_cast<unsigned int>(vertex_array_->size());
+  AppendVec3s(buffer.positions, vertex_array_.get());
 
-  face_data_.normal_.set(tri_data.normal_x,
-                         tri_data.normal_y,
-                         tri_data.normal_z);
-
-  GLenum mode = 0;
-  switch (tri_data.flavor) {
-    case kTriangles:
-      mode = GL_TRIANGLES;
-      break;
-    case kTriangleStrip:
-      mode = GL_TRIANGLE_STRIP;
-      break;
-    case kTriangleFan:
-      mode = GL_TRIANGLE_FAN;
-      break;
-    default:
-      assert(false);
-  }
-  face_data_.primitive_set_ = new osg::DrawArrays(mode);
-  face_data_.primitive_set_->setFirst(face_data_.vertex_array_->size());
-}
-
-void Converter::AddVertex(const Vertex& vertex) {
   if (face_geom_ != NULL) {
-    face_data_.normal_array_->push_back(face_data_.normal_);
-    face_data_.vertex_array_->push_back(
-        osg::Vec3(vertex.x, vertex.y, vertex.z));
-  }
-  if ((edge_geom_ != NULL) && edge_data_.edge_flag_) {
-    edge_data_.vertex_array_->push_back(
-        osg::Vec3(vertex.x, vertex.y, vertex.z));
+    AppendVec3s(buffer.normals, normal_array_.get());
+    AppendIndices(buffer.triangle_indices, base_index, face_elements_.get());
   }
-}
-
-void Converter::EndTriangleData() {
-  if (face_geom_ == NULL)
-    return;
-
-  GLsizei count = face_data_.vertex_array_->size() -
-      face_data_.primitive_set_->getFirst();
-  if (count > 0) {
-    face_data_.primitive_set_->setCount(count);
-    face_geom_->addPrimitiveSet(face_data_.primitive_set_);
-  }
-}
-
-void Converter::EdgeFlag(bool flag) {
-  edge_data_.edge_flag_ = flag;
+  if (edge_geom_ != NULL)
+    AppendIndices(buffer.edge_indices, base_index, edge_elements_.get());
 }
 
 }  // namespace view
@@ -7,9 +7,9 @@
 
 #include "model/tessellator.h"
 #include "osg/Array"
+#include "osg/PrimitiveSet"
 
 namespace osg {
-class DrawArrays;
 class Geometry;
 }
 
@@ -17,7 +17,10 @@ namespace ginsu {
 namespace view {
 
 // Convert a model Component instance to triangle data for viewing in the
-// scene graph. Usage:
+// scene graph. Each geometry receives a single osg::DrawElementsUInt primitive
+// set: GL_TRIANGLES for faces and GL_LINES for edges. Converting into
+// geometries that were filled by an earlier conversion updates their arrays
+// and primitive sets in place, keeping their buffer objects. Usage:
 //   Converter converter(node_to_receive_triangle_arrays);
 //   converter.Tessellate(component);
 class Converter : protected model::Tessellator {
@@ -25,30 +28,33 @@ class Converter : protected model::Tessellator {
   Converter(osg::Geometry* face_geom, osg::Geometry* edge_geom);
 
   void Convert(const ginsu::model::Component& component);
+  // Convert the component after subdivision_level steps of Catmull-Clark
+  // subdivision.
+  void Convert(const ginsu::model::Component& component,
+               int subdivision_level);
+  // Fill the geometries from an existing tessellation, e.g. one computed by
+  // model::ParallelTessellator.
+  void ConvertTriangles(const model::Tessellator::TriangleBuffer& buffer);
 
  protected:
-  virtual void BeginTriangleData(const TriangleData& tri_data);
-  virtual void AddVertex(const Vertex& vertex);
-  virtual void EndTriangleData();
-  virtual void EdgeFlag(bool flag);
+  virtual void AddTriangleBuffer(const TriangleBuffer& buffer);
 
  private:
+  // Get the arrays and primitive sets ready to receive triangle buffers, and
+  // attach them to the geometries once they are all in.
+  void BeginConversion();
+  void EndConversion();
+
   osg::Geometry* face_geom_;
   osg::Geometry* edge_geom_;
 
-  // Data for constructing face node.
-  struct FaceData {
-    osg::Vec3 normal_;
-    osg::ref_ptr<osg::DrawArrays> primitive_set_;
-    osg::ref_ptr<osg::Vec3Array> vertex_array_;
-    osg::ref_ptr<osg::Vec3Array> normal_array_;
-  } face_data_;
-
-  // Data for constructing edge node.
-  struct EdgeData {
-    bool edge_flag_;
-    osg::ref_ptr<osg::Vec3Array> vertex_array_;
-  } edge_data_;
+  // Vertex positions, shared by the face and edge geometries.
+  osg::ref_ptr<osg::Vec3Array> vertex_array_;
+  // Vertex normals, for the face geometry only.
+  osg::ref_ptr<osg::Vec3Array> normal_array_;
+  // Triangle and edge indices, accumulated over all the tessellator batches.
+  osg::ref_ptr<osg::DrawElementsUInt> face_elements_;
+  osg::ref_ptr<osg::DrawElementsUInt> edge_elements_;
 };
 
 }  // namespace view
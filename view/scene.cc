@@ -4,15 +4,24 @@
 
 #include "view/scene.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "model/component.h"
 #include "model/model.h"
+#include "model/parallel_tessellator.h"
+#include "osg/BoundingBox"
+#include "osg/BoundingSphere"
 #include "osg/Geode"
 #include "osg/Geometry"
+#include "osg/MatrixTransform"
 #include "osg/PolygonOffset"
 #include "view/converter.h"
+#include "view/scene_view.h"
 
 using ginsu::model::Component;
 using ginsu::model::Model;
+using ginsu::model::ParallelTessellator;
 
 namespace {
 osg::Program* BuildFaceShader() {
@@ -59,44 +68,88 @@ osg::Program* BuildEdgeShader() {
   return program;
 }
 
-// Builds a scenegraph node for the given component.
+// Builds an empty scenegraph node for a component, to be filled by
+// a Converter. On return, face_geom and edge_geom refer to the node's face
+// and edge geometries.
 // Faces are added to the node if face_shader is non-null.
 // Edges are added to the node if edge_shader is non-null.
 // At least one of them should be non-null.
-osg::Node* BuildComponentNode(const Component& component,
-                              osg::Program* face_shader,
-                              osg::Program* edge_shader) {
+osg::Geode* BuildComponentNode(osg::Program* face_shader,
+                               osg::Program* edge_shader,
+                               osg::ref_ptr<osg::Geometry>* face_geom,
+                               osg::ref_ptr<osg::Geometry>* edge_geom) {
   assert((face_shader != NULL) || (edge_shader != NULL));
-  osg::ref_ptr<osg::Geometry> face_geom;
+  osg::Geode* geode = new osg::Geode;
+  *face_geom = NULL;
   if (face_shader != NULL) {
-    face_geom = new osg::Geometry;
-    osg::StateSet* state_set = face_geom->getOrCreateStateSet();
+    *face_geom = new osg::Geometry;
+    osg::StateSet* state_set = (*face_geom)->getOrCreateStateSet();
     state_set->setAttribute(face_shader);
     state_set->setAttributeAndModes(new osg::PolygonOffset(1.0f, 1.0f),
         osg::StateAttribute::ON);
+    geode->addDrawable(face_geom->get());
   }
-  osg::ref_ptr<osg::Geometry> edge_geom;
+  *edge_geom = NULL;
   if (edge_shader != NULL) {
-    edge_geom = new osg::Geometry;
-    edge_geom->getOrCreateStateSet()->setAttribute(edge_shader);
+    *edge_geom = new osg::Geometry;
+    (*edge_geom)->getOrCreateStateSet()->setAttribute(edge_shader);
+    geode->addDrawable(edge_geom->get());
   }
+  return geode;
+}
 
-  ginsu::view::Converter converter(face_geom, edge_geom);
-  converter.Convert(component);
+// Largest error, in pixels, allowed between a displayed component and its
+// limit surface when choosing its subdivision level.
+const double kMaxPixelError = 0.5;
 
-  osg::Geode* geode = new osg::Geode;
-  if (face_geom != NULL)
-    geode->addDrawable(face_geom);
-  if (edge_geom != NULL)
-    geode->addDrawable(edge_geom);
-  return geode;
+// Returns the smallest subdivision level of component, up to its
+// max_display_subdivision, whose error is within kMaxPixelError on
+// scene_view. matrix is the component transform. The size of the component
+// on screen comes from its own bounding box, so the level doesn't depend on
+// what its node currently holds.
+int SelectSubdivisionLevel(const Component& component,
+                           const osg::Matrix& matrix,
+                           const ginsu::view::SceneView* scene_view) {
+  int max_level = component.max_display_subdivision();
+  if (max_level <= 0 || scene_view == NULL || component.IsEmpty())
+    return 0;
+  double min[3], max[3];
+  component.GetBoundingBox(min, max);
+  osg::BoundingBox box(min[0], min[1], min[2], max[0], max[1], max[2]);
+  osg::BoundingSphere bound;
+  for (unsigned int corner = 0; corner < 8; ++corner)
+    bound.expandBy(box.corner(corner) * matrix);
+  osg::Vec3d scale = matrix.getScale();
+  double pixels_per_unit =
+      scene_view->GetPixelsPerUnit(bound) *
+      std::max(scale.x(), std::max(scale.y(), scale.z()));
+  for (int level = 0; level < max_level; ++level) {
+    if (component.EstimateSubdivisionError(level) * pixels_per_unit <=
+        kMaxPixelError)
+      return level;
+  }
+  return max_level;
+}
+
+// Returns the number of draw calls needed to render the given geode.
+int CountDrawCalls(const osg::Geode& geode) {
+  int count = 0;
+  for (unsigned int i = 0; i < geode.getNumDrawables(); ++i) {
+    const osg::Geometry* geom = geode.getDrawable(i)->asGeometry();
+    if (geom != NULL)
+      count += geom->getNumPrimitiveSets();
+  }
+  return count;
 }
 }  // namespace
 
 namespace ginsu {
 namespace view {
 
-Scene::Scene(Model* model) : model_(model) {
+Scene::Scene(Model* model)
+    : model_(model),
+      draw_call_count_(0),
+      update_count_(0) {
 }
 
 Scene::~Scene() {
@@ -107,21 +160,109 @@ void Scene::Init() {
   edge_shader_ = BuildEdgeShader();
 
   root_ = new osg::Group;
-  Update();
+  Update(NULL);
 }
 
-void Scene::Update() {
-  // TODO(alokp): Remove this after the demo.
-  // Rebuild the scenegraph every frame.
+void Scene::Update(const SceneView* scene_view) {
+  // Bring the scenegraph in sync with the model: the i-th child of the root
+  // is the transform node of the i-th component, above its geometry node.
+  // Nodes are kept across updates, and only the nodes of components whose
+  // geometry or subdivision level has changed are converted again, in place.
+  // These components are tessellated together, in parallel, once all the
+  // nodes are in place.
   osg::Group* root = root_->asGroup();
-  root->removeChildren(0, root->getNumChildren());
+  draw_call_count_ = 0;
+  ++update_count_;
 
-  int i = 0;
+  // Find the components that have left the model. Their nodes are recycled
+  // for new components, so that their buffer objects can be reused.
+  for (Model::const_iterator iter = model_->begin_component();
+       iter != model_->end_component(); ++iter) {
+    ComponentNodeMap::iterator entry = component_nodes_.find(iter->get());
+    if (entry != component_nodes_.end())
+      entry->second.last_update = update_count_;
+  }
+  std::vector<ComponentNode> spare_nodes;
+  ComponentNodeMap::iterator stale = component_nodes_.begin();
+  while (stale != component_nodes_.end()) {
+    if (stale->second.last_update != update_count_) {
+      spare_nodes.push_back(stale->second);
+      component_nodes_.erase(stale++);
+    } else {
+      ++stale;
+    }
+  }
+
+  ParallelTessellator tessellator;
+  std::vector<ComponentNode*> converted_nodes;
+  unsigned int i = 0;
   for (Model::const_iterator iter = model_->begin_component();
        iter != model_->end_component(); ++iter, ++i) {
-    osg::Node* node = BuildComponentNode(*(iter->get()),
-      (i < 1) ? NULL : face_shader_, edge_shader_);
-    root->addChild(node);
+    const Component* component = iter->get();
+    // TODO(alokp): Remove this after the demo.
+    // The first component is drawn with edges only.
+    osg::Program* face_shader = (i < 1) ? NULL : face_shader_.get();
+    bool has_faces = (face_shader != NULL);
+
+    ComponentNode& entry = component_nodes_[component];
+    if (entry.node == NULL) {
+      // A new component; recycle a spare node if one fits.
+      for (size_t j = 0; j < spare_nodes.size(); ++j) {
+        if ((spare_nodes[j].face_geom != NULL) == has_faces) {
+          entry = spare_nodes[j];
+          spare_nodes.erase(spare_nodes.begin() + j);
+          entry.geometry_revision = 0;
+          break;
+        }
+      }
+    }
+    if (entry.node == NULL || (entry.face_geom != NULL) != has_faces) {
+      entry.node = BuildComponentNode(face_shader, edge_shader_,
+                                      &entry.face_geom, &entry.edge_geom);
+      entry.geometry_revision = 0;
+      if (entry.transform == NULL)
+        entry.transform = new osg::MatrixTransform;
+      entry.transform->removeChildren(0, entry.transform->getNumChildren());
+      entry.transform->addChild(entry.node.get());
+    }
+    // The component transform is applied by the scenegraph; changing it
+    // doesn't touch the geometry. It is set first, so that the subdivision
+    // level is chosen for where the component is shown this frame.
+    float transform[16];
+    component->GetTransformMatrix44(transform);
+    osg::Matrixf matrix(transform);
+    if (matrix != osg::Matrixf(entry.transform->getMatrix()))
+      entry.transform->setMatrix(matrix);
+    int subdivision_level = SelectSubdivisionLevel(
+        *component, entry.transform->getMatrix(), scene_view);
+    if (entry.geometry_revision != component->geometry_revision() ||
+        entry.subdivision_level != subdivision_level) {
+      tessellator.AddComponent(*component, subdivision_level);
+      converted_nodes.push_back(&entry);
+      entry.geometry_revision = component->geometry_revision();
+      entry.subdivision_level = subdivision_level;
+    }
+    entry.last_update = update_count_;
+
+    if (i < root->getNumChildren()) {
+      if (root->getChild(i) != entry.transform.get())
+        root->setChild(i, entry.transform.get());
+    } else {
+      root->addChild(entry.transform.get());
+    }
+  }
+  if (root->getNumChildren() > i)
+    root->removeChildren(i, root->getNumChildren() - i);
+
+  tessellator.Run();
+  for (size_t j = 0; j < converted_nodes.size(); ++j) {
+    ComponentNode* entry = converted_nodes[j];
+    Converter converter(entry->face_geom.get(), entry->edge_geom.get());
+    converter.ConvertTriangles(tessellator.result(j));
+  }
+  for (ComponentNodeMap::const_iterator entry = component_nodes_.begin();
+       entry != component_nodes_.end(); ++entry) {
+    draw_call_count_ += CountDrawCalls(*entry->second.node);
   }
 }
 
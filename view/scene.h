@@ -5,10 +5,15 @@
 #ifndef GINSU_VIEW_SCENE_H_
 #define GINSU_VIEW_SCENE_H_
 
+#include <map>
+
 #include "osg/BoundingSphere"
 #include "osg/ref_ptr"
 
 namespace osg {
+class Geode;
+class Geometry;
+class MatrixTransform;
 class Node;
 class Program;
 }
@@ -16,27 +21,55 @@ class Program;
 namespace ginsu {
 
 namespace model {
+class Component;
 class Model;
 }  // namespace model
 
 namespace view {
 
+class SceneView;
+
 class Scene {
  public:
   Scene(model::Model* model);
   ~Scene();
 
   void Init();
-  void Update();
+  // Bring the scene graph in sync with the model. Components are displayed
+  // at the subdivision level that their size in scene_view calls for, up to
+  // their max_display_subdivision; if scene_view is NULL, they are displayed
+  // unsubdivided.
+  void Update(const SceneView* scene_view);
 
   osg::Node* root() const { return root_.get(); }
   const osg::BoundingSphere& GetBound() const;
+  // Number of primitive sets, hence of draw calls, in the scene graph as of
+  // the last call to Update.
+  int draw_call_count() const { return draw_call_count_; }
 
  private:
   model::Model* model_;
   osg::ref_ptr<osg::Node> root_;
   osg::ref_ptr<osg::Program> face_shader_;
   osg::ref_ptr<osg::Program> edge_shader_;
+  int draw_call_count_;
+
+  // Scene-graph nodes of the components, kept across updates. A node's
+  // geometries are converted again only when its component's geometry
+  // revision or its displayed subdivision level changes.
+  struct ComponentNode {
+    unsigned int geometry_revision;
+    int subdivision_level;
+    osg::ref_ptr<osg::MatrixTransform> transform;
+    osg::ref_ptr<osg::Geode> node;
+    osg::ref_ptr<osg::Geometry> face_geom;  // NULL if edges only.
+    osg::ref_ptr<osg::Geometry> edge_geom;
+    // Value of update_count_ when the component was last seen.
+    unsigned int last_update;
+  };
+  typedef std::map<const model::Component*, ComponentNode> ComponentNodeMap;
+  ComponentNodeMap component_nodes_;
+  unsigned int update_count_;
 };
 
 }  // namespace view
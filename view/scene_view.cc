@@ -4,6 +4,8 @@
 
 #include "view/scene_view.h"
 
+#include <algorithm>
+
 #include "osgUtil/SceneView"
 
 namespace ginsu {
@@ -37,6 +39,25 @@ void SceneView::SetProjectionMatrix(const osg::Matrix& matrix) {
   impl_->setProjectionMatrix(matrix);
 }
 
+double SceneView::GetPixelsPerUnit(const osg::BoundingSphere& bound) const {
+  const osg::Viewport* viewport = impl_->getViewport();
+  if (viewport == NULL || !bound.valid())
+    return 0.0;
+  const osg::Matrix& projection = impl_->getProjectionMatrix();
+  double pixels_per_unit = 0.5 * projection(1, 1) * viewport->height();
+  if (projection(3, 3) != 0.0)
+    return pixels_per_unit;  // Orthographic projection.
+
+  // Perspective projection: divide by the depth of the nearest point of the
+  // sphere, but not by less than the near plane distance.
+  double fovy, aspect, z_near, z_far;
+  if (!projection.getPerspective(fovy, aspect, z_near, z_far))
+    return 0.0;
+  osg::Vec3 center = bound.center() * impl_->getViewMatrix();
+  double depth = -center.z() - bound.radius();
+  return pixels_per_unit / std::max(depth, z_near);
+}
+
 void SceneView::SetLookAt(const osg::Vec3& eye,
                           const osg::Vec3& target,
                           const osg::Vec3& up) {
@@ -5,6 +5,7 @@
 #ifndef GINSU_VIEW_SCENE_VIEW_H_
 #define GINSU_VIEW_SCENE_VIEW_H_
 
+#include "osg/BoundingSphere"
 #include "osg/Matrix"
 #include "osg/ref_ptr"
 #include "osg/Timer"
@@ -31,6 +32,11 @@ class SceneView {
   void SetProjectionMatrix(const osg::Matrix& matrix);
   void Draw();
 
+  // Approximate length in pixels, on the viewport, of a unit length at the
+  // nearest point of the given world-space sphere. Returns 0 if the viewport
+  // is not set yet.
+  double GetPixelsPerUnit(const osg::BoundingSphere& bound) const;
+
   // TODO(alokp): Remove this.
   void SetLookAt(const osg::Vec3& eye,
                  const osg::Vec3& target,
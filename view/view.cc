@@ -68,7 +68,7 @@ printf("View::ResizeViewport\n");
 
 void View::RenderOpenGL(const c_salt::OpenGLContext& context) {
 printf("View::RenderOpenGL\n");
-  scene_->Update();
+  scene_->Update(scene_view_.get());
   scene_view_->Draw();
 }
 